@@ -0,0 +1,328 @@
+/* Set container, hash table with closed hashing and linear probing.
+ *
+ * This is closed_linear_probing_hash_table without values: the tables only
+ * hold the meta-data and the keys, so sets take less memory, and move less
+ * data around on rehashes, than a table mapping keys to dummy values.
+ *
+ * See closed_linear_probing_hash_table.h for the erase and shrink policies.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_CLOSED_LINEAR_PROBING_HASH_SET_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_CLOSED_LINEAR_PROBING_HASH_SET_H_GUARD 1
+
+#include <iterator>   // For std::iterator<>
+#include "common.h"
+#include "closed_linear_probing_hash_table.h"
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     closed_linear_probing_hash_set<K,
+ *                                    hash_functor  = std::hash<K>, // C++11
+ *                                    erase_policy  = erase_policy_rehash,
+ *                                    default_size  = 32,
+ *                                    allocator     = table_allocator<char>,
+ *                                    shrink_policy = shrink_policy_never,
+ *                                    key_equal     = equal_to,
+ *                                    inline_storage_policy = inline_storage_policy_unused
+ *                                    >
+ *
+ * Objects of this class are sets of unique objects of type <K>, using the
+ * hash function <hash_functor>.
+ *
+ * The template parameters are the same as closed_linear_probing_hash_table's.
+ */
+template <typename K,
+#if __cplusplus >= 201103L
+          typename hash_functor = std::hash<K>,
+#else
+          typename hash_functor,
+#endif
+          class  erase_policy = erase_policy_rehash,
+          size_t default_size = 32, /* must be power of 2, or 0 */
+          typename allocator = table_allocator<char>,
+          class  shrink_policy = shrink_policy_never,
+          typename key_equal = equal_to,
+          class  inline_storage_policy = inline_storage_policy_unused
+          >
+class closed_linear_probing_hash_set {
+
+    typedef closed_linear_probing_hash_table<K, internal::no_value_t, hash_functor, erase_policy,
+                                             default_size, allocator, shrink_policy, key_equal,
+                                             inline_storage_policy> table_t;
+
+    table_t table;
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor.
+     */
+    HASH_CONTAINERS_INLINE
+    closed_linear_probing_hash_set() { }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit closed_linear_probing_hash_set(const allocator_type &alloc) : table(alloc) { }
+
+
+
+    /* Constructs an empty container, which will hash keys with (a copy of)
+     * <hash>, compare them with (a copy of) <equal>, and allocate memory
+     * through (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit closed_linear_probing_hash_set(const hash_functor   &hash,
+                                            const key_equal      &equal = key_equal(),
+                                            const allocator_type &alloc = allocator_type())
+        : table(hash, equal, alloc) { }
+
+
+
+    /* Inserts a key in the set. If the key is already present, then 'false'
+     * is returned and the container is not modified.
+     *
+     * Iterators should be assumed to be invalid after insert(), if it
+     * returns 'true'.
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(const K &key) {
+        return this->table.insert(key, internal::no_value_t());
+    }
+
+
+
+    /* Erases a key from the set, if present.
+     *
+     * Iterators to other keys are still valid after erase(), unless the
+     * shrink policy resized the table.
+     */
+    HASH_CONTAINERS_INLINE
+    void erase(const K &key) {
+        this->table.erase(key);
+    }
+
+
+
+    /* Returns 1 if the key is in the set, 0 otherwise. */
+    HASH_CONTAINERS_INLINE
+    size_t count(const K &key) const {
+        return this->table.count(key);
+    }
+
+
+
+    /* Checks whether the key is in the set. */
+    HASH_CONTAINERS_INLINE
+    bool contains(const K &key) const {
+        return this->table.count(key) != 0;
+    }
+
+
+
+    /* Returns the number of keys in the set. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->table.size();
+    }
+
+
+
+    /* Returns the number of keys that could potentially be stored in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t capacity() const {
+        return this->table.capacity();
+    }
+
+
+
+    /* Returns a copy of the allocator of the container. */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return this->table.get_allocator();
+    }
+
+
+
+    /* See closed_linear_probing_hash_table::reserve(). */
+    void reserve(size_t new_capacity) {
+        this->table.reserve(new_capacity);
+    }
+
+
+
+    /* See closed_linear_probing_hash_table::rehash(). */
+    void rehash(size_t new_capacity) {
+        this->table.rehash(new_capacity);
+    }
+
+
+
+    /* See closed_linear_probing_hash_table::shrink_to_fit(). */
+    void shrink_to_fit() {
+        this->table.shrink_to_fit();
+    }
+
+
+
+    /* Clears the content of the container. The capacity of the container is
+     * unchanged.
+     */
+    HASH_CONTAINERS_INLINE
+    void clear() {
+        this->table.clear();
+    }
+
+
+
+    /*******************************************************************
+     * Iterator interface
+     *******************************************************************/
+
+    /* Constant Iterator for the container. Keys can't be modified in place,
+     * so there is no mutable iterator.
+     */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, K, ptrdiff_t, const K*, const K&> {
+
+        friend class closed_linear_probing_hash_set;
+
+        typename table_t::const_iterator it;
+
+        const_iterator(const typename table_t::const_iterator &it) : it(it) { }
+
+    public:
+        const_iterator(const const_iterator& other) : it(other.it) { }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return this->it == other.it;
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return this->it != other.it;
+        }
+
+
+
+        const_iterator& operator=(const const_iterator &other) {
+            this->it = other.it;
+            return *this;
+        }
+
+
+
+        const K &operator*() const {
+            typename table_t::const_iterator it(this->it);
+            return (*it).first.get();
+        }
+
+
+
+        const K *operator->() const {
+            return internal::addressof(**this);
+        }
+
+
+
+        const_iterator &operator++() {
+            ++this->it;
+            return *this;
+        }
+
+
+
+        const_iterator operator++(int) {
+            const const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+    typedef const_iterator iterator;
+
+
+
+    /* Returns a constant iterator to the first key in the container. */
+    HASH_CONTAINERS_INLINE
+    const_iterator begin() const {
+        return const_iterator(this->table.cbegin());
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    const_iterator cbegin() const {
+        return const_iterator(this->table.cbegin());
+    }
+
+
+
+    /* Returns a constant iterator to one past the last key in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator end() const {
+        return const_iterator(this->table.cend());
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    const_iterator cend() const {
+        return const_iterator(this->table.cend());
+    }
+
+
+
+    /* Finds a key in the container.
+     *
+     * Returns:
+     *     A constant iterator to the key in the container. cend() is
+     *     returned if the key is not present.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const K& key) const {
+        return const_iterator(this->table.find(key));
+    }
+
+}; // class closed_linear_probing_hash_set
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_CLOSED_LINEAR_PROBING_HASH_SET_H_GUARD */
+
@@ -28,6 +28,12 @@
  *      copy ctor or assignment operators (e.g. complex types), or slow key
  *      hash functions (e.g. hash on long strings).
  *
+ *   3- erase_policy_empty_key<K, EMPTY_KEY, DELETED_KEY>
+ *      For integer and pointer keys. Reserves one key value to mark empty
+ *      slots (and optionally one to mark deleted ones), so there is no
+ *      meta-data array at all: probes only touch the key array. Tables take
+ *      less memory, and each probe one cache line access less.
+ *
  * https://github.com/rohannessian/hash_containers/
  *
  * Copyright (c) 2016, 2017 Robert Jr Ohannessian
@@ -66,12 +72,18 @@
 namespace hash_containers {
 
 struct erase_policy_rehash;
+struct shrink_policy_never;
+struct inline_storage_policy_unused;
 
 /* Class: 
  *     closed_linear_probing_hash_table<K, V,
  *                                      hash_functor = std::hash<K>, // C++11
  *                                      erase_policy = erase_policy_rehash,
- *                                      default_size = 32
+ *                                      default_size = 32,
+ *                                      allocator    = table_allocator<char>,
+ *                                      shrink_policy = shrink_policy_never,
+ *                                      key_equal    = equal_to,
+ *                                      inline_storage_policy = inline_storage_policy_unused
  *                                      >
  *  
  * Objects of this class are associative containers mapping objects of type 
@@ -81,9 +93,32 @@ struct erase_policy_rehash;
  *    <K>           : the type of the key of the associative container.
  *    <V>           : the type of the value of the associative container.
  *    <hash_functor>: a functor that will hash the key to a size_t. Default
- *                    value is only provided in C++11.
+ *                    value is only provided in C++11. It is stored in the
+ *                    container, so it can hold state such as a seed (see
+ *                    seeded_hash<>); empty functors take no space. Const
+ *                    lookups hash with a copy of it if its operator() isn't
+ *                    const (always in C++98). In
+ *                    C++11, if it and
+ *                    <key_equal> declare an is_transparent member type,
+ *                    find(), count(), erase(), operator[], try_emplace()
+ *                    and insert() also take keys of other types, such as
+ *                    std::string_view for std::string keys, hashed and
+ *                    compared to K as is.
  *    <erase_policy>: the policy to use on erase().
- *    <default_size>: the default size of the container.
+ *    <default_size>: the default size of the container. Tables of up to that
+ *                    many elements are stored inside the container object
+ *                    itself. With 0, there is no such inline storage: empty
+ *                    containers share a static, read-only empty table, and
+ *                    only allocate memory on the first insertion.
+ *    <allocator>   : the allocator used for the table's memory block. It is
+ *                    rebound to char.
+ *    <shrink_policy>: whether erase() shrinks sparse tables.
+ *    <key_equal>   : a functor comparing two keys, for equality. The
+ *                    default compares them with operator==. Empty functors
+ *                    take no space in the container.
+ *    <inline_storage_policy>: what the inline storage is used for, once the
+ *                    table has grown past <default_size> and moved to the
+ *                    heap.
  */
 template <typename K,
           typename V,
@@ -93,7 +128,11 @@ template <typename K,
           typename hash_functor,
 #endif
           class  erase_policy = erase_policy_rehash,
-          size_t default_size = 32 /* must be power of 2, and > 0 */
+          size_t default_size = 32, /* must be power of 2, or 0 */
+          typename allocator = table_allocator<char>,
+          class  shrink_policy = shrink_policy_never,
+          typename key_equal = equal_to,
+          class  inline_storage_policy = inline_storage_policy_unused
           >
 class closed_linear_probing_hash_table;
 
@@ -113,11 +152,13 @@ struct erase_policy_rehash {
     static const unsigned INVALID                = 0;
     static const unsigned VALID                  = 1;
     static const unsigned DEFAULT_META_VALUE     = 0; // Must be INVALID replicated to all bits
+    static const bool     USES_META              = true;
+    static const bool     SHIFTS_ON_ERASE        = true;  // erase() moves elements back into the hole
 
     template <typename K, typename V, typename hash_functor>
     HASH_CONTAINERS_INLINE
     static void do_erase(size_t orig_idx, meta_t *valid, size_t capacity_minus_1,
-                      K* key_table, V* value_table, const hash_functor &/*hash_func*/) {
+                      K* key_table, V* value_table, hash_functor &hash_func) {
 
         /* Rehash the contiguous span of entries from the point of deletion.
          * See https://en.wikipedia.org/wiki/Open_addressing for details.
@@ -151,16 +192,14 @@ struct erase_policy_rehash {
             }
 
             // Otherwise, we need to rehash that entry
-            const size_t key2 = hash_functor()(key_table[idx2]) & capacity_minus_1;
+            const size_t key2 = hash_func(key_table[idx2]) & capacity_minus_1;
 
             if ((idx <= idx2) ? ((idx < key2) && (key2 <= idx2)) : ((idx < key2) || (key2 <= idx2))) {
                 goto next_entry;
             }
 
-            internal::construct(&key_table  [idx ], key_table  [idx2]);
-            internal::construct(&value_table[idx ], value_table[idx2]);
-            internal::destroy(  &key_table  [idx2]);
-            internal::destroy(  &value_table[idx2]);
+            internal::relocate(&key_table  [idx ], key_table  [idx2]);
+            internal::relocate(&value_table[idx ], value_table[idx2]);
 
             valid[word] |= (((meta_t(1) << META_BITS_PER_ELEMENT) - 1) << (META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1))));
 
@@ -241,11 +280,13 @@ struct erase_policy_use_marker {
     static const unsigned META_ELEMENTS_PER_WORD = META_BITS_PER_WORD / META_BITS_PER_ELEMENT; // Must be power of 2. static_assert?
 
     static const unsigned DEFAULT_META_VALUE = 0;
+    static const bool     USES_META          = true;
+    static const bool     SHIFTS_ON_ERASE    = false; // erase() leaves a marker
 
     template <typename K, typename V, typename hash_functor>
     static HASH_CONTAINERS_INLINE 
     void do_erase(size_t idx, meta_t *valid, size_t /*capacity_minus_1*/,
-                      K* /*key_table*/, V* /*value_table*/, const hash_functor &/*hash_func*/) {
+                      K* /*key_table*/, V* /*value_table*/, hash_functor &/*hash_func*/) {
             
         const size_t word = idx / META_ELEMENTS_PER_WORD;
         valid[word] = (valid[word] & ~(((meta_t(1) << META_BITS_PER_ELEMENT) - 1) << (META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1)))))
@@ -310,8 +351,315 @@ struct erase_policy_use_marker {
 };
 
 
+
+/* Marks the state of the slots with reserved key values instead of a
+ * meta-data array, like Google's dense_hash_map: slots holding <EMPTY_KEY>
+ * are empty. Probes then only touch the key array, and tables take less
+ * memory.
+ *
+ * If <DELETED_KEY> differs from <EMPTY_KEY>, erase() overwrites the key with
+ * <DELETED_KEY> (like erase_policy_use_marker). Otherwise, erase() rehashes
+ * the following elements (like erase_policy_rehash).
+ *
+ * The reserved keys can't be inserted in the container. Keys must be
+ * integers or pointers: all the key slots of a table always hold a key,
+ * which is copied around without being constructed or destroyed.
+ */
+template <typename K, K EMPTY_KEY = K(~K(0)), K DELETED_KEY = EMPTY_KEY>
+struct erase_policy_empty_key {
+
+    /* There is no meta-data; the parameters only keep the rest of the code
+     * compiling.
+     */
+    typedef uint32_t meta_t;
+
+    static const unsigned META_BITS_PER_ELEMENT  = 1;
+    static const unsigned META_BITS_PER_WORD     = sizeof(meta_t) * CHAR_BIT;
+    static const unsigned META_ELEMENTS_PER_WORD = META_BITS_PER_WORD / META_BITS_PER_ELEMENT;
+    static const unsigned INVALID                = 0;
+    static const unsigned VALID                  = 1;
+    static const unsigned DEFAULT_META_VALUE     = 0;
+    static const bool     USES_META              = false;
+    static const bool     SHIFTS_ON_ERASE        = (DELETED_KEY == EMPTY_KEY);
+
+    /* Key table of the shared empty table. It is never written to. */
+    static const K empty_table_keys[1];
+
+
+    /* Checks whether a slot holding <key> is empty (as opposed to in use or
+     * deleted).
+     */
+    static HASH_CONTAINERS_INLINE
+    bool is_empty(const K &key) {
+        return key == EMPTY_KEY;
+    }
+
+
+
+    /* Checks whether a slot holding <key> is in use. */
+    static HASH_CONTAINERS_INLINE
+    bool is_valid(const K &key) {
+        return key != EMPTY_KEY && key != DELETED_KEY;
+    }
+
+
+
+    /* Marks all the slots of a key table as empty. */
+    static HASH_CONTAINERS_INLINE
+    void init_keys(K *key_table, size_t capacity) {
+        for (size_t i = 0; i < capacity; i++) {
+            key_table[i] = EMPTY_KEY;
+        }
+    }
+
+
+
+    template <typename V, typename hash_functor>
+    static HASH_CONTAINERS_INLINE
+    void do_erase(size_t orig_idx, meta_t * /*valid*/, size_t capacity_minus_1,
+                  K* key_table, V* value_table, hash_functor &hash_func) {
+
+        if (DELETED_KEY != EMPTY_KEY) {
+            key_table[orig_idx] = DELETED_KEY;
+            return;
+        }
+
+        /* Rehash the contiguous span of entries from the point of deletion,
+         * as erase_policy_rehash does.
+         */
+        size_t idx  = orig_idx;
+        size_t idx2 = orig_idx;
+
+        while (true) {
+
+            // Mark current entry as empty
+            key_table[idx] = EMPTY_KEY;
+
+            // Move to next entry
+        next_entry:
+            idx2 = (idx2 + 1) & capacity_minus_1;
+
+            // If entry is empty, then we can stop
+            if (key_table[idx2] == EMPTY_KEY) {
+                break;
+            }
+
+            // Otherwise, we need to rehash that entry
+            const size_t key2 = hash_func(key_table[idx2]) & capacity_minus_1;
+
+            if ((idx <= idx2) ? ((idx < key2) && (key2 <= idx2)) : ((idx < key2) || (key2 <= idx2))) {
+                goto next_entry;
+            }
+
+            key_table[idx] = key_table[idx2];
+            internal::relocate(&value_table[idx ], value_table[idx2]);
+
+            idx = idx2;
+        }
+    }
+
+
+
+    /* For forward iterating: returns the first slot in use at or after
+     * <pos>, or ~0 if there are none.
+     */
+    static HASH_CONTAINERS_INLINE
+    size_t get_next_from(size_t pos, size_t capacity_minus_1, const K *key_table) {
+        for (; pos <= capacity_minus_1; pos++) {
+            if (is_valid(key_table[pos])) {
+                return pos;
+            }
+        }
+        return ~size_t(0);
+    }
+};
+
+template <typename K, K EMPTY_KEY, K DELETED_KEY>
+const K erase_policy_empty_key<K, EMPTY_KEY, DELETED_KEY>::empty_table_keys[1] = { EMPTY_KEY };
+
+
+/***************************************************************************
+ * Shrink policies
+ *
+ * Tables grow when more than half full (on a collision). A shrink policy
+ * decides whether erase() gives memory back when the table becomes sparse.
+ */
+
+struct shrink_policy_never {
+
+    /* Tables are never shrunk by erase(). Memory is only given back by
+     * shrink_to_fit() and rehash().
+     */
+    HASH_CONTAINERS_INLINE
+    static bool should_shrink(size_t /*size*/, size_t /*capacity*/) {
+        return false;
+    }
+};
+
+
+
+/* Shrinks the table on erase() once fewer than 1/<min_load_divisor> of the
+ * slots are in use. The table is resized for a load of 1/4 (rounded to a
+ * power of 2), possibly back into the container's inline storage. The gap
+ * between both thresholds keeps the table from repeatedly growing and
+ * shrinking.
+ *
+ * Note that with this policy, erase() can invalidate iterators.
+ */
+template <size_t min_load_divisor = 8>
+struct shrink_policy_hysteresis {
+
+    /* Compile-time check that the divisor is at least 4. Tables are shrunk
+     * for a load of 1/4, so smaller divisors would ask for "shrinking" to a
+     * larger table. From 4 up, a shrunk table can still be below the
+     * threshold, but shrink_table() then finds nothing smaller to move to
+     * and leaves it alone, so tables don't oscillate.
+     */
+    typedef char min_load_divisor_check_t[(min_load_divisor >= 4) ? 1 : -1];
+
+    HASH_CONTAINERS_INLINE
+    static bool should_shrink(size_t size, size_t capacity) {
+        return size * min_load_divisor < capacity;
+    }
+};
+
+
+/***************************************************************************
+ * Inline storage policies
+ *
+ * Once a table has grown past <default_size>, it lives in the heap and the
+ * container's inline storage is no longer needed for it. An inline storage
+ * policy decides whether that storage is put to use.
+ */
+
+struct inline_storage_policy_unused {
+
+    /* The inline storage is left unused while the table is in the heap. */
+    static const bool REUSE_FOR_META = false;
+};
+
+
+
+/* The meta-data (valid bits) of heap tables is kept in the inline storage,
+ * when it fits, right next to the container's other fields. This saves a
+ * cache miss on lookups in tables that have just outgrown <default_size>.
+ * Containers with a <default_size> of 0 have no inline storage, and are not
+ * affected.
+ */
+struct inline_storage_policy_reuse_for_meta {
+
+    static const bool REUSE_FOR_META = true;
+};
+
+
+
 namespace internal {
 
+    /* Value type of the tables backing sets. Tables don't allocate a value
+     * array for it: its "array" aliases the key array, which is safe because
+     * constructing, copying or destroying a no_value_t touches no memory.
+     */
+    struct no_value_t {
+        no_value_t() {}
+        no_value_t(const no_value_t &) {}
+        no_value_t &operator=(const no_value_t &) { return *this; }
+    };
+
+
+
+    /* Describes the storage of the value array of a table. */
+    template <typename K, typename V>
+    struct value_array_t {
+
+        /* Whether the array takes any memory */
+        static const bool HAS_STORAGE = true;
+
+        /* Returns the size, in bytes, of the value array of <capacity>
+         * elements.
+         */
+        static HASH_CONTAINERS_INLINE
+        size_t get_size(size_t capacity) {
+            return sizeof(V) * capacity;
+        }
+
+        /* Returns the value array stored at <memory>. */
+        static HASH_CONTAINERS_INLINE
+        V *get_array(char *memory, K * /*key_table*/) {
+            return reinterpret_cast<V*>(memory);
+        }
+
+        /* Storage of a value array of <n> elements inside the container.
+         * The union only serves to align the array.
+         */
+        template <size_t n>
+        struct inline_storage_t {
+            union {
+                char                  bytes[n * sizeof(V)];
+                internal::max_align_t align;
+            } u;
+
+            HASH_CONTAINERS_INLINE char *get_bytes() { return &this->u.bytes[0]; }
+        };
+    };
+
+
+
+    template <typename K>
+    struct value_array_t<K, no_value_t> {
+
+        static const bool HAS_STORAGE = false;
+
+        static HASH_CONTAINERS_INLINE
+        size_t get_size(size_t /*capacity*/) {
+            return 0;
+        }
+
+        static HASH_CONTAINERS_INLINE
+        no_value_t *get_array(char * /*memory*/, K *key_table) {
+            return reinterpret_cast<no_value_t*>(key_table);
+        }
+
+        template <size_t n>
+        struct inline_storage_t {
+            HASH_CONTAINERS_INLINE char *get_bytes() { return NULL; }
+        };
+    };
+
+
+
+    /* Key tables are left unconstructed when the erase policy keeps a
+     * meta-data array. Otherwise, all the slots are marked as empty by the
+     * policy.
+     */
+    template <typename erase_policy, typename K>
+    HASH_CONTAINERS_INLINE
+    void init_key_table(K * /*key_table*/, size_t /*capacity*/, bool_tag<true> /*uses_meta*/) { }
+
+    template <typename erase_policy, typename K>
+    HASH_CONTAINERS_INLINE
+    void init_key_table(K *key_table, size_t capacity, bool_tag<false> /*uses_meta*/) {
+        erase_policy::init_keys(key_table, capacity);
+    }
+
+
+
+    /* Returns the key table of the shared empty table: none with a meta-data
+     * array, since the meta-data marks its only slot as invalid.
+     */
+    template <typename erase_policy, typename K>
+    HASH_CONTAINERS_INLINE
+    K *get_empty_table_keys(bool_tag<true> /*uses_meta*/) {
+        return NULL;
+    }
+
+    template <typename erase_policy, typename K>
+    HASH_CONTAINERS_INLINE
+    K *get_empty_table_keys(bool_tag<false> /*uses_meta*/) {
+        return const_cast<K*>(&erase_policy::empty_table_keys[0]);
+    }
+
+
+
     template <typename K, typename V, typename erase_policy>
     struct closed_linear_probing_hash_table_data_t {
 
@@ -320,22 +668,58 @@ namespace internal {
          *
          * Valid array is an array of bits, for tight packing.
          *
-         * Those arrays are indexed by the hash.
+         * Those arrays are indexed by the hash. When allocated on the heap,
+         * each array starts on a cache line boundary, so that a probe
+         * sequence touches as few lines as possible.
          */
         K                             *key_table;
         V                             *value_table;
         typename erase_policy::meta_t *valid;
         size_t                         size;
         size_t                         capacity_minus_1;
+        char                          *memory;  // Heap block holding the arrays, or NULL
 
 
         closed_linear_probing_hash_table_data_t() :
                    key_table(NULL), value_table(NULL), valid(NULL), size(0),
-                   capacity_minus_1(0) {}
+                   capacity_minus_1(0), memory(NULL) {}
+
+
+        /* Returns the size, in bytes, of the meta-data array of <capacity>
+         * elements. Some erase policies don't have one.
+         */
+        static HASH_CONTAINERS_INLINE
+        size_t get_meta_size(size_t capacity) {
+            if (!erase_policy::USES_META) {
+                return 0;
+            }
+            return (capacity + erase_policy::META_ELEMENTS_PER_WORD - 1) / erase_policy::META_ELEMENTS_PER_WORD * sizeof(typename erase_policy::meta_t);
+        }
+
 
+        /* Returns the size, in bytes, of the single memory block holding the
+         * meta-data, key and value arrays of a table of <capacity> elements.
+         */
+        static HASH_CONTAINERS_INLINE
+        size_t get_memory_size(size_t capacity) {
+            const size_t meta_size    = get_meta_size(capacity);
+            const size_t K_size       = sizeof(K) * capacity;
+            const size_t V_size       = value_array_t<K, V>::get_size(capacity);
+            const size_t padding_size = HASH_CONTAINERS_CACHE_LINE_SIZE - 1; // To align the start of the block
+
+            return internal::round_up_to_cache_line(meta_size)
+                 + internal::round_up_to_cache_line(K_size)
+                 + V_size + padding_size;
+        }
 
+
+        /* Allocates the arrays of a table of <capacity> elements, through
+         * <alloc>. The arrays are initialized as empty, unless <init_tables>
+         * is false: the caller then fills all of them.
+         */
+        template <typename A>
         HASH_CONTAINERS_NO_INLINE
-        closed_linear_probing_hash_table_data_t(size_t capacity) {
+        closed_linear_probing_hash_table_data_t(size_t capacity, A &alloc, bool init_tables = true) {
 
             assert(capacity > 0);
             assert((capacity & (capacity - 1)) == 0);
@@ -344,8 +728,9 @@ namespace internal {
             this->key_table   = NULL;
             this->value_table = NULL;
             this->valid       = NULL;
+            this->memory      = NULL;
 
-            // free() is implemented in the caller
+            // free_memory() is called by the owner
 
             // Allocate memory as just a single block, and then subdivide as needed.
             /*
@@ -353,29 +738,135 @@ namespace internal {
             this->value_table = new V[capacity];
             this->valid       = new meta_t[(capacity + META_ELEMENTS_PER_WORD - 1) / META_ELEMENTS_PER_WORD];
             */
-            const size_t meta_size    = (capacity + erase_policy::META_ELEMENTS_PER_WORD - 1) / erase_policy::META_ELEMENTS_PER_WORD * sizeof(typename erase_policy::meta_t);
+            const size_t meta_size    = get_meta_size(capacity);
             const size_t K_size       = sizeof(K) * capacity;
-            const size_t V_size       = sizeof(V) * capacity;
-            const size_t padding_size = sizeof(K) + sizeof(V) + sizeof(typename erase_policy::meta_t); // Padding for type alignment
+            const size_t memory_size  = get_memory_size(capacity);
+
+            // If the OS can hand us zeroed pages lazily, don't touch the
+            // meta-data up front.
+            const bool lazy_zero = init_tables && erase_policy::USES_META && (erase_policy::DEFAULT_META_VALUE == 0) && internal::is_block_lazily_zeroed(alloc, memory_size);
+
+            // Allocators only guarantee alignment for fundamental types, so
+            // align the arrays ourselves. This works with any allocator, and
+            // keeps lazily zeroed memory from calloc() or mmap().
+            this->memory = internal::allocate_block(alloc, memory_size, lazy_zero);
+            assert(this->memory);
 
-            // Note: malloc() is guaranteed to properly align the allocation for any
-            // valid object.
-            char *memory = (char*)malloc(meta_size + K_size + V_size + padding_size);
-            assert(memory);
+            char *base = internal::align_to_cache_line(this->memory);
 
-            const size_t K_offs =       meta_size +  meta_size        % sizeof(K);
-            const size_t V_offs = K_offs + K_size + (K_offs + K_size) % sizeof(V);
+            const size_t K_offs =          internal::round_up_to_cache_line(meta_size);
+            const size_t V_offs = K_offs + internal::round_up_to_cache_line(K_size);
 
-            this->valid       = reinterpret_cast<typename erase_policy::meta_t*>(memory);
-            this->key_table   = reinterpret_cast<K*>(memory + K_offs);
-            this->value_table = reinterpret_cast<V*>(memory + V_offs);
+            this->valid       = reinterpret_cast<typename erase_policy::meta_t*>(base);
+            this->key_table   = reinterpret_cast<K*>(base + K_offs);
+            this->value_table = value_array_t<K, V>::get_array(base + V_offs, this->key_table);
 
-            memset(this->valid, erase_policy::DEFAULT_META_VALUE, ((capacity + erase_policy::META_ELEMENTS_PER_WORD - 1) / erase_policy::META_ELEMENTS_PER_WORD) * sizeof(typename erase_policy::meta_t));
+            if (init_tables) {
+                if (!lazy_zero) {
+                    memset(this->valid, erase_policy::DEFAULT_META_VALUE, meta_size);
+                }
+                init_key_table<erase_policy>(this->key_table, capacity, bool_tag<erase_policy::USES_META>());
+            }
 
             this->size = 0;
             this->capacity_minus_1 = capacity - 1;
         }
+
+
+        /* Releases the memory block allocated by the capacity constructor,
+         * through the same allocator. Elements must already have been
+         * destroyed.
+         */
+        template <typename A>
+        HASH_CONTAINERS_INLINE
+        void free_memory(A &alloc) {
+            internal::deallocate_block(alloc, this->memory, get_memory_size(this->capacity_minus_1 + 1));
+        }
+
+
+
+        /* Checks whether the meta-data array is in the heap memory block (as
+         * opposed to the container's inline storage).
+         */
+        HASH_CONTAINERS_INLINE
+        bool is_meta_in_memory() const {
+            return this->memory && this->valid == this->get_meta_in_memory();
+        }
+
+
+
+        /* Returns the location of the meta-data array in the heap memory
+         * block.
+         */
+        HASH_CONTAINERS_INLINE
+        typename erase_policy::meta_t *get_meta_in_memory() const {
+            return reinterpret_cast<typename erase_policy::meta_t*>(internal::align_to_cache_line(this->memory));
+        }
+    };
+
+
+
+    /* Storage of the tables of small containers, inside the container object
+     * itself, to avoid allocating memory.
+     *
+     * The unions only serve to align the key and value arrays.
+     */
+    template <typename K, typename V, typename erase_policy, size_t default_size>
+    struct closed_linear_probing_hash_table_inline_t {
+
+        typedef typename erase_policy::meta_t meta_t;
+
+        meta_t default_valid[(default_size + erase_policy::META_ELEMENTS_PER_WORD - 1) / erase_policy::META_ELEMENTS_PER_WORD];
+        union {
+            char                  bytes[default_size * sizeof(K)];
+            internal::max_align_t align;
+        } default_key_table;
+        typename value_array_t<K, V>::template inline_storage_t<default_size> default_val_table;
+
+        HASH_CONTAINERS_INLINE meta_t *get_default_valid()       { return &this->default_valid[0]; }
+        HASH_CONTAINERS_INLINE K      *get_default_key_table()   { return reinterpret_cast<K*>(&this->default_key_table.bytes[0]); }
+        HASH_CONTAINERS_INLINE V      *get_default_val_table()   { return value_array_t<K, V>::get_array(this->default_val_table.get_bytes(), this->get_default_key_table()); }
+        HASH_CONTAINERS_INLINE size_t  get_default_valid_size()  { return sizeof(this->default_valid); }
+
+        /* The whole storage, seen as an array of meta-data words. It holds
+         * the meta-data of larger tables once the container has moved to the
+         * heap, with inline_storage_policy_reuse_for_meta.
+         */
+        HASH_CONTAINERS_INLINE meta_t *get_inline_buffer()       { return reinterpret_cast<meta_t*>(this); }
+        HASH_CONTAINERS_INLINE size_t  get_inline_buffer_words() { return sizeof(*this) / sizeof(meta_t); }
+    };
+
+
+
+    /* No inline storage: the container always uses the heap, or the shared
+     * empty table.
+     */
+    template <typename K, typename V, typename erase_policy>
+    struct closed_linear_probing_hash_table_inline_t<K, V, erase_policy, 0> {
+
+        typedef typename erase_policy::meta_t meta_t;
+
+        HASH_CONTAINERS_INLINE meta_t *get_default_valid()       { return NULL; }
+        HASH_CONTAINERS_INLINE K      *get_default_key_table()   { return NULL; }
+        HASH_CONTAINERS_INLINE V      *get_default_val_table()   { return NULL; }
+        HASH_CONTAINERS_INLINE size_t  get_default_valid_size()  { return 0; }
+
+        HASH_CONTAINERS_INLINE meta_t *get_inline_buffer()       { return NULL; }
+        HASH_CONTAINERS_INLINE size_t  get_inline_buffer_words() { return 0; }
+    };
+
+
+
+    /* Meta-data of the shared empty table: a single, invalid, element. It is
+     * never written to.
+     */
+    template <typename meta_t>
+    struct empty_table_meta {
+        static const meta_t valid[1];
     };
+
+    template <typename meta_t>
+    const meta_t empty_table_meta<meta_t>::valid[1] = { 0 };
 } // namespace internal
 
 
@@ -386,8 +877,16 @@ template <typename K,
           typename V,
           typename hash_functor,
           class    erase_policy,
-          size_t   default_size>
-class closed_linear_probing_hash_table : private erase_policy {
+          size_t   default_size,
+          typename allocator,
+          class    shrink_policy,
+          typename key_equal,
+          class    inline_storage_policy>
+class closed_linear_probing_hash_table : private erase_policy,
+                                         private internal::ebo_holder<typename internal::rebind_alloc<allocator, char>::type, 0>,
+                                         private internal::ebo_holder<key_equal, 1>,
+                                         private internal::ebo_holder<hash_functor, 2>,
+                                         private internal::closed_linear_probing_hash_table_inline_t<K, V, erase_policy, default_size> {
 
     using typename erase_policy::meta_t;
     using          erase_policy::META_ELEMENTS_PER_WORD;
@@ -396,59 +895,251 @@ class closed_linear_probing_hash_table : private erase_policy {
     using          erase_policy::INVALID;
     using          erase_policy::DEFAULT_META_VALUE;
 
-    /* Default static allocated tables, to avoid malloc() for small tables.
+    typedef typename internal::rebind_alloc<allocator, char>::type char_allocator_t;
+    typedef internal::ebo_holder<char_allocator_t, 0>             allocator_holder_t;
+    typedef internal::ebo_holder<key_equal, 1>                    key_equal_holder_t;
+    typedef internal::ebo_holder<hash_functor, 2>                 hash_functor_holder_t;
+
+    /* Select the code paths for erase policies with or without a meta-data
+     * array, and for elements that need to be destroyed or not.
+     */
+    typedef internal::bool_tag<erase_policy::USES_META> uses_meta_t;
+    typedef internal::bool_tag<internal::is_trivially_destructible<K>::value
+                            && internal::is_trivially_destructible<V>::value> trivially_destructible_t;
+
+    /* Default static allocated tables (inherited), to avoid malloc() for
+     * small tables.
      */
-    char   default_key_table[default_size * sizeof(K)];
-    char   default_val_table[default_size * sizeof(V)];
-    meta_t default_valid[(default_size + erase_policy::META_ELEMENTS_PER_WORD - 1) / erase_policy::META_ELEMENTS_PER_WORD];
+    typedef internal::closed_linear_probing_hash_table_inline_t<K, V, erase_policy, default_size> inline_tables_t;
+
+    /* Capacity of the first table allocated by containers without inline
+     * storage.
+     */
+    static const size_t MIN_HEAP_CAPACITY = 8;
 
 
     internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> data;
 
 
-    /* Increases the size of the hash table
-     *
-     * Iterators are all invalidated.
-     *
-     * Parameters:
-     *     <new_size>: The new size of the table. Must be a power of 2 and 
-     *                 strictly greater than 0.
-     */
-    HASH_CONTAINERS_NO_INLINE
-    void increase_table_size(size_t new_size) {
+    /* Returns the allocator used for the table's memory block. */
+    HASH_CONTAINERS_INLINE
+    char_allocator_t &get_char_allocator() {
+        return static_cast<allocator_holder_t&>(*this).get();
+    }
 
-        assert((new_size & (new_size - 1)) == 0);
-        assert(new_size > 0);
+    HASH_CONTAINERS_INLINE
+    const char_allocator_t &get_char_allocator() const {
+        return static_cast<const allocator_holder_t&>(*this).get();
+    }
 
-        /* Allocate new tables */
-        internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> new_data(new_size);
 
-        /* Rehash valid elements in the existing table */
-        hash_functor hash_func;
 
-        for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
-            size_t hash = hash_func(this->data.key_table[i]);
-            this->add_new(this->data.key_table[i], this->data.value_table[i], new_data, hash);
-            internal::destroy(&this->data.key_table[i]);
-            internal::destroy(&this->data.value_table[i]);
-        }
+    /* Returns the functor comparing keys. */
+    HASH_CONTAINERS_INLINE
+    key_equal &get_key_equal() {
+        return static_cast<key_equal_holder_t&>(*this).get();
+    }
 
-        /* Delete old table and reassign */
-        if (this->data.valid != &default_valid[0]) {
-            /*
-            delete[] this->data.key_table;
-            delete[] this->data.value_table;
-            delete[] this->data.valid;
-            */
-            free(this->data.valid);
+    HASH_CONTAINERS_INLINE
+    const key_equal &get_key_equal() const {
+        return static_cast<const key_equal_holder_t&>(*this).get();
+    }
+
+
+
+    /* Returns the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor &get_hash_functor() {
+        return static_cast<hash_functor_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const hash_functor &get_hash_functor() const {
+        return static_cast<const hash_functor_holder_t&>(*this).get();
+    }
+
+
+
+    /* Points the container at its default static allocated tables, and
+     * empties them. Without inline storage, the container points at the
+     * shared empty table instead.
+     */
+    HASH_CONTAINERS_INLINE
+    void init_default_tables() {
+        assert((default_size & (default_size-1)) == 0);
+        this->data.memory      = NULL;
+        this->data.size        = 0;
+
+        if (!default_size) {
+            this->data.key_table   = internal::get_empty_table_keys<erase_policy, K>(uses_meta_t());
+            this->data.value_table = NULL;
+            this->data.valid       = const_cast<meta_t*>(&internal::empty_table_meta<meta_t>::valid[0]);
+            this->data.capacity_minus_1 = 0;
+            return;
         }
 
-        this->data = new_data;
+        this->data.key_table   = this->get_default_key_table();
+        this->data.value_table = this->get_default_val_table();
+        this->data.valid       = this->get_default_valid();
+        memset(this->data.valid, 0, this->get_default_valid_size());
+        internal::init_key_table<erase_policy>(this->data.key_table, default_size, uses_meta_t());
+        this->data.capacity_minus_1 = default_size - 1;
     }
 
 
 
-    /* Steps to the next index in the table, with wrap-around at the edges.
+    /* Checks whether the container is using the shared empty table. */
+    HASH_CONTAINERS_INLINE
+    bool is_empty_table() const {
+        return !default_size && !this->data.memory;
+    }
+
+
+
+    /* Moves the meta-data of a heap table into the inline storage, when it
+     * fits and the inline storage policy asks for it. The meta-data then
+     * sits right next to the container's other fields, instead of leaving
+     * the inline storage unused.
+     */
+    HASH_CONTAINERS_INLINE
+    void move_meta_to_inline_storage() {
+        if (!inline_storage_policy::REUSE_FOR_META) {
+            return;
+        }
+
+        const size_t meta_words = (this->data.capacity_minus_1 + META_ELEMENTS_PER_WORD) / META_ELEMENTS_PER_WORD;
+
+        if (erase_policy::USES_META && this->data.memory && meta_words <= this->get_inline_buffer_words()) {
+            memcpy(this->get_inline_buffer(), this->data.valid, meta_words * sizeof(meta_t));
+            this->data.valid = this->get_inline_buffer();
+        }
+    }
+
+
+
+    /* Moves the meta-data of a heap table back to its spot in the heap
+     * block, if move_meta_to_inline_storage() moved it to the inline
+     * storage, so that the storage can be reused or the block handed over.
+     */
+    HASH_CONTAINERS_INLINE
+    void move_meta_to_memory() {
+        if (this->data.memory && !this->data.is_meta_in_memory()) {
+            meta_t *meta_in_memory = this->data.get_meta_in_memory();
+            memcpy(meta_in_memory, this->data.valid, ((this->data.capacity_minus_1 + META_ELEMENTS_PER_WORD) / META_ELEMENTS_PER_WORD) * sizeof(meta_t));
+            this->data.valid = meta_in_memory;
+        }
+    }
+
+
+    /* Returns the smallest capacity that can hold <size> elements without
+     * exceeding the maximum load factor.
+     */
+    static HASH_CONTAINERS_INLINE
+    size_t get_min_capacity(size_t size) {
+        return size ? internal::round_up_to_next_power_of_2(size * 2) : 1;
+    }
+
+
+
+    /* Changes the size of the hash table. Tables of up to <default_size>
+     * elements are moved into the inline storage.
+     *
+     * Iterators are all invalidated.
+     *
+     * Parameters:
+     *     <new_size>: The new size of the table. Must be a power of 2, 
+     *                 strictly greater than 0, and large enough for all the
+     *                 elements (see get_min_capacity()).
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void resize_table(size_t new_size) {
+
+        assert((new_size & (new_size - 1)) == 0);
+        assert(new_size > 0);
+        assert(new_size >= get_min_capacity(this->data.size));
+
+        /* Allocate new tables */
+        internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> new_data;
+
+        if (new_size <= default_size) {
+            if (!this->data.memory) {
+                return; // Already in the inline storage
+            }
+
+            // The inline storage may be holding the meta-data
+            this->move_meta_to_memory();
+
+            new_data.key_table   = this->get_default_key_table();
+            new_data.value_table = this->get_default_val_table();
+            new_data.valid       = this->get_default_valid();
+            memset(new_data.valid, 0, this->get_default_valid_size());
+            internal::init_key_table<erase_policy>(new_data.key_table, default_size, uses_meta_t());
+            new_data.capacity_minus_1 = default_size - 1;
+        }
+        else {
+            new_data = internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy>(new_size, this->get_char_allocator());
+        }
+
+        /* Rehash valid elements in the existing table */
+        hash_functor &hash_func = this->get_hash_functor();
+
+        for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
+            size_t hash = hash_func(this->data.key_table[i]);
+            const size_t new_idx = this->add_slot(this->data.key_table[i], new_data, hash);
+            internal::relocate(&new_data.key_table[new_idx],   this->data.key_table[i]);
+            internal::relocate(&new_data.value_table[new_idx], this->data.value_table[i]);
+        }
+
+        /* Delete old table and reassign */
+        if (this->data.memory) {
+            /*
+            delete[] this->data.key_table;
+            delete[] this->data.value_table;
+            delete[] this->data.valid;
+            */
+            this->data.free_memory(this->get_char_allocator());
+        }
+
+        this->data = new_data;
+        this->move_meta_to_inline_storage();
+    }
+
+
+
+    /* Reduces the size of the hash table to <new_size>, if smaller than the
+     * current capacity. Empty tables without inline storage go back to the
+     * shared empty table.
+     *
+     * Iterators are all invalidated if the table is resized.
+     *
+     * Parameters:
+     *     <new_size>: The new size of the table. Must be a power of 2, 
+     *                 strictly greater than 0, and large enough for all the
+     *                 elements (see get_min_capacity()).
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void shrink_table(size_t new_size) {
+
+        if (!default_size && !this->data.size) {
+            if (this->data.memory) {
+                this->data.free_memory(this->get_char_allocator());
+            }
+            this->init_default_tables();
+            return;
+        }
+
+        if (new_size > default_size && new_size < MIN_HEAP_CAPACITY) {
+            new_size = MIN_HEAP_CAPACITY;
+        }
+
+        if (new_size < this->capacity()) {
+            this->resize_table(new_size);
+        }
+    }
+
+
+
+    /* Steps to the next index in the table, with wrap-around at the edges.
      *
      * Parameters:
      *     <META_T>   : Metadata type. Template parameter so it can const or 
@@ -495,7 +1186,9 @@ class closed_linear_probing_hash_table : private erase_policy {
      *     <valid>: (out) Set to true if the returned position is of a valid 
      *              element (i.e. the key was found in the container). Set to 
      *              false otherwise.
-     *     <key>  : The key to look-up.
+     *     <key>  : The key to look-up. Either a K, or, for transparent
+     *              lookups, any type comparable to K that hash_functor
+     *              hashes as it would the equal K.
      *     <data> : The data container to use for the lookup.
      *     <hash> : The hash of the <key> parameter.
      *
@@ -503,11 +1196,25 @@ class closed_linear_probing_hash_table : private erase_policy {
      *     If <valid> is true, then the return value is the position in the
      *     data array for the element. Otherwise, the return value is garbage.
      */
+    template <typename KK>
     HASH_CONTAINERS_INLINE
     size_t get_index(bool &valid /*out*/,
-                     const K &key,
+                     const KK &key,
                      const internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
                      size_t hash) const {
+        return this->get_index(valid, key, data, hash, uses_meta_t());
+    }
+
+
+
+    /* get_index(), for erase policies with a meta-data array. */
+    template <typename KK>
+    HASH_CONTAINERS_INLINE
+    size_t get_index(bool &valid /*out*/,
+                     const KK &key,
+                     const internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                     size_t hash,
+                     internal::bool_tag<true> /*uses_meta*/) const {
 
         size_t        orig_idx  = hash & data.capacity_minus_1;
         size_t        idx       = orig_idx;
@@ -525,7 +1232,7 @@ class closed_linear_probing_hash_table : private erase_policy {
             }
             
             // Found element
-            else if (m == VALID && data.key_table[idx] == key) {
+            else if (m == VALID && this->get_key_equal()(data.key_table[idx], key)) {
                 valid = true;
                 return idx;
             }
@@ -540,6 +1247,49 @@ class closed_linear_probing_hash_table : private erase_policy {
 
 
 
+    /* get_index(), for erase policies marking empty slots with a reserved
+     * key: only the key array is read.
+     */
+    template <typename KK>
+    HASH_CONTAINERS_INLINE
+    size_t get_index(bool &valid /*out*/,
+                     const KK &key,
+                     const internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                     size_t hash,
+                     internal::bool_tag<false> /*uses_meta*/) const {
+
+        assert(erase_policy::is_valid(key));
+
+        size_t orig_idx = hash & data.capacity_minus_1;
+        size_t idx      = orig_idx;
+
+        valid = false;
+
+        do {
+            const K &slot_key = data.key_table[idx];
+
+            // Found element. Deleted slots never match, since the key
+            // can't be the reserved one.
+            if (this->get_key_equal()(slot_key, key)) {
+                valid = true;
+                return idx;
+            }
+
+            // Element doesn't exist
+            if (erase_policy::is_empty(slot_key)) {
+                break;
+            }
+
+            // Didn't find it, try the next spot until we do (and wrap around at the ends)
+            idx = (idx + 1) & data.capacity_minus_1;
+        } while (idx != orig_idx);
+
+        // Went all the way around and didn't find it. Fail.
+        return ~size_t(0);
+    }
+
+
+
     /* Maps the key into the table, returning the index of the matched element.
      *
      * Iterators are still valid after get_index().
@@ -554,40 +1304,63 @@ class closed_linear_probing_hash_table : private erase_policy {
      *     If <valid> is true, then the return value is the position in the
      *     data array for the element. Otherwise, the return value is garbage.
      */
+    template <typename KK>
     HASH_CONTAINERS_INLINE
-    size_t get_index(bool &valid, const K &key) const {
+    size_t get_index(bool &valid, const KK &key) const {
 
-        hash_functor hash_func;
-        size_t hash = hash_func(key);
+        size_t hash = internal::call_const_hash(this->get_hash_functor(), key);
         return this->get_index(valid, key, this->data, hash);
     }
 
 
 
-    /* Adds a new element to table. The element's key must *not* already be 
-     * present.
+    /* Reserves a slot for a new element. The element's key must *not*
+     * already be present. The slot is marked valid and counted, but the key
+     * and value are left for the caller to construct in place, before
+     * anything else reads the table.
      *
      * This function could cause a reallocation of the table data and a 
      * rehash of all elements if the load factor gets too high and there's a 
      * collision.
      *
-     * Iterators should be assumed to be invalid after add_new().
+     * Iterators should be assumed to be invalid after add_slot().
      *
      * Parameters:
-     *     <key>  : The key to store.
-     *     <value>: The value to store.
+     *     <key>  : The key that will be stored.
      *     <data> : The data container to use for the lookup.
      *     <hash> : The hash of the <key> parameter.
      *
      * Returns:
-     *     The position of the inserted element.
+     *     The position of the new element.
      */
+    template <typename KK>
     HASH_CONTAINERS_INLINE
-    size_t add_new(const K &key, const V &value,
-                   internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
-                   size_t hash) {
+    size_t add_slot(const KK &key,
+                    internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                    size_t hash) {
+        return this->add_slot(key, data, hash, uses_meta_t());
+    }
+
+
+
+    /* add_slot(), for erase policies with a meta-data array. */
+    template <typename KK>
+    HASH_CONTAINERS_INLINE
+    size_t add_slot(const KK &key,
+                    internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                    size_t hash,
+                    internal::bool_tag<true> /*uses_meta*/) {
+
+        (void)key; // Only read by the asserts
 
         restart:
+        // The shared empty table is read-only; get real storage first
+        if (!default_size && !data.memory) {
+            assert(&data == &this->data);
+            resize_table(MIN_HEAP_CAPACITY);
+            goto restart;
+        }
+
         size_t  idx       = hash & data.capacity_minus_1;
         size_t  orig_idx  = idx;
         meta_t *valid_ptr = data.valid + (idx / META_ELEMENTS_PER_WORD);
@@ -598,15 +1371,11 @@ class closed_linear_probing_hash_table : private erase_policy {
             if ((valid_val & ((meta_t(1) << META_BITS_PER_ELEMENT) - 1)) != VALID) {
                 *valid_ptr = (*valid_ptr & ~(((meta_t(1) << META_BITS_PER_ELEMENT) - 1) << (META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1)))))
                            |                                                     (VALID << (META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1))));
-                //data.key_table[idx]   = new (data.key_table[idx]) K(key);
-                //data.value_table[idx] = new (data.value_table[idx]) V(value);
-                internal::construct(&data.key_table[idx],   key);
-                internal::construct(&data.value_table[idx], value);
                 data.size++;
                 return idx;
             }
 
-            assert(data.key_table[idx] != key);
+            assert(!this->get_key_equal()(data.key_table[idx], key));
 
             /* If we have a collision AND load factor is too high, increase
              * table size. Braxton suggested this optimization: we don't
@@ -615,7 +1384,7 @@ class closed_linear_probing_hash_table : private erase_policy {
             // TODO: Make this threshold a policy
             if (data.size * 2 > data.capacity_minus_1) {
                 assert(&data == &this->data);
-                increase_table_size((data.capacity_minus_1 + 1) * 2);
+                resize_table((data.capacity_minus_1 + 1) * 2);
                 goto restart;
             }
 
@@ -630,127 +1399,1177 @@ class closed_linear_probing_hash_table : private erase_policy {
 
 
 
-    
-    /* Adds a new element to table. The element's key must *not* already be 
-     * present.
-     *
-     * This function could cause a reallocation of the table data and a 
-     * rehash of all elements if the load factor gets too high and there's a 
-     * collision.
-     *
-     * Iterators should be assumed to be invalid after add_new().
-     *
-     * Parameters:
-     *     <key>  : The key to store.
-     *     <value>: The value to store.
-     *
-     * Returns:
-     *     The position of the inserted element.
+    /* add_slot(), for erase policies marking empty slots with a reserved
+     * key: only the key array is read. Empty and deleted slots are both
+     * reused. The slot stays free until the caller writes the key.
      */
+    template <typename KK>
     HASH_CONTAINERS_INLINE
-    size_t add_new(const K &key, const V &value) {
+    size_t add_slot(const KK &key,
+                    internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                    size_t hash,
+                    internal::bool_tag<false> /*uses_meta*/) {
 
-        hash_functor hash_func;
-        size_t hash = hash_func(key);
+        (void)key; // Only read by the asserts
+        assert(erase_policy::is_valid(key));
 
-        return this->add_new(key, value, this->data, hash);
-    }
+        restart:
+        // The shared empty table is read-only; get real storage first
+        if (!default_size && !data.memory) {
+            assert(&data == &this->data);
+            resize_table(MIN_HEAP_CAPACITY);
+            goto restart;
+        }
 
+        size_t idx      = hash & data.capacity_minus_1;
+        size_t orig_idx = idx;
 
+        do {
+            // If target spot is free, then great! Add element
+            if (!erase_policy::is_valid(data.key_table[idx])) {
+                data.size++;
+                return idx;
+            }
 
-    /* Erases an element from the table.
-     *
-     * Searches for the specified element and, if found, removes it from the
-     * container. If the element was not found, this function has no side 
-     * effect.
-     *
-     * Iterators to other elements are still valid after erase().
-     *
-     * Parameters:
-     *     <key>  : The key of the element to erase.
-     *     <data> : The data container to use for the lookup.
-     */
-    HASH_CONTAINERS_INLINE
-    void erase(const K &key, internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data) {
+            assert(!this->get_key_equal()(data.key_table[idx], key));
 
-        hash_functor hash_func;
-        size_t hash = hash_func(key);
+            // Grow on collisions when the load factor is too high, as above
+            if (data.size * 2 > data.capacity_minus_1) {
+                assert(&data == &this->data);
+                resize_table((data.capacity_minus_1 + 1) * 2);
+                goto restart;
+            }
 
-        bool valid;
-        const size_t idx = this->get_index(valid, key, data, hash);
+            // There is a collision, try the next spot over
+            idx = (idx + 1) & data.capacity_minus_1;
 
-        if (!valid) {
-            return;
-        }
+        } while (idx != orig_idx);
 
-        assert(data.size);
-        assert(data.key_table[idx] == key);
+        assert(0); // We better have found a spot...
+        return ~size_t(0);
+    }
 
-        internal::destroy(&data.key_table[idx]);
-        internal::destroy(&data.value_table[idx]);
 
-        this->do_erase(idx, this->data.valid, this->data.capacity_minus_1,
-                       this->data.key_table, this->data.value_table, hash_func);
-        this->data.size--;
+
+    /* Adds a new element to table, copying <key> and <value>. The element's
+     * key must *not* already be present. See add_slot().
+     *
+     * Returns:
+     *     The position of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t add_new(const K &key, const V &value,
+                   internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                   size_t hash) {
+        assert(&data == &this->data);
+        const size_t idx = this->add_slot(key, data, hash);
+        this->construct_at(idx, key, value);
+        return idx;
     }
 
 
 
-    /* Find the first element in the hash table and returns its position in 
-     * the array.
-     *
-     * Iterators are still valid after get_first().
+    /* Adds a new element to table, with a default-constructed value. The
+     * element's key must *not* already be present. See add_slot().
      *
      * Returns:
-     *     ~0 if the array is empty.
-     *     The index of the first valid element otherwise.
+     *     The position of the inserted element.
      */
     HASH_CONTAINERS_INLINE
-    size_t get_first() const {
-        return erase_policy::get_first(this->data.capacity_minus_1, this->data.valid);
+    size_t add_new_default(const K &key,
+                           internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data,
+                           size_t hash) {
+        assert(&data == &this->data);
+        const size_t idx = this->add_slot(key, data, hash);
+        this->construct_default_at(idx, key);
+        return idx;
     }
 
 
 
-    /* Find the next element in the hash table and returns its position in 
-     * the array.
+    /* Looks up <key> and, if it isn't present, reserves a slot for it, in a
+     * single probe sequence: the first free slot seen during the search
+     * (empty, or holding a deleted marker) is remembered, and claimed if the
+     * key isn't found. As with add_slot(), the caller then constructs the
+     * key and value in place.
      *
-     * Iterators are still valid after get_next().
+     * The table is only probed again, by add_slot(), when it has to grow.
+     *
+     * Iterators should be assumed to be invalid after find_or_add_slot(),
+     * if it doesn't find the key.
      *
      * Parameters:
-     *     <old_pos>: The current position in the array, from a previous call
-     *                to get_first() or get_next(), on the condition that 
-     *                iterators remain valid between such calls and this one.
+     *     <found>: (out) Set to true if the key is already present.
+     *     <key>  : The key to look-up.
+     *     <hash> : The hash of the <key> parameter.
      *
      * Returns:
-     *     ~0 if there are no more valid elements.
-     *     The index of the next valid element otherwise.
+     *     The position of the element with key <key> if <found> is true, or
+     *     else of the slot reserved for it.
      */
+    template <typename KK>
     HASH_CONTAINERS_INLINE
-    size_t get_next(size_t old_pos) const {
+    size_t find_or_add_slot(bool &found /*out*/, const KK &key, size_t hash) {
 
-        assert(old_pos != ~size_t(0));
+        found = false;
 
-        const size_t num_valid_words = (data.capacity_minus_1 + META_ELEMENTS_PER_WORD) / META_ELEMENTS_PER_WORD;
-        meta_t           *valid_ptr  = &data.valid[old_pos / META_ELEMENTS_PER_WORD];
+        // The shared empty table is read-only; get real storage first
+        if (!default_size && !this->data.memory) {
+            this->resize_table(MIN_HEAP_CAPACITY);
+            return this->add_slot(key, this->data, hash);
+        }
+
+        const size_t idx = this->find_or_add_slot(found, key, hash, uses_meta_t());
+        if (idx != ~size_t(0)) {
+            return idx;
+        }
+
+        // Grow on collisions when the load factor is too high, as add_slot() does
+        this->resize_table((this->data.capacity_minus_1 + 1) * 2);
+        return this->add_slot(key, this->data, hash);
+    }
+
+
+
+    /* find_or_add_slot(), for erase policies with a meta-data array.
+     * Returns ~0 if the table must grow first.
+     */
+    template <typename KK>
+    HASH_CONTAINERS_INLINE
+    size_t find_or_add_slot(bool &found /*out*/, const KK &key, size_t hash,
+                            internal::bool_tag<true> /*uses_meta*/) {
+
+        internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data = this->data;
+
+        size_t  orig_idx  = hash & data.capacity_minus_1;
+        size_t  idx       = orig_idx;
+        meta_t *valid_ptr = data.valid + (idx / META_ELEMENTS_PER_WORD);
+        meta_t  valid_val = *valid_ptr >> (META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1)));
+        size_t  free_idx  = ~size_t(0);
+
+        do {
+            const meta_t m = (valid_val & ((meta_t(1) << META_BITS_PER_ELEMENT) - 1));
+
+            // Found element
+            if (m == VALID) {
+                if (this->get_key_equal()(data.key_table[idx], key)) {
+                    found = true;
+                    return idx;
+                }
+            }
+
+            // Remember the first free slot; empty ones end the search
+            else {
+                if (free_idx == ~size_t(0)) {
+                    free_idx = idx;
+                }
+                if (m == INVALID) {
+                    break;
+                }
+            }
+
+            idx = this->step_idx(idx, valid_val, valid_ptr, data);
+        } while (idx != orig_idx);
+
+        if (free_idx == ~size_t(0) || (free_idx != orig_idx && data.size * 2 > data.capacity_minus_1)) {
+            return ~size_t(0);
+        }
+
+        const unsigned shift = META_BITS_PER_ELEMENT * (free_idx & (META_ELEMENTS_PER_WORD - 1));
+        valid_ptr  = data.valid + (free_idx / META_ELEMENTS_PER_WORD);
+        *valid_ptr = (*valid_ptr & ~(((meta_t(1) << META_BITS_PER_ELEMENT) - 1) << shift)) | (meta_t(VALID) << shift);
+        data.size++;
+        return free_idx;
+    }
+
+
+
+    /* find_or_add_slot(), for erase policies marking empty slots with a
+     * reserved key. Returns ~0 if the table must grow first.
+     */
+    template <typename KK>
+    HASH_CONTAINERS_INLINE
+    size_t find_or_add_slot(bool &found /*out*/, const KK &key, size_t hash,
+                            internal::bool_tag<false> /*uses_meta*/) {
+
+        assert(erase_policy::is_valid(key));
+
+        internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data = this->data;
+
+        size_t orig_idx = hash & data.capacity_minus_1;
+        size_t idx      = orig_idx;
+        size_t free_idx = ~size_t(0);
+
+        do {
+            const K &slot_key = data.key_table[idx];
+
+            // Found element
+            if (this->get_key_equal()(slot_key, key)) {
+                found = true;
+                return idx;
+            }
+
+            // Remember the first free slot; empty ones end the search
+            if (!erase_policy::is_valid(slot_key)) {
+                if (free_idx == ~size_t(0)) {
+                    free_idx = idx;
+                }
+                if (erase_policy::is_empty(slot_key)) {
+                    break;
+                }
+            }
+
+            idx = (idx + 1) & data.capacity_minus_1;
+        } while (idx != orig_idx);
+
+        if (free_idx == ~size_t(0) || (free_idx != orig_idx && data.size * 2 > data.capacity_minus_1)) {
+            return ~size_t(0);
+        }
+
+        data.size++;
+        return free_idx;
+    }
+
+
+
+    /* Gives back the slot <idx>, reserved by add_slot() or
+     * find_or_add_slot(), when constructing its element threw. The key is
+     * destroyed if <key_constructed> is true.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void abandon_slot(size_t idx, bool key_constructed) {
+
+        if (key_constructed) {
+            internal::destroy(&this->data.key_table[idx]);
+        }
+
+        hash_functor &hash_func = this->get_hash_functor();
+        this->do_erase(idx, this->data.valid, this->data.capacity_minus_1,
+                       this->data.key_table, this->data.value_table, hash_func);
+        this->data.size--;
+    }
+
+
+
+    /* Constructs the key and value of a new element in the slot <idx>,
+     * reserved by add_slot() or find_or_add_slot(), copying <key> and
+     * <value>. If a constructor throws, the slot is given back.
+     */
+    HASH_CONTAINERS_INLINE
+    void construct_at(size_t idx, const K &key, const V &value) {
+        HASH_CONTAINERS_TRY {
+            internal::construct(&this->data.key_table[idx], key);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->abandon_slot(idx, false);
+            HASH_CONTAINERS_RETHROW;
+        }
+        HASH_CONTAINERS_TRY {
+            internal::construct(&this->data.value_table[idx], value);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->abandon_slot(idx, true);
+            HASH_CONTAINERS_RETHROW;
+        }
+    }
+
+
+
+    /* Same as construct_at(), with a default-constructed value. */
+    HASH_CONTAINERS_INLINE
+    void construct_default_at(size_t idx, const K &key) {
+        HASH_CONTAINERS_TRY {
+            internal::construct(&this->data.key_table[idx], key);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->abandon_slot(idx, false);
+            HASH_CONTAINERS_RETHROW;
+        }
+        HASH_CONTAINERS_TRY {
+            internal::construct_default(&this->data.value_table[idx]);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->abandon_slot(idx, true);
+            HASH_CONTAINERS_RETHROW;
+        }
+    }
+
+
+
+#if __cplusplus >= 201103L
+    /* Constructs the key and value of a new element in the slot <idx>,
+     * reserved by add_slot() or find_or_add_slot(). <key> is moved or copied
+     * in, and the value is constructed in place from <args>. If a
+     * constructor throws, the slot is given back.
+     */
+    template <typename KK, typename... Args>
+    HASH_CONTAINERS_INLINE
+    void emplace_at(size_t idx, KK &&key, Args&&... args) {
+        HASH_CONTAINERS_TRY {
+            internal::emplace(&this->data.key_table[idx], std::forward<KK>(key));
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->abandon_slot(idx, false);
+            HASH_CONTAINERS_RETHROW;
+        }
+        HASH_CONTAINERS_TRY {
+            internal::emplace(&this->data.value_table[idx], std::forward<Args>(args)...);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->abandon_slot(idx, true);
+            HASH_CONTAINERS_RETHROW;
+        }
+    }
+#endif
+
+
+
+    
+    /* Adds a new element to table. The element's key must *not* already be 
+     * present.
+     *
+     * This function could cause a reallocation of the table data and a 
+     * rehash of all elements if the load factor gets too high and there's a 
+     * collision.
+     *
+     * Iterators should be assumed to be invalid after add_new().
+     *
+     * Parameters:
+     *     <key>  : The key to store.
+     *     <value>: The value to store.
+     *
+     * Returns:
+     *     The position of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t add_new(const K &key, const V &value) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        return this->add_new(key, value, this->data, hash);
+    }
+
+
+
+    /* Erases an element from the table.
+     *
+     * Searches for the specified element and, if found, removes it from the
+     * container. If the element was not found, this function has no side 
+     * effect.
+     *
+     * Iterators to other elements are still valid after erase().
+     *
+     * Parameters:
+     *     <key>  : The key of the element to erase.
+     *     <data> : The data container to use for the lookup.
+     */
+    template <typename KK>
+    HASH_CONTAINERS_INLINE
+    void erase(const KK &key, internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> &data) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool valid;
+        const size_t idx = this->get_index(valid, key, data, hash);
+
+        if (!valid) {
+            return;
+        }
+
+        assert(data.size);
+        assert(this->get_key_equal()(data.key_table[idx], key));
+
+        internal::destroy(&data.key_table[idx]);
+        internal::destroy(&data.value_table[idx]);
+
+        this->do_erase(idx, this->data.valid, this->data.capacity_minus_1,
+                       this->data.key_table, this->data.value_table, hash_func);
+        this->data.size--;
+
+        if (this->data.memory && shrink_policy::should_shrink(this->data.size, this->data.capacity_minus_1 + 1)) {
+            this->shrink_table(get_min_capacity(this->data.size * 2));
+        }
+    }
+
+
+
+    /* Find the first element in the hash table and returns its position in 
+     * the array.
+     *
+     * Iterators are still valid after get_first().
+     *
+     * Returns:
+     *     ~0 if the array is empty.
+     *     The index of the first valid element otherwise.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_first() const {
+        return this->get_first(uses_meta_t());
+    }
+
+    HASH_CONTAINERS_INLINE
+    size_t get_first(internal::bool_tag<true> /*uses_meta*/) const {
+        return erase_policy::get_first(this->data.capacity_minus_1, this->data.valid);
+    }
+
+    HASH_CONTAINERS_INLINE
+    size_t get_first(internal::bool_tag<false> /*uses_meta*/) const {
+        return erase_policy::get_next_from(0, this->data.capacity_minus_1, this->data.key_table);
+    }
+
+
+
+    /* Find the next element in the hash table and returns its position in 
+     * the array.
+     *
+     * Iterators are still valid after get_next().
+     *
+     * Parameters:
+     *     <old_pos>: The current position in the array, from a previous call
+     *                to get_first() or get_next(), on the condition that 
+     *                iterators remain valid between such calls and this one.
+     *
+     * Returns:
+     *     ~0 if there are no more valid elements.
+     *     The index of the next valid element otherwise.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_next(size_t old_pos) const {
+
+        assert(old_pos != ~size_t(0));
+
+        return this->get_next(old_pos, uses_meta_t());
+    }
+
+    HASH_CONTAINERS_INLINE
+    size_t get_next(size_t old_pos, internal::bool_tag<true> /*uses_meta*/) const {
+
+        const size_t num_valid_words = (data.capacity_minus_1 + META_ELEMENTS_PER_WORD) / META_ELEMENTS_PER_WORD;
+        meta_t           *valid_ptr  = &data.valid[old_pos / META_ELEMENTS_PER_WORD];
+
+        return erase_policy::get_next(old_pos, valid_ptr, num_valid_words);
+    }
+
+    HASH_CONTAINERS_INLINE
+    size_t get_next(size_t old_pos, internal::bool_tag<false> /*uses_meta*/) const {
+        return erase_policy::get_next_from(old_pos + 1, this->data.capacity_minus_1, this->data.key_table);
+    }
+
+
+
+    /* Destroys all the elements of the table, without updating its state.
+     * Nothing is done when both keys and values are trivially destructible.
+     */
+    HASH_CONTAINERS_INLINE
+    void destroy_elements() {
+        this->destroy_elements(trivially_destructible_t(), uses_meta_t());
+    }
+
+    template <bool USES_META>
+    HASH_CONTAINERS_INLINE
+    void destroy_elements(internal::bool_tag<true> /*trivially_destructible*/, internal::bool_tag<USES_META>) {
+    }
+
+    /* destroy_elements(), for erase policies with a meta-data array: scans
+     * whole words of meta-data for valid elements, and stops after the last
+     * one.
+     */
+    HASH_CONTAINERS_INLINE
+    void destroy_elements(internal::bool_tag<false> /*trivially_destructible*/, internal::bool_tag<true> /*uses_meta*/) {
+
+        // VALID, in every element of a meta-data word
+        meta_t valid_mask = 0;
+        for (unsigned i = 0; i < META_ELEMENTS_PER_WORD; i++) {
+            valid_mask |= meta_t(VALID) << (i * META_BITS_PER_ELEMENT);
+        }
+
+        size_t remaining = this->data.size;
+
+        for (size_t word = 0; remaining; word++) {
+            meta_t valid_val = this->data.valid[word] & valid_mask;
+
+            while (valid_val) {
+                const size_t i = word * META_ELEMENTS_PER_WORD + internal::bsf32_nonzero(valid_val) / META_BITS_PER_ELEMENT;
+                internal::destroy(&this->data.key_table[i]);
+                internal::destroy(&this->data.value_table[i]);
+                valid_val &= valid_val - 1;
+                remaining--;
+            }
+        }
+    }
+
+    /* destroy_elements(), for erase policies marking empty slots with a
+     * reserved key. Keys are trivially destructible.
+     */
+    HASH_CONTAINERS_INLINE
+    void destroy_elements(internal::bool_tag<false> /*trivially_destructible*/, internal::bool_tag<false> /*uses_meta*/) {
+
+        size_t remaining = this->data.size;
+
+        for (size_t i = 0; remaining; i++) {
+            if (erase_policy::is_valid(this->data.key_table[i])) {
+                internal::destroy(&this->data.value_table[i]);
+                remaining--;
+            }
+        }
+    }
+
+
+
+    /* Copies the elements of <other> into the container, which must not
+     * hold any. The container takes the capacity of <other>, reusing its
+     * arrays if they have that capacity already, and the arrays are copied
+     * as they are: nothing is rehashed. Meta-data, and trivially copyable
+     * keys and values, are copied with memcpy(); other elements are copy
+     * constructed in their slots.
+     *
+     * If copying an element throws, the container is left empty, and the
+     * memory block it allocated for the copy is released.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void copy_from(const closed_linear_probing_hash_table &other) {
+
+        assert(!this->data.size);
+
+        if (this->capacity() != other.capacity()) {
+            if (this->data.memory) {
+                this->data.free_memory(this->get_char_allocator());
+            }
+            this->init_default_tables();
+
+            if (other.data.memory) {
+                this->data = internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy>(other.capacity(), this->get_char_allocator(), /*init_tables*/false);
+                HASH_CONTAINERS_TRY {
+                    this->copy_arrays_from(other);
+                }
+                HASH_CONTAINERS_CATCH_ALL {
+                    this->data.free_memory(this->get_char_allocator());
+                    this->init_default_tables();
+                    HASH_CONTAINERS_RETHROW;
+                }
+                this->move_meta_to_inline_storage();
+                return;
+            }
+        }
+
+        if (!other.is_empty_table()) {
+            this->copy_arrays_from(other);
+        }
+    }
+
+
+
+    /* Copies the meta-data, keys and values of <other>, which has the same
+     * capacity, into the arrays of the container. Arrays whose copy can't
+     * throw are copied whole; otherwise, elements are copied one by one.
+     */
+    HASH_CONTAINERS_INLINE
+    void copy_arrays_from(const closed_linear_probing_hash_table &other) {
+
+        assert(this->data.capacity_minus_1 == other.data.capacity_minus_1);
+
+        // Keys marking empty slots are always copied whole
+        this->copy_arrays_from(other, internal::bool_tag<(internal::is_trivially_copyable<K>::value || !erase_policy::USES_META)
+                                                      && (internal::is_trivially_copyable<V>::value || !internal::value_array_t<K, V>::HAS_STORAGE)>());
+    }
+
+    HASH_CONTAINERS_INLINE
+    void copy_arrays_from(const closed_linear_probing_hash_table &other, internal::bool_tag<true> /*memcpy*/) {
+
+        this->copy_meta_from(other);
+        this->copy_keys_from(other);
+        this->copy_values_from(other, internal::bool_tag<true>());
+
+        this->data.size = other.data.size;
+    }
+
+    /* Copies the elements one by one, each slot being marked valid once its
+     * element is constructed. If a copy throws, the elements copied so far
+     * are destroyed, and the arrays left empty.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void copy_arrays_from(const closed_linear_probing_hash_table &other, internal::bool_tag<false> /*memcpy*/) {
+
+        this->clear_slots();
+
+        HASH_CONTAINERS_TRY {
+            for (size_t i = other.get_first(); i != ~size_t(0); i = other.get_next(i)) {
+                internal::construct(&this->data.key_table[i], other.data.key_table[i]);
+                HASH_CONTAINERS_TRY {
+                    internal::construct(&this->data.value_table[i], other.data.value_table[i]);
+                }
+                HASH_CONTAINERS_CATCH_ALL {
+                    internal::destroy(&this->data.key_table[i]);
+                    this->set_slot(i, false, uses_meta_t());
+                    HASH_CONTAINERS_RETHROW;
+                }
+                this->set_slot(i, true, uses_meta_t());
+                this->data.size++;
+            }
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->destroy_elements();
+            this->data.size = 0;
+            this->clear_slots();
+            HASH_CONTAINERS_RETHROW;
+        }
+
+        // Also copy the deleted markers, which probe sequences go through
+        this->copy_meta_from(other);
+        if (!erase_policy::USES_META) {
+            this->copy_keys_from(other);
+        }
+    }
+
+    HASH_CONTAINERS_INLINE
+    void copy_meta_from(const closed_linear_probing_hash_table &other) {
+        if (erase_policy::USES_META) {
+            memcpy(this->data.valid, other.data.valid, ((this->data.capacity_minus_1 + META_ELEMENTS_PER_WORD) / META_ELEMENTS_PER_WORD) * sizeof(meta_t));
+        }
+    }
+
+    HASH_CONTAINERS_INLINE
+    void copy_keys_from(const closed_linear_probing_hash_table &other) {
+        memcpy(static_cast<void*>(this->data.key_table), static_cast<const void*>(other.data.key_table), (this->data.capacity_minus_1 + 1) * sizeof(K));
+    }
+
+    HASH_CONTAINERS_INLINE
+    void copy_values_from(const closed_linear_probing_hash_table &other, internal::bool_tag<true> /*memcpy*/) {
+        const size_t V_size = internal::value_array_t<K, V>::get_size(this->data.capacity_minus_1 + 1);
+        if (V_size) {
+            memcpy(static_cast<void*>(this->data.value_table), static_cast<const void*>(other.data.value_table), V_size);
+        }
+    }
+
+
+
+    /* Marks all the slots of the table as empty, without destroying any
+     * element.
+     */
+    HASH_CONTAINERS_INLINE
+    void clear_slots() {
+        if (erase_policy::USES_META) {
+            memset(this->data.valid, 0, ((this->data.capacity_minus_1 + META_ELEMENTS_PER_WORD) / META_ELEMENTS_PER_WORD) * sizeof(meta_t));
+        }
+        internal::init_key_table<erase_policy>(this->data.key_table, this->data.capacity_minus_1 + 1, uses_meta_t());
+    }
+
+
+
+    /* Assigns the allocator of <other> to the container, for allocators that
+     * propagate on copy assignment. The container must not hold any element;
+     * its memory block is released if the allocators differ.
+     */
+    HASH_CONTAINERS_INLINE
+    void copy_allocator_from(const closed_linear_probing_hash_table &other, internal::bool_tag<true> /*propagate*/) {
+        if (this->get_char_allocator() != other.get_char_allocator()) {
+            if (this->data.memory) {
+                this->data.free_memory(this->get_char_allocator());
+            }
+            this->init_default_tables();
+        }
+        this->get_char_allocator() = other.get_char_allocator();
+    }
+
+    HASH_CONTAINERS_INLINE
+    void copy_allocator_from(const closed_linear_probing_hash_table & /*other*/, internal::bool_tag<false> /*propagate*/) {
+    }
+
+
+
+    /* Moves the elements of <other> into the container, which must not hold
+     * any nor own a memory block, and empties <other>. If <steal_memory> is
+     * set, <other>'s memory block is taken over as is. Otherwise (and for
+     * tables in the inline storage), the meta-data is copied and the
+     * elements relocated into arrays of the same capacity, allocated with
+     * the container's allocator.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void steal_from(closed_linear_probing_hash_table &other, bool steal_memory) {
+
+        assert(!this->data.memory && !this->data.size);
+
+        if (other.data.memory) {
+            // The inline storage may be holding the meta-data
+            other.move_meta_to_memory();
+
+            if (steal_memory) {
+                this->data = other.data;
+            }
+            else {
+                this->data = internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy>(other.capacity(), this->get_char_allocator(), /*init_tables*/false);
+                this->relocate_arrays_from(other);
+                other.data.free_memory(other.get_char_allocator());
+            }
+            this->move_meta_to_inline_storage();
+        }
+        else if (!other.is_empty_table()) {
+            this->relocate_arrays_from(other);
+        }
+
+        other.init_default_tables();
+    }
+
+
+
+    /* Relocates the meta-data, keys and values of <other>, which has the
+     * same capacity, into the arrays of the container. <other>'s elements
+     * are left destroyed.
+     */
+    HASH_CONTAINERS_INLINE
+    void relocate_arrays_from(closed_linear_probing_hash_table &other) {
+
+        const size_t capacity = this->data.capacity_minus_1 + 1;
+
+        assert(capacity == other.data.capacity_minus_1 + 1);
+
+        if (erase_policy::USES_META) {
+            memcpy(this->data.valid, other.data.valid, ((capacity + META_ELEMENTS_PER_WORD - 1) / META_ELEMENTS_PER_WORD) * sizeof(meta_t));
+        }
+
+        // Values first: keys marking empty slots are needed to find them
+        this->relocate_values_from(other, internal::bool_tag<is_trivially_relocatable<V>::value>());
+        this->relocate_keys_from(other, internal::bool_tag<is_trivially_relocatable<K>::value || !erase_policy::USES_META>());
+
+        this->data.size = other.data.size;
+    }
+
+    HASH_CONTAINERS_INLINE
+    void relocate_keys_from(closed_linear_probing_hash_table &other, internal::bool_tag<true> /*memcpy*/) {
+        memcpy(static_cast<void*>(this->data.key_table), static_cast<const void*>(other.data.key_table), (this->data.capacity_minus_1 + 1) * sizeof(K));
+    }
+
+    HASH_CONTAINERS_INLINE
+    void relocate_keys_from(closed_linear_probing_hash_table &other, internal::bool_tag<false> /*memcpy*/) {
+        for (size_t i = other.get_first(); i != ~size_t(0); i = other.get_next(i)) {
+            internal::relocate(&this->data.key_table[i], other.data.key_table[i]);
+        }
+    }
+
+    HASH_CONTAINERS_INLINE
+    void relocate_values_from(closed_linear_probing_hash_table &other, internal::bool_tag<true> /*memcpy*/) {
+        this->copy_values_from(other, internal::bool_tag<true>());
+    }
+
+    HASH_CONTAINERS_INLINE
+    void relocate_values_from(closed_linear_probing_hash_table &other, internal::bool_tag<false> /*memcpy*/) {
+        for (size_t i = other.get_first(); i != ~size_t(0); i = other.get_next(i)) {
+            internal::relocate(&this->data.value_table[i], other.data.value_table[i]);
+        }
+    }
+
+
+
+    /* Exchanges the elements of the inline tables of the container and
+     * <other>, slot by slot, along with their meta-data. Both containers
+     * must be using their inline storage.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void swap_inline_tables(closed_linear_probing_hash_table &other) {
+
+        // Room for one element, while exchanging two
+        internal::closed_linear_probing_hash_table_inline_t<K, V, erase_policy, 1> tmp;
+        K *tmp_key   = tmp.get_default_key_table();
+        V *tmp_value = tmp.get_default_val_table();
+
+        for (size_t i = 0; i < default_size; i++) {
+            const bool valid       = this->is_slot_valid(i, uses_meta_t());
+            const bool other_valid = other.is_slot_valid(i, uses_meta_t());
+
+            if (!valid && !other_valid) {
+                continue;
+            }
+
+            if (valid && other_valid) {
+                internal::relocate(tmp_value,                  this->data.value_table[i]);
+                internal::relocate(&this->data.value_table[i], other.data.value_table[i]);
+                internal::relocate(&other.data.value_table[i], *tmp_value);
+            }
+            else if (valid) {
+                internal::relocate(&other.data.value_table[i], this->data.value_table[i]);
+            }
+            else {
+                internal::relocate(&this->data.value_table[i], other.data.value_table[i]);
+            }
+            this->swap_keys_at(i, other, valid, other_valid, tmp_key, uses_meta_t());
+        }
+
+        if (erase_policy::USES_META) {
+            for (size_t word = 0; word < (default_size + META_ELEMENTS_PER_WORD - 1) / META_ELEMENTS_PER_WORD; word++) {
+                std::swap(this->data.valid[word], other.data.valid[word]);
+            }
+        }
+        else {
+            // Keys marking empty slots are exchanged whole, markers included
+            for (size_t i = 0; i < default_size; i++) {
+                std::swap(this->data.key_table[i], other.data.key_table[i]);
+            }
+        }
+        std::swap(this->data.size, other.data.size);
+    }
+
+    /* Exchanges the keys of slot <i>, for swap_inline_tables(). */
+    HASH_CONTAINERS_INLINE
+    void swap_keys_at(size_t i, closed_linear_probing_hash_table &other, bool valid, bool other_valid, K *tmp_key,
+                      internal::bool_tag<true> /*uses_meta*/) {
+        if (valid && other_valid) {
+            internal::relocate(tmp_key,                  this->data.key_table[i]);
+            internal::relocate(&this->data.key_table[i], other.data.key_table[i]);
+            internal::relocate(&other.data.key_table[i], *tmp_key);
+        }
+        else if (valid) {
+            internal::relocate(&other.data.key_table[i], this->data.key_table[i]);
+        }
+        else {
+            internal::relocate(&this->data.key_table[i], other.data.key_table[i]);
+        }
+    }
+
+    /* Keys marking empty slots are exchanged afterwards, all at once */
+    HASH_CONTAINERS_INLINE
+    void swap_keys_at(size_t /*i*/, closed_linear_probing_hash_table & /*other*/, bool /*valid*/, bool /*other_valid*/, K * /*tmp_key*/,
+                      internal::bool_tag<false> /*uses_meta*/) {
+    }
+
+
+
+    /* Moves the allocator of <other> to the container, for allocators that
+     * propagate on move assignment.
+     */
+    HASH_CONTAINERS_INLINE
+    void move_allocator_from(closed_linear_probing_hash_table &other, internal::bool_tag<true> /*propagate*/) {
+#if __cplusplus >= 201103L
+        this->get_char_allocator() = std::move(other.get_char_allocator());
+#else
+        this->get_char_allocator() = other.get_char_allocator();
+#endif
+    }
+
+    HASH_CONTAINERS_INLINE
+    void move_allocator_from(closed_linear_probing_hash_table & /*other*/, internal::bool_tag<false> /*propagate*/) {
+    }
+
+
+
+    /* Exchanges the allocators of the container and <other>, for allocators
+     * that propagate on swap. Others must compare equal.
+     */
+    HASH_CONTAINERS_INLINE
+    void swap_allocators(closed_linear_probing_hash_table &other, internal::bool_tag<true> /*propagate*/) {
+        std::swap(this->get_char_allocator(), other.get_char_allocator());
+    }
+
+    HASH_CONTAINERS_INLINE
+    void swap_allocators(closed_linear_probing_hash_table &other, internal::bool_tag<false> /*propagate*/) {
+        (void)other;
+        assert(this->get_char_allocator() == other.get_char_allocator());
+    }
+
+
+
+    /* Checks whether slot <idx> holds an element. */
+    HASH_CONTAINERS_INLINE
+    bool is_slot_valid(size_t idx, internal::bool_tag<true> /*uses_meta*/) const {
+        const meta_t m = this->data.valid[idx / META_ELEMENTS_PER_WORD] >> (META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1)));
+        return (m & ((meta_t(1) << META_BITS_PER_ELEMENT) - 1)) == VALID;
+    }
+
+    HASH_CONTAINERS_INLINE
+    bool is_slot_valid(size_t idx, internal::bool_tag<false> /*uses_meta*/) const {
+        return erase_policy::is_valid(this->data.key_table[idx]);
+    }
+
+
+
+    /* Marks slot <idx> as empty or valid, for erase policies that shift
+     * elements on erase (so empty slots hold no marker).
+     */
+    HASH_CONTAINERS_INLINE
+    void set_slot(size_t idx, bool valid, internal::bool_tag<true> /*uses_meta*/) {
+        const unsigned shift = META_BITS_PER_ELEMENT * (idx & (META_ELEMENTS_PER_WORD - 1));
+        meta_t &word = this->data.valid[idx / META_ELEMENTS_PER_WORD];
+        word = (word & ~(((meta_t(1) << META_BITS_PER_ELEMENT) - 1) << shift)) | (meta_t(valid ? VALID : INVALID) << shift);
+    }
+
+    HASH_CONTAINERS_INLINE
+    void set_slot(size_t idx, bool valid, internal::bool_tag<false> /*uses_meta*/) {
+        // Valid slots are marked by writing their key
+        if (!valid) {
+            erase_policy::init_keys(&this->data.key_table[idx], 1);
+        }
+    }
+
+
+
+    /* Restores the probe sequences of a table from which elements were
+     * removed without shifting the others back: each element is moved to
+     * the first free slot from its home position.
+     *
+     * The pass visits every slot, starting after <start_idx>. When that slot
+     * was already empty before the removals, no probe sequence crosses the
+     * start of the pass and a single pass is enough. Otherwise the caller
+     * repeats the pass until it moves nothing.
+     *
+     * Returns:
+     *     true if an element was moved.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    bool compact_clusters(size_t start_idx) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        const size_t capacity_minus_1 = this->data.capacity_minus_1;
+        bool moved = false;
+
+        for (size_t n = 1; n <= capacity_minus_1 + 1; n++) {
+            const size_t idx = (start_idx + n) & capacity_minus_1;
+            if (!this->is_slot_valid(idx, uses_meta_t())) {
+                continue;
+            }
+
+            size_t new_idx = hash_func(this->data.key_table[idx]) & capacity_minus_1;
+            while (new_idx != idx && this->is_slot_valid(new_idx, uses_meta_t())) {
+                new_idx = (new_idx + 1) & capacity_minus_1;
+            }
+            if (new_idx == idx) {
+                continue;
+            }
+
+            internal::relocate(&this->data.key_table  [new_idx], this->data.key_table  [idx]);
+            internal::relocate(&this->data.value_table[new_idx], this->data.value_table[idx]);
+            this->set_slot(new_idx, true,  uses_meta_t());
+            this->set_slot(idx,     false, uses_meta_t());
+            moved = true;
+        }
+        return moved;
+    }
+
+
+
+    /* Returns the position of an empty slot, or ~0 if the table is full. */
+    HASH_CONTAINERS_INLINE
+    size_t find_empty_slot() const {
+        for (size_t i = 0; i <= this->data.capacity_minus_1; i++) {
+            if (!this->is_slot_valid(i, uses_meta_t())) {
+                return i;
+            }
+        }
+        return ~size_t(0);
+    }
+
+
+
+    /* Destroys the element in slot <idx>, and erases it through the erase
+     * policy.
+     */
+    HASH_CONTAINERS_INLINE
+    void erase_at(size_t idx) {
+
+        assert(this->data.size);
+        assert(this->is_slot_valid(idx, uses_meta_t()));
+
+        hash_functor &hash_func = this->get_hash_functor();
+
+        internal::destroy(&this->data.key_table[idx]);
+        internal::destroy(&this->data.value_table[idx]);
+
+        this->do_erase(idx, this->data.valid, this->data.capacity_minus_1,
+                       this->data.key_table, this->data.value_table, hash_func);
+        this->data.size--;
+    }
+
+
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor.
+     */
+    HASH_CONTAINERS_INLINE
+    closed_linear_probing_hash_table() {
+        this->init_default_tables();
+    }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit closed_linear_probing_hash_table(const allocator_type &alloc)
+        : allocator_holder_t(char_allocator_t(alloc)) {
+        this->init_default_tables();
+    }
+
+
+
+    /* Constructs an empty container, which will hash keys with (a copy of)
+     * <hash>, compare them with (a copy of) <equal>, and allocate memory
+     * through (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit closed_linear_probing_hash_table(const hash_functor   &hash,
+                                              const key_equal      &equal = key_equal(),
+                                              const allocator_type &alloc = allocator_type())
+        : allocator_holder_t(char_allocator_t(alloc)),
+          key_equal_holder_t(equal),
+          hash_functor_holder_t(hash) {
+        this->init_default_tables();
+    }
+
+
+
+    /* Copy constructor. The copy has the same capacity as <other>, and its
+     * arrays are cloned in one pass, without rehashing any element.
+     */
+    HASH_CONTAINERS_INLINE
+    closed_linear_probing_hash_table(const closed_linear_probing_hash_table &other)
+        : erase_policy(other),
+          allocator_holder_t(internal::select_on_copy(other.get_char_allocator())),
+          key_equal_holder_t(other.get_key_equal()),
+          hash_functor_holder_t(other.get_hash_functor()),
+          inline_tables_t() {
+        this->init_default_tables();
+        this->copy_from(other);
+    }
+
+
+
+    /* Copy assignment. The container's arrays are reused if they have the
+     * capacity of <other>'s. The allocator is assigned if it propagates on
+     * copy assignment.
+     */
+    HASH_CONTAINERS_INLINE
+    closed_linear_probing_hash_table &operator=(const closed_linear_probing_hash_table &other) {
+
+        if (this == &other) {
+            return *this;
+        }
+
+        this->destroy_elements();
+        this->data.size = 0;
+
+        this->copy_allocator_from(other, internal::bool_tag<internal::propagate_on_copy_assignment<char_allocator_t>::value>());
+
+        this->get_key_equal()    = other.get_key_equal();
+        this->get_hash_functor() = other.get_hash_functor();
+        this->copy_from(other);
+        return *this;
+    }
+
+
+
+#if __cplusplus >= 201103L
+    /* Move constructor. Heap tables are taken over in O(1); tables in the
+     * inline storage have their elements relocated. <other> is left empty.
+     *
+     * It is noexcept if relocating the inline elements and copying the
+     * functors can't throw.
+     */
+    HASH_CONTAINERS_INLINE
+    closed_linear_probing_hash_table(closed_linear_probing_hash_table &&other)
+            noexcept((!default_size || ((is_trivially_relocatable<K>::value || std::is_nothrow_move_constructible<K>::value)
+                                     && (is_trivially_relocatable<V>::value || std::is_nothrow_move_constructible<V>::value)))
+                  && std::is_nothrow_copy_constructible<hash_functor>::value
+                  && std::is_nothrow_copy_constructible<key_equal>::value)
+        : erase_policy(other),
+          allocator_holder_t(std::move(other.get_char_allocator())),
+          key_equal_holder_t(other.get_key_equal()),
+          hash_functor_holder_t(other.get_hash_functor()),
+          inline_tables_t() {
+        this->init_default_tables();
+        this->steal_from(other, /*steal_memory*/true);
+    }
+
+
+
+    /* Move assignment. The heap table of <other> is taken over in O(1) if
+     * the allocators propagate on move assignment or are equal. Otherwise,
+     * its elements are relocated into memory from the container's
+     * allocator. <other> is left empty.
+     *
+     * It is noexcept if the heap table is always taken over, and relocating
+     * the inline elements and assigning the functors can't throw.
+     */
+    HASH_CONTAINERS_INLINE
+    closed_linear_probing_hash_table &operator=(closed_linear_probing_hash_table &&other)
+            noexcept((internal::propagate_on_move_assignment<char_allocator_t>::value || internal::is_always_equal<char_allocator_t>::value)
+                  && (!default_size || ((is_trivially_relocatable<K>::value || std::is_nothrow_move_constructible<K>::value)
+                                     && (is_trivially_relocatable<V>::value || std::is_nothrow_move_constructible<V>::value)))
+                  && std::is_nothrow_copy_assignable<hash_functor>::value
+                  && std::is_nothrow_copy_assignable<key_equal>::value) {
+
+        if (this == &other) {
+            return *this;
+        }
 
-        return erase_policy::get_next(old_pos, valid_ptr, num_valid_words);
+        this->destroy_elements();
+        if (this->data.memory) {
+            this->data.free_memory(this->get_char_allocator());
+        }
+        this->init_default_tables();
+
+        // Decided before the allocator is moved: a moved-from allocator may
+        // no longer compare equal to anything
+        const bool steal_memory = internal::propagate_on_move_assignment<char_allocator_t>::value
+                               || this->get_char_allocator() == other.get_char_allocator();
+
+        this->move_allocator_from(other, internal::bool_tag<internal::propagate_on_move_assignment<char_allocator_t>::value>());
+        this->get_key_equal()    = other.get_key_equal();
+        this->get_hash_functor() = other.get_hash_functor();
+        this->steal_from(other, steal_memory);
+        return *this;
     }
+#endif
 
 
 
-public:
-    /* Default constructor.
+    /* Exchanges the contents, hash functors and key comparison functors of
+     * the container and <other>. Allocators are exchanged if they propagate
+     * on swap; otherwise, they must compare equal.
+     * Heap tables are exchanged in O(1); tables in the inline storage have
+     * their elements relocated.
      */
     HASH_CONTAINERS_INLINE
-    closed_linear_probing_hash_table() {
-        assert(default_size > 0 && (default_size & (default_size-1)) == 0);
-        this->data.key_table   = reinterpret_cast<K*>(&default_key_table[0]);
-        this->data.value_table = reinterpret_cast<V*>(&default_val_table[0]);
-        this->data.valid       = &default_valid[0];
-        memset(this->data.valid, 0, sizeof(default_valid));
-        this->data.size        = 0;
-        this->data.capacity_minus_1 = default_size - 1;
+    void swap(closed_linear_probing_hash_table &other) {
+
+        if (this == &other) {
+            return;
+        }
+
+        // The inline storage may be holding the meta-data
+        this->move_meta_to_memory();
+        other.move_meta_to_memory();
+
+        if (this->data.memory && other.data.memory) {
+            std::swap(this->data, other.data);
+        }
+        else if (this->data.memory || other.data.memory) {
+            // Relocate the inline elements into the inline storage of the
+            // container giving up its heap table, then hand the table over
+            closed_linear_probing_hash_table &heap  = this->data.memory ? *this : other;
+            closed_linear_probing_hash_table &local = this->data.memory ? other : *this;
+
+            const internal::closed_linear_probing_hash_table_data_t<K, V, erase_policy> heap_data = heap.data;
+            heap.init_default_tables();
+            if (!local.is_empty_table()) {
+                heap.relocate_arrays_from(local);
+            }
+            local.data = heap_data;
+        }
+        else if (default_size) {
+            this->swap_inline_tables(other);
+        }
+
+        this->move_meta_to_inline_storage();
+        other.move_meta_to_inline_storage();
+
+        this->swap_allocators(other, internal::bool_tag<internal::propagate_on_swap<char_allocator_t>::value>());
+        std::swap(this->get_key_equal(),    other.get_key_equal());
+        std::swap(this->get_hash_functor(), other.get_hash_functor());
     }
 
 
@@ -760,28 +2579,15 @@ public:
     HASH_CONTAINERS_INLINE
     ~closed_linear_probing_hash_table() {
 
-        const meta_t *valid_ptr  = &this->data.valid[0];
-        meta_t        valid_val  =  this->data.valid[0];
-
-        for (size_t i = 0; i <= this->data.capacity_minus_1; i++) {
-            if ((valid_val & ((meta_t(1) << META_BITS_PER_ELEMENT) - 1)) == VALID) {
-                internal::destroy(&this->data.key_table[i]);
-                internal::destroy(&this->data.value_table[i]);
-            }
-            valid_val >>= META_BITS_PER_ELEMENT;
-            if ((i & (META_ELEMENTS_PER_WORD - 1)) == (META_ELEMENTS_PER_WORD - 1)) {
-                valid_ptr++;
-                valid_val = *valid_ptr;
-            }
-        }
+        this->destroy_elements();
 
-        if (this->data.valid != &default_valid[0]) {
+        if (this->data.memory) {
             /*
             delete[] data.key_table;
             delete[] data.value_table;
             delete[] data.valid;
             */
-            free(data.valid);
+            this->data.free_memory(this->get_char_allocator());
         }
     }
 
@@ -808,27 +2614,50 @@ public:
     HASH_CONTAINERS_INLINE
     bool insert(const K &key, const V &value) {
 
-        hash_functor hash_func;
+        hash_functor &hash_func = this->get_hash_functor();
         size_t hash = hash_func(key);
 
-        bool valid;
-        this->get_index(valid, key, this->data, hash);
-        if (valid) {
+        bool found;
+        const size_t idx = this->find_or_add_slot(found, key, hash);
+        if (found) {
             return false;
         }
-        this->add_new(key, value, this->data, hash);
+        this->construct_at(idx, key, value);
         return true;
     }
 
 
 
+#if __cplusplus >= 201103L
+    /* Same as insert(const K&, const V&), but moves <key> and <value> into
+     * the container if they are inserted. They are left untouched otherwise.
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(K &&key, V &&value) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t idx = this->find_or_add_slot(found, key, hash);
+        if (found) {
+            return false;
+        }
+        this->emplace_at(idx, std::move(key), std::move(value));
+        return true;
+    }
+#endif
+
+
+
     /* Erases an element from the table.
      *
      * Searches for the specified element and, if found, removes it from the
      * container. If the element was not found, this function has no side 
      * effect.
      *
-     * Iterators to other elements are still valid after erase().
+     * Iterators to other elements are still valid after erase(), unless the
+     * shrink policy resized the table.
      *
      * Parameters:
      *     <key>  : The key of the element to erase.
@@ -858,7 +2687,34 @@ public:
      */
     HASH_CONTAINERS_INLINE
     size_t capacity() const {
-        return this->data.capacity_minus_1 + 1;
+        return this->is_empty_table() ? 0 : this->data.capacity_minus_1 + 1;
+    }
+
+
+
+    /* Returns a copy of the allocator of the container.
+     */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return allocator_type(this->get_char_allocator());
+    }
+
+
+
+    /* Returns a copy of the functor comparing keys.
+     */
+    HASH_CONTAINERS_INLINE
+    key_equal key_eq() const {
+        return this->get_key_equal();
+    }
+
+
+
+    /* Returns a copy of the functor hashing keys.
+     */
+    HASH_CONTAINERS_INLINE
+    hash_functor hash_function() const {
+        return this->get_hash_functor();
     }
 
 
@@ -875,13 +2731,52 @@ public:
      *                     be a non-zero power of 2.
      */
     void reserve(size_t new_capacity) {
-        if (new_capacity > this->data.capacity_minus_1 + 1) {
+        if (new_capacity > this->capacity()) {
             new_capacity = internal::round_up_to_next_power_of_2(new_capacity);
-            this->increase_table_size(new_capacity);
+            this->resize_table(new_capacity);
         }
     }
 
 
+
+    /* Sets the capacity of the container to <new_capacity>, rounded up to the
+     * next power of 2, and to what the current elements need. Unlike
+     * reserve(), the capacity can be reduced, possibly back to the inline
+     * storage. It only grows if <new_capacity> is larger than the current
+     * capacity.
+     *
+     * Iterators are invalidated if the container is resized.
+     *
+     * Parameters:
+     *     <new_capacity>: The new capacity of the container, in elements.
+     */
+    void rehash(size_t new_capacity) {
+        const size_t min_capacity = get_min_capacity(this->data.size);
+        const size_t requested    = new_capacity;
+
+        new_capacity = internal::round_up_to_next_power_of_2(new_capacity > min_capacity ? new_capacity : min_capacity);
+
+        if (requested > this->capacity()) {
+            this->resize_table(new_capacity);
+        }
+        else {
+            this->shrink_table(new_capacity);
+        }
+    }
+
+
+
+    /* Reduces the capacity of the container to the smallest one that can hold
+     * its elements, releasing the heap memory if the elements fit in the
+     * inline storage.
+     *
+     * Iterators are invalidated if the container is resized.
+     */
+    void shrink_to_fit() {
+        this->rehash(0);
+    }
+
+
     /*******************************************************************
      * Iterator interface
      *******************************************************************/
@@ -1107,20 +3002,203 @@ public:
     HASH_CONTAINERS_INLINE
     V& operator[](const K& key) {
 
-        hash_functor hash_func;
+        hash_functor &hash_func = this->get_hash_functor();
         size_t hash = hash_func(key);
 
-        bool valid;
-        size_t idx = this->get_index(valid, key, this->data, hash);
+        bool found;
+        const size_t idx = this->find_or_add_slot(found, key, hash);
 
-        if (valid) {
-            return this->data.value_table[idx];
+        if (!found) {
+            this->construct_default_at(idx, key);
         }
-        idx = this->add_new(key, V(), this->data, hash);
-        assert(this->data.key_table[idx] == key);
+        assert(this->get_key_equal()(this->data.key_table[idx], key));
+        return this->data.value_table[idx];
+    }
+
+
+
+#if __cplusplus >= 201103L
+private:
+    /* Enables the overloads taking keys of another type than K, when the
+     * hash and key comparison functors are transparent. Keys convertible to iterators are left
+     * to erase(const_iterator).
+     */
+    template <typename KK>
+    using enable_if_transparent_t = typename std::enable_if<internal::is_transparent<hash_functor>::value
+                                                        && internal::is_transparent<key_equal>::value
+                                                        && !std::is_same<typename std::decay<KK>::type, K>::value
+                                                        && !std::is_convertible<KK, const_iterator>::value
+                                                        && !std::is_convertible<KK, iterator>::value, int>::type;
+
+
+
+public:
+    /* Same as operator[](const K&), but moves <key> into the container if it
+     * isn't present.
+     */
+    HASH_CONTAINERS_INLINE
+    V& operator[](K&& key) {
+        const size_t idx = this->try_emplace(std::move(key)).first.pos;
+        return this->data.value_table[idx];
+    }
+
+
+
+    /* Inserts an element in table, if <key> isn't present yet. The value is
+     * constructed in place from <args>, and only when the key is inserted:
+     * nothing is constructed, moved or copied if the key is already
+     * present.
+     *
+     * Iterators should be assumed to be invalid after try_emplace(), if it
+     * inserts an element.
+     *
+     * Parameters:
+     *     <key> : The key to store.
+     *     <args>: The arguments of the value's constructor.
+     *
+     * Returns:
+     *     An iterator to the element with key <key>, and 'true' if it was
+     *     inserted, 'false' if it was already present.
+     */
+    template <typename... Args>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> try_emplace(const K &key, Args&&... args) {
+        return this->try_emplace_key(key, std::forward<Args>(args)...);
+    }
+
+
+
+    /* Same as try_emplace(const K&, ...), but moves <key> into the container
+     * if it is inserted. <key> is left untouched otherwise.
+     */
+    template <typename... Args>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> try_emplace(K &&key, Args&&... args) {
+        return this->try_emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+
+
+
+    /* Inserts an element in table, if its key isn't present yet. The key is
+     * constructed from <key_arg>, and the value is then constructed in place
+     * from <args> only if the key is inserted.
+     *
+     * Iterators should be assumed to be invalid after emplace(), if it
+     * inserts an element.
+     *
+     * Returns:
+     *     An iterator to the element with the key, and 'true' if it was
+     *     inserted, 'false' if it was already present.
+     */
+    template <typename KK, typename... Args>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> emplace(KK &&key_arg, Args&&... args) {
+        K key(std::forward<KK>(key_arg));
+        return this->try_emplace_key(std::move(key), std::forward<Args>(args)...);
+    }
+
+
+
+    /* Inserts an element in table, or assigns <obj> to the value of <key> if
+     * it is already present.
+     *
+     * Iterators should be assumed to be invalid after insert_or_assign(), if
+     * it inserts an element.
+     *
+     * Returns:
+     *     An iterator to the element with key <key>, and 'true' if it was
+     *     inserted, 'false' if it was assigned.
+     */
+    template <typename M>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> insert_or_assign(const K &key, M &&obj) {
+        return this->insert_or_assign_key(key, std::forward<M>(obj));
+    }
+
+
+
+    /* Same as insert_or_assign(const K&, ...), but moves <key> into the
+     * container if it is inserted.
+     */
+    template <typename M>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> insert_or_assign(K &&key, M &&obj) {
+        return this->insert_or_assign_key(std::move(key), std::forward<M>(obj));
+    }
+
+
+
+    /* Transparent versions of operator[](), try_emplace() and insert(),
+     * enabled when hash_functor and key_equal declare is_transparent. <key>
+     * is hashed and compared to the keys in the table as is: a K is only
+     * constructed from it if the element is inserted.
+     */
+    template <typename KK, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    V& operator[](KK&& key) {
+        const size_t idx = this->try_emplace_key(std::forward<KK>(key)).first.pos;
         return this->data.value_table[idx];
     }
 
+    template <typename KK, typename... Args, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> try_emplace(KK &&key, Args&&... args) {
+        return this->try_emplace_key(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    template <typename KK, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    bool insert(KK &&key, const V &value) {
+        return this->try_emplace_key(std::forward<KK>(key), value).second;
+    }
+
+
+
+private:
+    /* Implements try_emplace() and emplace(), for const and rvalue keys,
+     * and keys of other types for transparent hash functors.
+     */
+    template <typename KK, typename... Args>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> try_emplace_key(KK &&key, Args&&... args) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t idx = this->find_or_add_slot(found, key, hash);
+        if (found) {
+            return std::make_pair(iterator(idx, this), false);
+        }
+        this->emplace_at(idx, std::forward<KK>(key), std::forward<Args>(args)...);
+        return std::make_pair(iterator(idx, this), true);
+    }
+
+
+
+    /* Implements insert_or_assign(), for const and rvalue keys. */
+    template <typename KK, typename M>
+    HASH_CONTAINERS_INLINE
+    std::pair<iterator, bool> insert_or_assign_key(KK &&key, M &&obj) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t idx = this->find_or_add_slot(found, key, hash);
+        if (found) {
+            this->data.value_table[idx] = std::forward<M>(obj);
+            return std::make_pair(iterator(idx, this), false);
+        }
+        this->emplace_at(idx, std::forward<KK>(key), std::forward<M>(obj));
+        return std::make_pair(iterator(idx, this), true);
+    }
+
+
+
+public:
+#endif
+
 
 
     /* Looks up the specified key and returns a constant reference to the 
@@ -1140,17 +3218,16 @@ public:
     HASH_CONTAINERS_INLINE
     const V& operator[](const K& key) const {
 
-        hash_functor hash_func;
-        size_t hash = hash_func(key);
+        size_t hash = internal::call_const_hash(this->get_hash_functor(), key);
 
         bool valid;
         size_t idx = this->get_index(valid, key, this->data, hash);
 
         if (!valid) {
-            idx = this->add_new(key, V(), this->data, hash);
+            idx = this->add_new_default(key, this->data, hash);
         }
 
-        assert(this->data.key_table[idx] == key);
+        assert(this->get_key_equal()(this->data.key_table[idx], key));
         return this->data.value_table[idx];
     }
 
@@ -1212,6 +3289,147 @@ public:
 
 
 
+#if __cplusplus >= 201103L
+    /* Transparent versions of count(), find() and erase(), enabled when
+     * hash_functor and key_equal declare is_transparent: <key> is hashed and
+     * compared to the keys in the table as is, without constructing a K.
+     */
+    template <typename KK, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    size_t count(const KK &key) const {
+        bool valid;
+        this->get_index(valid, key);
+        return valid ? 1 : 0;
+    }
+
+    template <typename KK, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const KK &key) const {
+        bool valid;
+        size_t pos = this->get_index(valid, key);
+        return const_iterator(pos, this);
+    }
+
+    template <typename KK, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    iterator find(const KK &key) {
+        bool valid;
+        size_t pos = this->get_index(valid, key);
+        return iterator(pos, this);
+    }
+
+    template <typename KK, enable_if_transparent_t<KK> = 0>
+    HASH_CONTAINERS_INLINE
+    void erase(const KK &key) {
+        this->erase(key, this->data);
+    }
+#endif
+
+
+
+    /* Erases the element at <it>, without looking its key up.
+     *
+     * Unlike erase(const K&), the table is never shrunk. Erase policies
+     * that leave a marker (erase_policy_use_marker, and erase_policy_empty_key
+     * with a deleted key) don't move other elements: iterators to them stay
+     * valid, and iterating on with the returned iterator visits each
+     * remaining element once.
+     *
+     * Erase policies that shift elements back on erase (erase_policy_rehash
+     * and erase_policy_empty_key without a deleted key) can move other
+     * elements to earlier slots: iterators to them are invalidated. The
+     * returned iterator still reaches every remaining element, but an
+     * element moved from the start of the table to its end can be visited a
+     * second time. To erase elements while iterating over the table, use
+     * erase_if(), which calls its predicate once per element.
+     *
+     * Parameters:
+     *     <it>: An iterator to the element to erase. Must not be end().
+     *
+     * Returns:
+     *     An iterator to the element following the erased one.
+     */
+    HASH_CONTAINERS_INLINE
+    iterator erase(const_iterator it) {
+
+        const size_t idx = it.pos;
+        this->erase_at(idx);
+
+        // Another element may have been moved into the slot
+        if (this->is_slot_valid(idx, uses_meta_t())) {
+            return iterator(idx, this);
+        }
+        return iterator(this->get_next(idx), this);
+    }
+
+
+
+    /* Erases all the elements for which <pred> returns true, in a single
+     * sweep. <pred> is called once per element, with the pair an iterator
+     * would return.
+     *
+     * With erase policies that shift elements back on erase, the matching
+     * elements are all removed first, and the probe sequences are then
+     * repaired in one pass over the table, instead of once per element.
+     * A full table may need more than one pass.
+     *
+     * This is the way to erase elements while iterating: unlike a loop on
+     * erase(const_iterator), it never visits an element twice.
+     *
+     * Iterators are invalidated by erase_if().
+     *
+     * Returns:
+     *     The number of elements erased.
+     */
+    template <typename predicate>
+    size_t erase_if(predicate pred) {
+
+        if (!this->data.size) {
+            return 0;
+        }
+
+        const size_t old_size = this->data.size;
+
+        if (!erase_policy::SHIFTS_ON_ERASE) {
+            // Markers: erasing does not move the other elements
+            for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
+                if (pred(*iterator(i, this))) {
+                    this->erase_at(i);
+                }
+            }
+        }
+        else {
+            const size_t empty_idx = this->find_empty_slot();
+
+            for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
+                if (pred(*iterator(i, this))) {
+                    internal::destroy(&this->data.key_table[i]);
+                    internal::destroy(&this->data.value_table[i]);
+                    this->set_slot(i, false, uses_meta_t());
+                    this->data.size--;
+                }
+            }
+            if (this->data.size != old_size) {
+                if (empty_idx != ~size_t(0)) {
+                    this->compact_clusters(empty_idx);
+                }
+                else {
+                    // The table was full: probe sequences may wrap around
+                    // any starting point, so repeat until nothing moves
+                    while (this->compact_clusters(0)) {
+                    }
+                }
+            }
+        }
+
+        if (this->data.memory && shrink_policy::should_shrink(this->data.size, this->data.capacity_minus_1 + 1)) {
+            this->shrink_table(get_min_capacity(this->data.size * 2));
+        }
+        return old_size - this->data.size;
+    }
+
+
+
     /* Clears the content of the container. The capacity of the container is
      * unchanged.
      *
@@ -1219,28 +3437,53 @@ public:
      */
     HASH_CONTAINERS_INLINE
     void clear() {
-        const meta_t *valid_ptr  = &this->data.valid[0];
-        meta_t        valid_val  =  this->data.valid[0];
+        if (this->is_empty_table()) {
+            return;
+        }
 
-        for (size_t i = 0; i <= this->data.capacity_minus_1; i++) {
-            if ((valid_val & ((meta_t(1) << META_BITS_PER_ELEMENT) - 1)) == VALID) {
-                internal::destroy(&this->data.key_table[i]);
-                internal::destroy(&this->data.value_table[i]);
-            }
-            valid_val >>= META_BITS_PER_ELEMENT;
-            if ((i & (META_ELEMENTS_PER_WORD - 1)) == (META_ELEMENTS_PER_WORD - 1)) {
-                valid_ptr++;
-                valid_val = *valid_ptr;
-            }
+        this->destroy_elements();
+        this->data.size = 0;
+
+        if (!erase_policy::USES_META) {
+            internal::init_key_table<erase_policy>(this->data.key_table, this->capacity(), uses_meta_t());
+            return;
         }
 
         assert(INVALID == 0);
-        memset(this->data.valid, 0, ((this->capacity() + META_ELEMENTS_PER_WORD - 1) / META_ELEMENTS_PER_WORD) * sizeof(meta_t));
-        this->data.size = 0;
+
+        // Big tables give their pages back to the OS instead of writing zeroes
+        // over them.
+        if (!this->data.is_meta_in_memory()
+         || !internal::discard_block(this->get_char_allocator(), this->data.memory, this->data.get_memory_size(this->capacity()))) {
+            memset(this->data.valid, 0, ((this->capacity() + META_ELEMENTS_PER_WORD - 1) / META_ELEMENTS_PER_WORD) * sizeof(meta_t));
+        }
     }
 
 }; // class closed_linear_probing_hash_table
 
+
+
+/* Erases the elements of <table> for which <pred> returns true. See
+ * closed_linear_probing_hash_table::erase_if().
+ */
+template <typename K, typename V, typename hash_functor, class erase_policy, size_t default_size, typename allocator, class shrink_policy,
+          typename key_equal, class inline_storage_policy, typename predicate>
+HASH_CONTAINERS_INLINE
+size_t erase_if(closed_linear_probing_hash_table<K, V, hash_functor, erase_policy, default_size, allocator, shrink_policy, key_equal, inline_storage_policy> &table, predicate pred) {
+    return table.erase_if(pred);
+}
+
+
+
+/* Exchanges the contents of two tables. See closed_linear_probing_hash_table::swap(). */
+template <typename K, typename V, typename hash_functor, class erase_policy, size_t default_size, typename allocator, class shrink_policy,
+          typename key_equal, class inline_storage_policy>
+HASH_CONTAINERS_INLINE
+void swap(closed_linear_probing_hash_table<K, V, hash_functor, erase_policy, default_size, allocator, shrink_policy, key_equal, inline_storage_policy> &a,
+          closed_linear_probing_hash_table<K, V, hash_functor, erase_policy, default_size, allocator, shrink_policy, key_equal, inline_storage_policy> &b) {
+    a.swap(b);
+}
+
 }; // namespace hash_table
 
 
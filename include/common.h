@@ -23,7 +23,25 @@
 #ifndef INCLUDE_HASH_CONTAINERS_COMMON_H_GUARD
 #define INCLUDE_HASH_CONTAINERS_COMMON_H_GUARD 1
 
+#include <assert.h>  // For assert
 #include <stdint.h>  // For uint32_t
+#include <limits.h>  // For CHAR_BIT
+#include <stdlib.h>  // For malloc, abort
+#include <string.h>  // For memset
+#include <time.h>    // For time
+#include <stddef.h>  // For size_t, ptrdiff_t
+#include <memory>    // For std::allocator_traits<>
+#include <utility>   // For std::move, std::forward
+#include <stdexcept> // For std::length_error
+#if __cplusplus >= 201103L
+#include <type_traits> // For std::is_trivially_copyable<>, std::is_trivially_destructible<>
+#include <functional>  // For std::hash<>
+#include <random>      // For std::random_device
+#include <string>      // For std::string
+#endif
+#if __cplusplus >= 201703L
+#include <string_view> // For std::string_view
+#endif
 
 #ifdef _MSC_VER
 #define HASH_CONTAINERS_NO_INLINE __declspec(noinline)
@@ -33,10 +51,179 @@
 #define HASH_CONTAINERS_INLINE    __attribute__((always_inline)) inline
 #endif
 
+/* Exception handling, compiled out when exceptions are disabled. Sizes a
+ * container can't represent throw std::length_error, or abort without
+ * exceptions.
+ */
+#if (defined __cpp_exceptions) || (defined __EXCEPTIONS) || (defined _CPPUNWIND)
+#define HASH_CONTAINERS_TRY       try
+#define HASH_CONTAINERS_CATCH_ALL catch (...)
+#define HASH_CONTAINERS_RETHROW   throw
+#define HASH_CONTAINERS_THROW_LENGTH_ERROR(message) throw std::length_error(message)
+#else
+#define HASH_CONTAINERS_TRY       if (true)
+#define HASH_CONTAINERS_CATCH_ALL else
+#define HASH_CONTAINERS_RETHROW
+#define HASH_CONTAINERS_THROW_LENGTH_ERROR(message) abort()
+#endif
+
+
+/* Memory blocks of tables at least HASH_CONTAINERS_HUGE_PAGE_THRESHOLD bytes
+ * large are mapped directly with mmap() instead of malloc(), aligned to
+ * HASH_CONTAINERS_HUGE_PAGE_SIZE and advised for transparent huge pages. This
+ * cuts down on TLB misses when probing very large tables.
+ *
+ * Define HASH_CONTAINERS_USE_MAP_HUGETLB to first try the explicit huge page
+ * pool (MAP_HUGETLB), or HASH_CONTAINERS_NO_HUGE_PAGES to always use malloc().
+ *
+ * These must be set identically in all translation units.
+ */
+#ifndef HASH_CONTAINERS_HUGE_PAGE_THRESHOLD
+#define HASH_CONTAINERS_HUGE_PAGE_THRESHOLD (4 * 1024 * 1024)
+#endif
+
+/* Memory blocks of tables at least HASH_CONTAINERS_CALLOC_THRESHOLD bytes
+ * large are allocated with calloc() instead of malloc() + memset(), so that
+ * the allocator can hand out lazily zeroed pages.
+ */
+#ifndef HASH_CONTAINERS_CALLOC_THRESHOLD
+#define HASH_CONTAINERS_CALLOC_THRESHOLD    (128 * 1024)
+#endif
+
+#ifndef HASH_CONTAINERS_HUGE_PAGE_SIZE
+#define HASH_CONTAINERS_HUGE_PAGE_SIZE      (2 * 1024 * 1024) /* Must be a power of 2 */
+#endif
+
+/* Size of a cache line. The arrays of heap-allocated tables start on cache
+ * line boundaries. Must be a power of 2.
+ */
+#ifndef HASH_CONTAINERS_CACHE_LINE_SIZE
+#define HASH_CONTAINERS_CACHE_LINE_SIZE     64
+#endif
+
+#if ((defined __unix__) || (defined __APPLE__)) && !(defined HASH_CONTAINERS_NO_HUGE_PAGES)
+#define HASH_CONTAINERS_USE_MMAP 1
+#include <sys/mman.h> // For mmap
+#endif
+
 
 namespace hash_containers {
 
 
+namespace internal {
+
+    /* Trait:
+     *     is_trivially_destructible<T>
+     *
+     * True if the destructor of objects of type <T> does nothing, so that
+     * containers can skip destroying them. In C++98, only the arithmetic and
+     * pointer types are known to be trivially destructible.
+     */
+#if __cplusplus >= 201103L
+    template <typename T>
+    struct is_trivially_destructible {
+        static const bool value = std::is_trivially_destructible<T>::value;
+    };
+#else
+    template <typename T> struct is_trivially_destructible     { static const bool value = false; };
+    template <typename T> struct is_trivially_destructible<T*> { static const bool value = true;  };
+    template <> struct is_trivially_destructible<bool>           { static const bool value = true; };
+    template <> struct is_trivially_destructible<char>           { static const bool value = true; };
+    template <> struct is_trivially_destructible<signed char>    { static const bool value = true; };
+    template <> struct is_trivially_destructible<unsigned char>  { static const bool value = true; };
+    template <> struct is_trivially_destructible<wchar_t>        { static const bool value = true; };
+    template <> struct is_trivially_destructible<short>          { static const bool value = true; };
+    template <> struct is_trivially_destructible<unsigned short> { static const bool value = true; };
+    template <> struct is_trivially_destructible<int>            { static const bool value = true; };
+    template <> struct is_trivially_destructible<unsigned int>   { static const bool value = true; };
+    template <> struct is_trivially_destructible<long>           { static const bool value = true; };
+    template <> struct is_trivially_destructible<unsigned long>  { static const bool value = true; };
+    template <> struct is_trivially_destructible<float>          { static const bool value = true; };
+    template <> struct is_trivially_destructible<double>         { static const bool value = true; };
+    template <> struct is_trivially_destructible<long double>    { static const bool value = true; };
+#endif
+
+
+
+    /* Trait:
+     *     is_trivially_copyable<T>
+     *
+     * True if objects of type <T> can be copied with memcpy(). In C++98,
+     * only the arithmetic and pointer types are known to be trivially
+     * copyable.
+     */
+    template <typename T>
+    struct is_trivially_copyable {
+#if __cplusplus >= 201103L
+        static const bool value = std::is_trivially_copyable<T>::value;
+#else
+        static const bool value = is_trivially_destructible<T>::value;
+#endif
+    };
+
+
+
+
+#if __cplusplus >= 201103L
+    /* Trait:
+     *     is_transparent<T>
+     *
+     * True if the functor type <T> declares an is_transparent member type,
+     * as in C++14: it then accepts other types than the key type, and
+     * containers can look keys up without constructing a key first.
+     */
+    template <typename T, typename = void>
+    struct is_transparent : std::false_type { };
+
+    template <typename T>
+    struct is_transparent<T, typename std::conditional<true, void, typename T::is_transparent>::type> : std::true_type { };
+#endif
+
+}; // namespace internal
+
+
+
+/* Trait:
+ *     is_trivially_relocatable<T>
+ *
+ * True if objects of type <T> can be moved to another address with memcpy(),
+ * the old copy then being dropped without calling its destructor. The
+ * containers then relocate elements with memcpy() when they grow or erase,
+ * instead of moving and destroying them one by one.
+ *
+ * Trivially copyable types are trivially relocatable. So are most types
+ * that don't point into themselves (e.g. std::unique_ptr), but not all:
+ * specialize this trait for them.
+ *
+ * In C++98, only the arithmetic and pointer types are known to be trivially
+ * relocatable.
+ */
+template <typename T>
+struct is_trivially_relocatable {
+    static const bool value = internal::is_trivially_copyable<T>::value;
+};
+
+
+
+/* Functor:
+ *     equal_to
+ *
+ * Default key comparison of the containers: compares keys with operator==.
+ * It is transparent, so keys can also be compared to objects of other
+ * types, as operator== allows.
+ */
+struct equal_to {
+    typedef void is_transparent;
+
+    template <typename T1, typename T2>
+    HASH_CONTAINERS_INLINE
+    bool operator()(const T1 &a, const T2 &b) const {
+        return a == b;
+    }
+};
+
+
+
 namespace internal {
 
     /* Returns the position of the lowest bit set in the input.
@@ -55,6 +242,108 @@ namespace internal {
 
 
 
+    /* Returns the number of bits set in the input.
+     */
+    HASH_CONTAINERS_INLINE
+    uint32_t popcount32(uint32_t x)
+    {
+#if defined(_WIN32)
+        return __popcnt(x);
+#else // Assume GCC
+        return __builtin_popcount(x);
+#endif
+    }
+
+
+
+    /* Mixes the bits of <h>, so that each bit of the result depends on all
+     * the bits of <h> (MurmurHash3's finalizer). The mix is a bijection.
+     */
+    HASH_CONTAINERS_INLINE
+    uint64_t mix64(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+
+
+    /* Hashes <size> bytes at <bytes>: FNV-1a, followed by a final mix so
+     * that the low bits, which tables use as the index, depend on all the
+     * input bytes. A non-zero <seed> changes the initial state, so inputs
+     * crafted to collide for one seed generally don't for the others.
+     */
+    HASH_CONTAINERS_INLINE
+    uint64_t hash_bytes(const char *bytes, size_t size, uint64_t seed = 0)
+    {
+        uint64_t h = 0xcbf29ce484222325ull ^ mix64(seed);
+        for (size_t i = 0; i < size; i++) {
+            h ^= static_cast<unsigned char>(bytes[i]);
+            h *= 0x100000001b3ull;
+        }
+
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+
+
+    /* Mixes the address of a static variable, moved by address space layout
+     * randomization, with the time.
+     */
+    inline
+    uint64_t address_time_seed()
+    {
+        static const char anchor = 0;
+        return mix64(uint64_t(uintptr_t(&anchor)) ^ uint64_t(time(NULL)));
+    }
+
+
+
+#if __cplusplus >= 201103L
+    /* Draws 64 bits from std::random_device. Some implementations have no
+     * entropy source (they throw, or always return the same numbers), so the
+     * address and time are still mixed in.
+     */
+    inline
+    uint64_t random_device_seed()
+    {
+        uint64_t seed = address_time_seed();
+        HASH_CONTAINERS_TRY {
+            std::random_device device;
+            seed ^= (uint64_t(device()) << 32) ^ uint64_t(device());
+        } HASH_CONTAINERS_CATCH_ALL {
+        }
+        return mix64(seed);
+    }
+#endif
+
+
+
+    /* Returns a seed that is hard to guess from outside the process. It comes
+     * from std::random_device in C++11, drawn once per process since that can
+     * be a system call, and from address_time_seed() otherwise. Different
+     * <salt> addresses give different seeds.
+     */
+    inline
+    uint64_t random_seed(const void *salt)
+    {
+#if __cplusplus >= 201103L
+        static const uint64_t seed = random_device_seed();
+#else
+        uint64_t seed = address_time_seed();
+#endif
+        return mix64(seed ^ uint64_t(uintptr_t(salt)));
+    }
+
+
+
     /* Invokes the object's ctor() at the specified memory location, without
      * allocating memory.
      */
@@ -73,6 +362,66 @@ namespace internal {
 
 
 
+    /* Invokes the object's default ctor() at the specified memory location,
+     * without allocating memory nor copying a temporary.
+     */
+    template <class S1>
+    HASH_CONTAINERS_INLINE
+    static void construct_default(S1* d) {
+#if (defined _CRTDBG_MAP_ALLOC) && (defined new)
+#pragma push_macro("new")
+#undef new
+#endif
+        new ((void*)d) S1();
+#if (defined _CRTDBG_MAP_ALLOC)
+#pragma pop_macro("new")
+#endif
+    }
+
+
+
+    /* Constructs an object at <d> from the object at <s>, moving it in
+     * C++11 and copying it otherwise. <s> must still be destroyed.
+     */
+    template <class S1>
+    HASH_CONTAINERS_INLINE
+    static void move_construct(S1* d, S1 &s) {
+#if (defined _CRTDBG_MAP_ALLOC) && (defined new)
+#pragma push_macro("new")
+#undef new
+#endif
+#if __cplusplus >= 201103L
+        new ((void*)d) S1(std::move(s));
+#else
+        new ((void*)d) S1(s);
+#endif
+#if (defined _CRTDBG_MAP_ALLOC)
+#pragma pop_macro("new")
+#endif
+    }
+
+
+
+#if __cplusplus >= 201103L
+    /* Invokes the object's ctor() at the specified memory location, with
+     * the given arguments, without allocating memory.
+     */
+    template <class S1, typename... Args>
+    HASH_CONTAINERS_INLINE
+    static void emplace(S1* d, Args&&... args) {
+#if (defined _CRTDBG_MAP_ALLOC) && (defined new)
+#pragma push_macro("new")
+#undef new
+#endif
+        new ((void*)d) S1(std::forward<Args>(args)...);
+#if (defined _CRTDBG_MAP_ALLOC)
+#pragma pop_macro("new")
+#endif
+    }
+#endif
+
+
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4100) // warning C4100: 'd' : unreferenced formal parameter
@@ -132,6 +481,147 @@ namespace internal {
 
 
 
+    /* Rounds up <size> to a multiple of the cache line size. */
+    HASH_CONTAINERS_INLINE
+    size_t round_up_to_cache_line(size_t size) {
+        return (size + HASH_CONTAINERS_CACHE_LINE_SIZE - 1) & ~size_t(HASH_CONTAINERS_CACHE_LINE_SIZE - 1);
+    }
+
+
+
+    /* Returns the first cache line boundary at or after <p>. */
+    HASH_CONTAINERS_INLINE
+    char *align_to_cache_line(char *p) {
+        return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(p) + HASH_CONTAINERS_CACHE_LINE_SIZE - 1) & ~uintptr_t(HASH_CONTAINERS_CACHE_LINE_SIZE - 1));
+    }
+
+
+
+    /* Returns the number of bytes actually mapped for a table memory block of
+     * <size> bytes.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_mapped_size(size_t size) {
+        return (size + HASH_CONTAINERS_HUGE_PAGE_SIZE - 1) & ~size_t(HASH_CONTAINERS_HUGE_PAGE_SIZE - 1);
+    }
+
+
+
+    /* Allocates a memory block of <size> bytes for table storage. Blocks at
+     * or above HASH_CONTAINERS_HUGE_PAGE_THRESHOLD are backed by huge pages
+     * where the platform allows it.
+     *
+     * The block must be released with free_table_memory(), using the same
+     * <size>.
+     *
+     * Parameters:
+     *     <size>: The size of the block, in bytes.
+     *     <zero>: If true, the block is returned zero-filled. Large blocks
+     *             get lazily zeroed pages from the OS, so this doesn't touch
+     *             the memory up front.
+     *
+     * Returns:
+     *     A pointer to the block, aligned for any object type, or NULL if the
+     *     allocation failed.
+     */
+    inline
+    void *allocate_table_memory(size_t size, bool zero) {
+#ifdef HASH_CONTAINERS_USE_MMAP
+        if (size >= HASH_CONTAINERS_HUGE_PAGE_THRESHOLD) {
+            const size_t map_size = get_mapped_size(size);
+
+#if (defined HASH_CONTAINERS_USE_MAP_HUGETLB) && (defined MAP_HUGETLB)
+            void *memory = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (memory != MAP_FAILED) {
+                return memory;
+            }
+#endif
+            /* Over-map by one huge page, then trim both ends so the block
+             * starts on a huge page boundary. Otherwise, the kernel can't back
+             * the first and last partial huge pages with huge pages.
+             */
+            char *raw = static_cast<char*>(mmap(NULL, map_size + HASH_CONTAINERS_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (raw == MAP_FAILED) {
+                return NULL;
+            }
+            char *aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(raw) + HASH_CONTAINERS_HUGE_PAGE_SIZE - 1) & ~uintptr_t(HASH_CONTAINERS_HUGE_PAGE_SIZE - 1));
+            if (aligned != raw) {
+                munmap(raw, aligned - raw);
+            }
+            if (aligned + map_size != raw + map_size + HASH_CONTAINERS_HUGE_PAGE_SIZE) {
+                munmap(aligned + map_size, (raw + map_size + HASH_CONTAINERS_HUGE_PAGE_SIZE) - (aligned + map_size));
+            }
+#ifdef MADV_HUGEPAGE
+            madvise(aligned, map_size, MADV_HUGEPAGE);
+#endif
+            return aligned;
+        }
+#endif
+        if (zero) {
+            return calloc(size, 1);
+        }
+        return malloc(size);
+    }
+
+
+
+    /* Checks whether allocate_table_memory() hands out memory that is zeroed
+     * lazily, so that asking for zeroed memory is cheaper than clearing it.
+     */
+    HASH_CONTAINERS_INLINE
+    bool is_table_memory_lazily_zeroed(size_t size) {
+#ifdef HASH_CONTAINERS_USE_MMAP
+        if (size >= HASH_CONTAINERS_HUGE_PAGE_THRESHOLD) {
+            return true;
+        }
+#endif
+        return size >= HASH_CONTAINERS_CALLOC_THRESHOLD;
+    }
+
+
+
+    /* Drops the physical pages backing a block obtained from
+     * allocate_table_memory(). The block stays mapped, and reads back as all
+     * zeroes.
+     *
+     * Returns:
+     *     'true' if the pages were dropped, 'false' if the block is not
+     *     backed by its own mapping (the caller must zero it instead).
+     */
+    inline
+    bool discard_table_memory(void *memory, size_t size) {
+#if (defined HASH_CONTAINERS_USE_MMAP) && (defined __linux__) && (defined MADV_DONTNEED)
+        // Only Linux guarantees that dropped private anonymous pages refault as zeroes
+        if (size >= HASH_CONTAINERS_HUGE_PAGE_THRESHOLD) {
+            return madvise(memory, get_mapped_size(size), MADV_DONTNEED) == 0;
+        }
+#else
+        (void)memory;
+        (void)size;
+#endif
+        return false;
+    }
+
+
+
+    /* Releases a memory block obtained from allocate_table_memory(). <size>
+     * must be the same as was passed to allocate_table_memory().
+     */
+    inline
+    void free_table_memory(void *memory, size_t size) {
+#ifdef HASH_CONTAINERS_USE_MMAP
+        if (size >= HASH_CONTAINERS_HUGE_PAGE_THRESHOLD) {
+            munmap(memory, get_mapped_size(size));
+            return;
+        }
+#else
+        (void)size;
+#endif
+        free(memory);
+    }
+
+
+
     template< class T >
     T* addressof(T& arg) {
         return reinterpret_cast<T*>(&const_cast<char&>(reinterpret_cast<const volatile char&>(arg)));
@@ -139,6 +629,344 @@ namespace internal {
 
 
 
+    /* Union with the strictest alignment of the fundamental types, to align
+     * raw storage in C++98.
+     */
+    union max_align_t {
+        long double ld;
+        double      d;
+        long long   ll;
+        void       *p;
+        void      (*fp)();
+    };
+
+
+
+    /* Holds an object of class type <T>. When <T> is empty, the holder takes
+     * no space in the classes deriving from it (empty base optimization).
+     *
+     * <tag> distinguishes holders of the same type in the same class.
+     */
+    template <typename T, int tag>
+    class ebo_holder : private T {
+    public:
+        ebo_holder() : T() {}
+        ebo_holder(const T &t) : T(t) {}
+
+        T       &get()       { return *this; }
+        const T &get() const { return *this; }
+    };
+
+
+
+    /* Selects between overloads on a compile-time condition, without
+     * instantiating the overload that isn't picked.
+     */
+    template <bool b>
+    struct bool_tag { };
+
+
+
+#if __cplusplus >= 201103L
+    /* value is true if <H>'s operator() can be called on a const <H> with a
+     * const <T>.
+     */
+    template <typename H, typename T, typename = void>
+    struct has_const_call : std::false_type { };
+
+    template <typename H, typename T>
+    struct has_const_call<H, T, decltype(void(std::declval<const H&>()(std::declval<const T&>())))>
+        : std::true_type { };
+#endif
+
+
+
+    /* Hashes <key> with <hash> where only a const reference to the functor is
+     * at hand, as in the const lookups. Functors whose operator() isn't const
+     * hash with a copy instead, as do all functors in C++98, where this can't
+     * be detected.
+     */
+    template <typename H, typename T>
+    HASH_CONTAINERS_INLINE
+    size_t call_const_hash(const H &hash, const T &key, bool_tag<true> /*has_const_call*/) {
+        return size_t(hash(key));
+    }
+
+    template <typename H, typename T>
+    HASH_CONTAINERS_INLINE
+    size_t call_const_hash(const H &hash, const T &key, bool_tag<false> /*has_const_call*/) {
+        H copy(hash);
+        return size_t(copy(key));
+    }
+
+    template <typename H, typename T>
+    HASH_CONTAINERS_INLINE
+    size_t call_const_hash(const H &hash, const T &key) {
+#if __cplusplus >= 201103L
+        return call_const_hash(hash, key, bool_tag<has_const_call<H, T>::value>());
+#else
+        return call_const_hash(hash, key, bool_tag<false>());
+#endif
+    }
+
+
+
+    /* Moves the object at <s> to the unconstructed memory at <d>, and
+     * destroys <s>. Trivially relocatable objects are copied with memcpy().
+     */
+    template <class S1>
+    HASH_CONTAINERS_INLINE
+    static void relocate(S1* d, S1 &s, bool_tag<true> /*is_trivially_relocatable*/) {
+        memcpy(static_cast<void*>(d), static_cast<const void*>(&s), sizeof(S1));
+    }
+
+    template <class S1>
+    HASH_CONTAINERS_INLINE
+    static void relocate(S1* d, S1 &s, bool_tag<false> /*is_trivially_relocatable*/) {
+        move_construct(d, s);
+        destroy(&s);
+    }
+
+    template <class S1>
+    HASH_CONTAINERS_INLINE
+    static void relocate(S1* d, S1 &s) {
+        relocate(d, s, bool_tag<is_trivially_relocatable<S1>::value>());
+    }
+
+
+
+    /* Returns the allocator of the copy of a container using <alloc>. */
+    template <typename A>
+    HASH_CONTAINERS_INLINE
+    A select_on_copy(const A &alloc) {
+#if __cplusplus >= 201103L
+        return std::allocator_traits<A>::select_on_container_copy_construction(alloc);
+#else
+        return alloc;
+#endif
+    }
+
+
+
+    /* True if assigning a container also assigns its allocator. */
+    template <typename A>
+    struct propagate_on_copy_assignment {
+#if __cplusplus >= 201103L
+        static const bool value = std::allocator_traits<A>::propagate_on_container_copy_assignment::value;
+#else
+        static const bool value = false;
+#endif
+    };
+
+
+
+    /* True if moving a container also moves its allocator. */
+    template <typename A>
+    struct propagate_on_move_assignment {
+#if __cplusplus >= 201103L
+        static const bool value = std::allocator_traits<A>::propagate_on_container_move_assignment::value;
+#else
+        static const bool value = false;
+#endif
+    };
+
+
+
+    /* True if swapping containers also swaps their allocators. Otherwise,
+     * the allocators must compare equal.
+     */
+    template <typename A>
+    struct propagate_on_swap {
+#if __cplusplus >= 201103L
+        static const bool value = std::allocator_traits<A>::propagate_on_container_swap::value;
+#else
+        static const bool value = false;
+#endif
+    };
+
+
+
+#if __cplusplus >= 201103L
+    /* True if all the allocators of type <A> compare equal, so that memory
+     * from one can be released by another: A::is_always_equal if declared,
+     * as in C++17, or else whether <A> is empty.
+     */
+    template <typename A, typename = void>
+    struct is_always_equal : std::is_empty<A> { };
+
+    template <typename A>
+    struct is_always_equal<A, typename std::conditional<true, void, typename A::is_always_equal>::type> : A::is_always_equal { };
+#endif
+
+
+
+    /* Rebinds allocator <A> to allocate objects of type <T>. */
+    template <typename A, typename T>
+    struct rebind_alloc {
+#if __cplusplus >= 201103L
+        typedef typename std::allocator_traits<A>::template rebind_alloc<T> type;
+#else
+        typedef typename A::template rebind<T>::other type;
+#endif
+    };
+
+
+
+    /* Table memory blocks are allocated through the following functions,
+     * with an allocator of chars. They are overloaded for table_allocator<>
+     * to take advantage of the memory it hands out.
+     */
+
+    /* Returns 'true' if <alloc> hands out zeroed memory without having to
+     * write to it, for blocks of <size> bytes.
+     */
+    template <typename A>
+    HASH_CONTAINERS_INLINE
+    bool is_block_lazily_zeroed(const A &/*alloc*/, size_t /*size*/) {
+        return false;
+    }
+
+
+
+    /* Allocates a block of <size> bytes, zero-filled if <zero> is true. */
+    template <typename A>
+    char *allocate_block(A &alloc, size_t size, bool zero) {
+#if __cplusplus >= 201103L
+        char *memory = &*std::allocator_traits<A>::allocate(alloc, size);
+#else
+        char *memory = &*alloc.allocate(size);
+#endif
+        if (zero && memory) {
+            memset(memory, 0, size);
+        }
+        return memory;
+    }
+
+
+
+    /* Releases a block from allocate_block(), of the same <size>. */
+    template <typename A>
+    void deallocate_block(A &alloc, char *memory, size_t size) {
+#if __cplusplus >= 201103L
+        std::allocator_traits<A>::deallocate(alloc, std::pointer_traits<typename std::allocator_traits<A>::pointer>::pointer_to(*memory), size);
+#else
+        alloc.deallocate(memory, size);
+#endif
+    }
+
+
+
+    /* Drops the pages of a block from allocate_block(), if possible. Returns
+     * 'true' if the block now reads back as zeroes, 'false' if the caller
+     * must clear it.
+     */
+    template <typename A>
+    HASH_CONTAINERS_INLINE
+    bool discard_block(A &/*alloc*/, char */*memory*/, size_t /*size*/) {
+        return false;
+    }
+
+}; // namespace internal
+
+
+
+/* Class:
+ *     table_allocator<T>
+ *
+ * The default allocator of the hash containers. Memory comes from
+ * malloc()/calloc(), or from huge page mappings for large blocks (see
+ * HASH_CONTAINERS_HUGE_PAGE_THRESHOLD).
+ *
+ * Containers recognize this allocator, and skip clearing memory it already
+ * hands out zeroed.
+ */
+template <typename T>
+class table_allocator {
+public:
+    typedef T         value_type;
+    typedef T*        pointer;
+    typedef const T*  const_pointer;
+    typedef T&        reference;
+    typedef const T&  const_reference;
+    typedef size_t    size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef table_allocator<U> other;
+    };
+
+#if __cplusplus >= 201103L
+    /* Stateless: containers can always exchange their memory blocks */
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type is_always_equal;
+#endif
+
+    table_allocator() {}
+
+    template <typename U>
+    table_allocator(const table_allocator<U> &) {}
+
+    T *allocate(size_t n, const void * /*hint*/ = 0) {
+        return static_cast<T*>(internal::allocate_table_memory(n * sizeof(T), false));
+    }
+
+    void deallocate(T *p, size_t n) {
+        internal::free_table_memory(p, n * sizeof(T));
+    }
+
+    size_t max_size() const {
+        return ~size_t(0) / sizeof(T);
+    }
+
+    /* Pre-C++11 allocator requirements */
+    T       *address(T       &x) const { return internal::addressof(x); }
+    const T *address(const T &x) const { return internal::addressof(const_cast<T&>(x)); }
+
+    void construct(T *p, const T &v) { internal::construct(p, v); }
+    void destroy(T *p)               { internal::destroy(p); }
+};
+
+template <typename T, typename U>
+HASH_CONTAINERS_INLINE
+bool operator==(const table_allocator<T> &, const table_allocator<U> &) { return true; }
+
+template <typename T, typename U>
+HASH_CONTAINERS_INLINE
+bool operator!=(const table_allocator<T> &, const table_allocator<U> &) { return false; }
+
+
+
+namespace internal {
+
+    template <typename T>
+    HASH_CONTAINERS_INLINE
+    bool is_block_lazily_zeroed(const table_allocator<T> &/*alloc*/, size_t size) {
+        return is_table_memory_lazily_zeroed(size);
+    }
+
+
+
+    template <typename T>
+    char *allocate_block(table_allocator<T> &/*alloc*/, size_t size, bool zero) {
+        return static_cast<char*>(allocate_table_memory(size, zero));
+    }
+
+
+
+    template <typename T>
+    void deallocate_block(table_allocator<T> &/*alloc*/, char *memory, size_t size) {
+        free_table_memory(memory, size);
+    }
+
+
+
+    template <typename T>
+    HASH_CONTAINERS_INLINE
+    bool discard_block(table_allocator<T> &/*alloc*/, char *memory, size_t size) {
+        return discard_table_memory(memory, size);
+    }
+
 }; // namespace internal
 
 
@@ -170,6 +998,84 @@ private:
 };
 
 
+
+namespace internal {
+
+    /* Hashes <key> with <hash> for seeded_hash<>, mixing in <seed>. */
+    template <typename T, typename base_hash>
+    HASH_CONTAINERS_INLINE
+    size_t seeded_hash_value(const base_hash &hash, const T &key, uint64_t seed) {
+        return size_t(mix64(uint64_t(call_const_hash(hash, key)) ^ seed));
+    }
+
+#if __cplusplus >= 201103L
+    /* Strings hashed by std::hash<> hash their bytes with the seed instead,
+     * so that strings std::hash<> maps to the same value don't collide for
+     * every seed.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t seeded_hash_value(const std::hash<std::string> &/*hash*/, const std::string &key, uint64_t seed) {
+        return size_t(hash_bytes(key.data(), key.size(), seed));
+    }
+#endif
+
+#if __cplusplus >= 201703L
+    HASH_CONTAINERS_INLINE
+    size_t seeded_hash_value(const std::hash<std::string_view> &/*hash*/, std::string_view key, uint64_t seed) {
+        return size_t(hash_bytes(key.data(), key.size(), seed));
+    }
+#endif
+
+}; // namespace internal
+
+
+
+/* Functor:
+ *     seeded_hash<T, base_hash = std::hash<T> > // Default only in C++11
+ *
+ * Hash functor mixing a per-instance seed into the hash of <base_hash>.
+ * Keys chosen to collide in the table, such as externally-controlled keys
+ * crafted to produce long probe sequences, then only collide for the seed
+ * they were crafted against. Keys that <base_hash> itself hashes to the same
+ * value would still collide, so std::string and std::string_view keys with
+ * the default <base_hash> have their bytes hashed with the seed instead.
+ * A <base_hash> whose operator() isn't const is called on a copy.
+ *
+ * Default-constructed instances draw a random seed. Containers copy their
+ * hash functor along with their elements, so copies keep the seed.
+ */
+#if __cplusplus >= 201103L
+template <typename T, typename base_hash = std::hash<T> >
+#else
+template <typename T, typename base_hash>
+#endif
+class seeded_hash : private base_hash {
+    uint64_t seed;
+
+public:
+    HASH_CONTAINERS_INLINE
+    seeded_hash() : seed(internal::random_seed(this)) { }
+
+    HASH_CONTAINERS_INLINE
+    explicit seeded_hash(uint64_t seed, const base_hash &hash = base_hash()) : base_hash(hash), seed(seed) { }
+
+
+
+    HASH_CONTAINERS_INLINE
+    size_t operator()(const T &key) const {
+        return internal::seeded_hash_value(static_cast<const base_hash&>(*this), key, this->seed);
+    }
+
+
+
+    /* Returns the seed of the functor. */
+    HASH_CONTAINERS_INLINE
+    uint64_t get_seed() const {
+        return this->seed;
+    }
+};
+
+
 }; // namespace hash_containers
 
 
@@ -0,0 +1,854 @@
+/* Associative container, insertion-ordered hash table with a compact index.
+ *
+ * The elements are stored contiguously, in insertion order, in a dense
+ * array. The hash table itself only holds 32-bit indices into that array,
+ * with linear probing on conflicts (like CPython's dict). Each element also
+ * keeps its hash, so that:
+ *   - growing the hash table only rehashes the indices: the keys and values
+ *     aren't hashed again, nor copied;
+ *   - probing compares hashes before comparing keys;
+ *   - iterating is a linear scan of the dense array.
+ *
+ * erase() moves the last element into the erased element's spot, so the
+ * dense array stays compact. Iteration follows insertion order until the
+ * first erasure.
+ *
+ * This suits maps with large values, which closed_linear_probing_hash_table
+ * copies on every growth. The dense array itself still grows geometrically,
+ * like a vector; reserve() avoids that.
+ *
+ * Objects must either be POD types, or must provide the appropriate ctors and
+ * assignment operators.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_DENSE_HASH_TABLE_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_DENSE_HASH_TABLE_H_GUARD 1
+
+#include <assert.h>   // For assert
+#include <iterator>   // For std::iterator<>
+#include <string.h>   // For memset
+#include "common.h"
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     dense_hash_table<K, V,
+ *                      hash_functor = std::hash<K>, // C++11
+ *                      allocator    = table_allocator<char>
+ *                      >
+ *
+ * Objects of this class are associative containers mapping objects of type
+ * <K> to objects of type <V>, using the hash function <hash_functor>.
+ *
+ * Template Parameters:
+ *    <K>           : the type of the key of the associative container.
+ *    <V>           : the type of the value of the associative container.
+ *    <hash_functor>: a functor that will hash the key to a size_t. Default
+ *                    value is only provided in C++11. It is stored in the
+ *                    container, so it can hold state such as a seed (see
+ *                    seeded_hash<>); empty functors take no space.
+ *    <allocator>   : the allocator used for the index table and the dense
+ *                    array. It is rebound to char.
+ */
+template <typename K,
+          typename V,
+#if __cplusplus >= 201103L
+          typename hash_functor = std::hash<K>,
+#else
+          typename hash_functor,
+#endif
+          typename allocator = table_allocator<char>
+          >
+class dense_hash_table;
+
+
+
+namespace internal {
+
+    /* An element of a dense hash table, in the dense array. */
+    template <typename K, typename V>
+    struct dense_hash_table_entry_t {
+        size_t hash;
+        K      key;
+        V      value;
+    };
+
+
+
+    /* Index table of empty dense hash tables: a single, empty, slot. It is
+     * never written to.
+     */
+    template <typename index_t>
+    struct empty_table_index {
+        static const index_t indices[1];
+    };
+
+    template <typename index_t>
+    const index_t empty_table_index<index_t>::indices[1] = { index_t(~index_t(0)) };
+} // namespace internal
+
+
+/***************************************************************************
+ */
+
+template <typename K,
+          typename V,
+          typename hash_functor,
+          typename allocator>
+class dense_hash_table : private internal::ebo_holder<typename internal::rebind_alloc<allocator, char>::type, 0>,
+                         private internal::ebo_holder<hash_functor, 1> {
+
+    typedef internal::dense_hash_table_entry_t<K, V> entry_t;
+    typedef uint32_t                                 index_t;
+
+    typedef typename internal::rebind_alloc<allocator, char>::type char_allocator_t;
+    typedef internal::ebo_holder<char_allocator_t, 0>             allocator_holder_t;
+    typedef internal::ebo_holder<hash_functor, 1>                 hash_functor_holder_t;
+
+    /* Marks the empty slots of the index table */
+    static const index_t EMPTY = index_t(~index_t(0));
+
+    /* Capacity of the first index table allocated. */
+    static const size_t MIN_CAPACITY = 8;
+
+
+    entry_t *entries;           // Dense array, in insertion order
+    size_t   num_entries;
+    size_t   entries_capacity;
+    index_t *indices;           // Index table
+    size_t   capacity_minus_1;
+
+
+    /* Returns the allocator used for the container's memory. */
+    HASH_CONTAINERS_INLINE
+    char_allocator_t &get_char_allocator() {
+        return static_cast<allocator_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const char_allocator_t &get_char_allocator() const {
+        return static_cast<const allocator_holder_t&>(*this).get();
+    }
+
+
+
+    /* Returns the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor &get_hash_functor() {
+        return static_cast<hash_functor_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const hash_functor &get_hash_functor() const {
+        return static_cast<const hash_functor_holder_t&>(*this).get();
+    }
+
+
+
+    /* Points the container at the shared, read-only, empty index table. */
+    HASH_CONTAINERS_INLINE
+    void init_empty_table() {
+        this->entries          = NULL;
+        this->num_entries      = 0;
+        this->entries_capacity = 0;
+        this->indices          = const_cast<index_t*>(&internal::empty_table_index<index_t>::indices[0]);
+        this->capacity_minus_1 = 0;
+    }
+
+
+
+    /* Checks whether the container is using the shared empty index table. */
+    HASH_CONTAINERS_INLINE
+    bool is_empty_table() const {
+        return this->indices == &internal::empty_table_index<index_t>::indices[0];
+    }
+
+
+
+    /* Replaces the index table by one of <new_size> slots, and re-inserts
+     * the indices of all the elements, using their stored hashes.
+     *
+     * Parameters:
+     *     <new_size>: The new size of the index table. Must be a power of 2,
+     *                 and at least twice the number of elements.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void resize_index_table(size_t new_size) {
+
+        assert((new_size & (new_size - 1)) == 0);
+        assert(new_size >= this->num_entries * 2);
+        assert(new_size - 1 <= EMPTY);
+
+        index_t *new_indices = reinterpret_cast<index_t*>(internal::allocate_block(this->get_char_allocator(), new_size * sizeof(index_t), false));
+        assert(new_indices);
+        memset(new_indices, 0xff, new_size * sizeof(index_t));
+
+        for (size_t i = 0; i < this->num_entries; i++) {
+            size_t slot = this->entries[i].hash & (new_size - 1);
+            while (new_indices[slot] != EMPTY) {
+                slot = (slot + 1) & (new_size - 1);
+            }
+            new_indices[slot] = index_t(i);
+        }
+
+        if (!this->is_empty_table()) {
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(this->indices), (this->capacity_minus_1 + 1) * sizeof(index_t));
+        }
+
+        this->indices          = new_indices;
+        this->capacity_minus_1 = new_size - 1;
+    }
+
+
+
+    /* Replaces the dense array by one of <new_capacity> elements. The
+     * elements are moved over, and keep their indices.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void resize_entries(size_t new_capacity) {
+
+        assert(new_capacity >= this->num_entries);
+
+        entry_t *new_entries = reinterpret_cast<entry_t*>(internal::allocate_block(this->get_char_allocator(), new_capacity * sizeof(entry_t), false));
+        assert(new_entries);
+
+        for (size_t i = 0; i < this->num_entries; i++) {
+            relocate_entry(&new_entries[i], &this->entries[i]);
+        }
+
+        if (this->entries) {
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(this->entries), this->entries_capacity * sizeof(entry_t));
+        }
+
+        this->entries          = new_entries;
+        this->entries_capacity = new_capacity;
+    }
+
+
+
+    /* Moves the element at <src> to the unconstructed entry <dst>. */
+    static HASH_CONTAINERS_INLINE
+    void relocate_entry(entry_t *dst, entry_t *src) {
+        dst->hash = src->hash;
+        internal::relocate(&dst->key,   src->key);
+        internal::relocate(&dst->value, src->value);
+    }
+
+
+
+    /* Destroys all the elements of the dense array. */
+    HASH_CONTAINERS_INLINE
+    void destroy_entries() {
+        for (size_t i = 0; i < this->num_entries; i++) {
+            internal::destroy(&this->entries[i].key);
+            internal::destroy(&this->entries[i].value);
+        }
+    }
+
+
+
+    /* Maps the key into the index table, returning the matching slot.
+     *
+     * Iterators are still valid after find_slot().
+     *
+     * Parameters:
+     *     <found>: (out) Set to true if the key was found in the container.
+     *     <key>  : The key to look-up.
+     *     <hash> : The hash of the <key> parameter.
+     *
+     * Returns:
+     *     If <found> is true, the slot holding the index of the element.
+     *     Otherwise, the empty slot that ended the probe sequence.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t find_slot(bool &found /*out*/, const K &key, size_t hash) const {
+
+        // The index table is never full, so the probe ends on an empty slot
+        size_t slot = hash & this->capacity_minus_1;
+
+        found = false;
+
+        while (true) {
+            const index_t index = this->indices[slot];
+
+            // Element doesn't exist
+            if (index == EMPTY) {
+                return slot;
+            }
+
+            // Found element
+            if (this->entries[index].hash == hash && this->entries[index].key == key) {
+                found = true;
+                return slot;
+            }
+
+            // Didn't find it, try the next spot until we do (and wrap around at the ends)
+            slot = (slot + 1) & this->capacity_minus_1;
+        }
+    }
+
+
+
+    /* Maps the key to the index of its element in the dense array.
+     *
+     * Returns:
+     *     The index of the element, or ~0 if the key isn't present.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_index(const K &key) const {
+
+        size_t hash = internal::call_const_hash(this->get_hash_functor(), key);
+
+        bool found;
+        const size_t slot = this->find_slot(found, key, hash);
+        return found ? this->indices[slot] : ~size_t(0);
+    }
+
+
+
+    /* Adds a new element to the end of the dense array. The element's key
+     * must *not* already be present.
+     *
+     * Iterators should be assumed to be invalid after add_new(). If copying
+     * the key or value throws, the table is left unchanged.
+     *
+     * Parameters:
+     *     <key>  : The key to store.
+     *     <value>: The value to store.
+     *     <hash> : The hash of the <key> parameter.
+     *
+     * Returns:
+     *     The index of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t add_new(const K &key, const V &value, size_t hash) {
+
+        // Keep the load factor of the index table at or below 1/2
+        if ((this->num_entries + 1) * 2 > this->capacity_minus_1 + 1) {
+            const size_t new_size = (this->capacity_minus_1 + 1) * 2;
+            this->resize_index_table(new_size > MIN_CAPACITY ? new_size : MIN_CAPACITY);
+        }
+        if (this->num_entries == this->entries_capacity) {
+            this->resize_entries(this->entries_capacity ? this->entries_capacity * 2 : MIN_CAPACITY / 2);
+        }
+
+        size_t slot = hash & this->capacity_minus_1;
+        while (this->indices[slot] != EMPTY) {
+            assert(!(this->entries[this->indices[slot]].hash == hash && this->entries[this->indices[slot]].key == key));
+            slot = (slot + 1) & this->capacity_minus_1;
+        }
+
+        entry_t *entry = &this->entries[this->num_entries];
+        entry->hash = hash;
+        internal::construct(&entry->key, key);
+        HASH_CONTAINERS_TRY {
+            internal::construct(&entry->value, value);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            internal::destroy(&entry->key);
+            HASH_CONTAINERS_RETHROW;
+        }
+
+        this->indices[slot] = index_t(this->num_entries);
+        return this->num_entries++;
+    }
+
+
+
+    /* Erases the element whose index is in slot <slot> of the index table.
+     *
+     * The last element of the dense array moves into the erased element's
+     * spot. Then, the contiguous span of slots after <slot> is rehashed, as
+     * erase_policy_rehash does.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void do_erase(size_t slot) {
+
+        const size_t index = this->indices[slot];
+        const size_t last  = this->num_entries - 1;
+
+        internal::destroy(&this->entries[index].key);
+        internal::destroy(&this->entries[index].value);
+
+        if (index != last) {
+            size_t last_slot = this->entries[last].hash & this->capacity_minus_1;
+            while (this->indices[last_slot] != last) {
+                last_slot = (last_slot + 1) & this->capacity_minus_1;
+            }
+            relocate_entry(&this->entries[index], &this->entries[last]);
+            this->indices[last_slot] = index_t(index);
+        }
+        this->num_entries--;
+
+        size_t hole = slot;
+        for (size_t slot2 = (hole + 1) & this->capacity_minus_1; this->indices[slot2] != EMPTY; slot2 = (slot2 + 1) & this->capacity_minus_1) {
+
+            const size_t home = this->entries[this->indices[slot2]].hash & this->capacity_minus_1;
+
+            if ((hole <= slot2) ? ((hole < home) && (home <= slot2)) : ((hole < home) || (home <= slot2))) {
+                continue;
+            }
+
+            this->indices[hole] = this->indices[slot2];
+            hole = slot2;
+        }
+        this->indices[hole] = EMPTY;
+    }
+
+
+
+    /* Containers can't be copied */
+    dense_hash_table(const dense_hash_table &);
+    dense_hash_table& operator=(const dense_hash_table &);
+
+
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor. No memory is allocated until the first insertion.
+     */
+    HASH_CONTAINERS_INLINE
+    dense_hash_table() {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit dense_hash_table(const allocator_type &alloc)
+        : allocator_holder_t(char_allocator_t(alloc)) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will hash keys with (a copy of)
+     * <hash>, and allocate memory through (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit dense_hash_table(const hash_functor &hash, const allocator_type &alloc = allocator_type())
+        : allocator_holder_t(char_allocator_t(alloc)),
+          hash_functor_holder_t(hash) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Destructor.
+     */
+    HASH_CONTAINERS_INLINE
+    ~dense_hash_table() {
+        this->destroy_entries();
+        if (this->entries) {
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(this->entries), this->entries_capacity * sizeof(entry_t));
+        }
+        if (!this->is_empty_table()) {
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(this->indices), (this->capacity_minus_1 + 1) * sizeof(index_t));
+        }
+    }
+
+
+
+    /* Inserts an element at the end of the container. If the specified key
+     * is already present, then 'false' is returned and the container is not
+     * modified.
+     *
+     * Iterators should be assumed to be invalid after insert(), if it
+     * returns 'true'.
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(const K &key, const V &value) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        this->find_slot(found, key, hash);
+        if (found) {
+            return false;
+        }
+        this->add_new(key, value, hash);
+        return true;
+    }
+
+
+
+    /* Erases an element from the table, if present. The last element of the
+     * container takes its place.
+     *
+     * Iterators to the last element are invalidated by erase().
+     */
+    HASH_CONTAINERS_INLINE
+    void erase(const K &key) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t slot = this->find_slot(found, key, hash);
+        if (found) {
+            this->do_erase(slot);
+        }
+    }
+
+
+
+    /* Returns the number of valid elements in the container. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->num_entries;
+    }
+
+
+
+    /* Returns the number of slots of the index table. */
+    HASH_CONTAINERS_INLINE
+    size_t capacity() const {
+        return this->is_empty_table() ? 0 : this->capacity_minus_1 + 1;
+    }
+
+
+
+    /* Returns a copy of the allocator of the container. */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return allocator_type(this->get_char_allocator());
+    }
+
+
+
+    /* Returns a copy of the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor hash_function() const {
+        return this->get_hash_functor();
+    }
+
+
+
+    /* Makes room for <num_elements> elements, both in the dense array and
+     * the index table, so that inserting them doesn't cause any
+     * reallocation.
+     */
+    void reserve(size_t num_elements) {
+        if (num_elements * 2 > this->capacity()) {
+            const size_t new_size = internal::round_up_to_next_power_of_2(num_elements * 2);
+            this->resize_index_table(new_size > MIN_CAPACITY ? new_size : MIN_CAPACITY);
+        }
+        if (num_elements > this->entries_capacity) {
+            this->resize_entries(num_elements);
+        }
+    }
+
+
+
+    /*******************************************************************
+     * Iterator interface
+     *******************************************************************/
+
+    class const_iterator;
+
+    /* Iterator for the container */
+    class iterator : public std::iterator<std::forward_iterator_tag,
+                                          std::pair<reference_wrapper<const K>, reference_wrapper<V> > > {
+
+        friend class dense_hash_table;
+        friend class const_iterator;
+
+    protected:
+
+        size_t            pos;
+        dense_hash_table* table;
+
+        iterator(size_t pos, dense_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        iterator(const iterator& other) : pos(other.pos), table(other.table) { }
+
+
+        operator const_iterator() const {
+            return const_iterator(this->pos, this->table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        iterator& operator=(const iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<V> > operator*() {
+            entry_t *entry = &this->table->entries[this->pos];
+            return std::pair<reference_wrapper<const K>, reference_wrapper<V> >(entry->key, entry->value);
+        }
+
+
+
+        iterator &operator++() {
+            this->pos = (this->pos + 1 < this->table->num_entries) ? this->pos + 1 : ~size_t(0);
+            return *this;
+        }
+
+
+
+        iterator operator++(int) {
+            const iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Constant Iterator for the container */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<reference_wrapper<const K>, reference_wrapper<const V> > > {
+
+        friend class dense_hash_table;
+        friend class iterator;
+
+    protected:
+
+        size_t                  pos;
+        const dense_hash_table* table;
+
+        const_iterator(size_t pos, const dense_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        const_iterator(const const_iterator& other) : pos(other.pos), table(other.table) { }
+        const_iterator(const       iterator& other) : pos(other.pos), table(other.table) { }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        const_iterator& operator=(const const_iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<const V> > operator*() {
+            const entry_t *entry = &this->table->entries[this->pos];
+            return std::pair<reference_wrapper<const K>, reference_wrapper<const V> >(entry->key, entry->value);
+        }
+
+
+
+        const_iterator &operator++() {
+            this->pos = (this->pos + 1 < this->table->num_entries) ? this->pos + 1 : ~size_t(0);
+            return *this;
+        }
+
+
+
+        const_iterator operator++(int) {
+            const const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Returns an iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator begin() {
+        return iterator(this->num_entries ? 0 : ~size_t(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    const_iterator cbegin() const {
+        return const_iterator(this->num_entries ? 0 : ~size_t(0), this);
+    }
+
+
+
+    /* Returns an iterator to one past the last element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator end() {
+        return iterator(~size_t(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to one past the last element in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator cend() const {
+        return const_iterator(~size_t(0), this);
+    }
+
+
+
+    /* Looks up the specified key and returns a reference to the corresponding
+     * value. If the key is not present in the container, then a value object
+     * is default-constructed and inserted at the end of the container, and
+     * then a reference to that object is returned.
+     *
+     * Because the operator can insert new elements, iterators are to be
+     * considered invalidated after use.
+     */
+    HASH_CONTAINERS_INLINE
+    V& operator[](const K& key) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t slot = this->find_slot(found, key, hash);
+
+        if (found) {
+            return this->entries[this->indices[slot]].value;
+        }
+        const size_t index = this->add_new(key, V(), hash);
+        return this->entries[index].value;
+    }
+
+
+
+    /* Counts the number of elements in the container matching the specified
+     * key: 0 or 1.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t count(const K& key) const {
+        return this->get_index(key) != ~size_t(0) ? 1 : 0;
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     A constant iterator to the element in the container. cend() is
+     *     returned if no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const K& key) const {
+        return const_iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     An iterator to the element in the container. end() is returned if
+     *     no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    iterator find(const K& key) {
+        return iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Clears the content of the container. The capacity of the container is
+     * unchanged.
+     *
+     * Iterators are invalidated by clear().
+     */
+    HASH_CONTAINERS_INLINE
+    void clear() {
+        if (this->is_empty_table()) {
+            return;
+        }
+
+        this->destroy_entries();
+        this->num_entries = 0;
+        memset(this->indices, 0xff, (this->capacity_minus_1 + 1) * sizeof(index_t));
+    }
+
+}; // class dense_hash_table
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_DENSE_HASH_TABLE_H_GUARD */
+
@@ -0,0 +1,607 @@
+/* Associative container for 8- and 16-bit keys, indexed directly by the key.
+ *
+ * With so few possible keys, a hash table is pure overhead: this container
+ * has one slot per possible key, and uses the key itself as the index of its
+ * slot. There is no hashing and no probing. A bitmap records which slots are
+ * in use; it has the same layout as the meta-data of erase_policy_rehash, so
+ * iteration reuses its code.
+ *
+ * The API is the same as closed_linear_probing_hash_table's. Memory is
+ * allocated on the first insertion, for all the slots at once, so the
+ * container suits tables that end up holding a good fraction of the keys.
+ *
+ * Objects must either be POD types, or must provide the appropriate ctors and
+ * assignment operators.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_DIRECT_INDEX_TABLE_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_DIRECT_INDEX_TABLE_H_GUARD 1
+
+#include <assert.h>   // For assert
+#include <iterator>   // For std::iterator<>
+#include <string.h>   // For memset
+#include "common.h"
+#include "closed_linear_probing_hash_table.h"
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     direct_index_table<K, V,
+ *                        allocator = table_allocator<char>
+ *                        >
+ *
+ * Objects of this class are associative containers mapping objects of type
+ * <K> to objects of type <V>.
+ *
+ * Template Parameters:
+ *    <K>           : the type of the key of the associative container. Must
+ *                    be an integer type of 8 or 16 bits.
+ *    <V>           : the type of the value of the associative container.
+ *    <allocator>   : the allocator used for the table's memory block. It is
+ *                    rebound to char.
+ */
+template <typename K,
+          typename V,
+          typename allocator = table_allocator<char>
+          >
+class direct_index_table : private internal::ebo_holder<typename internal::rebind_alloc<allocator, char>::type, 0> {
+
+    typedef erase_policy_rehash::meta_t meta_t;
+
+    typedef typename internal::rebind_alloc<allocator, char>::type char_allocator_t;
+    typedef internal::ebo_holder<char_allocator_t, 0>             allocator_holder_t;
+
+    /* One slot per possible key */
+    static const size_t CAPACITY  = size_t(1) << (sizeof(K) * CHAR_BIT);
+    static const size_t NUM_WORDS = CAPACITY / erase_policy_rehash::META_ELEMENTS_PER_WORD;
+
+    /* Compile-time check that keys are 8 or 16 bits */
+    typedef char key_size_check_t[(sizeof(K) <= 2) ? 1 : -1];
+
+
+    meta_t *valid;      // Bitmap of the slots in use
+    K      *key_table;  // Slot i holds key i, once used; iterators refer to it
+    V      *value_table;
+    size_t  num_elements;
+    char   *memory;     // Heap block holding the arrays, or NULL
+
+
+    /* Returns the allocator used for the table's memory block. */
+    HASH_CONTAINERS_INLINE
+    char_allocator_t &get_char_allocator() {
+        return static_cast<allocator_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const char_allocator_t &get_char_allocator() const {
+        return static_cast<const allocator_holder_t&>(*this).get();
+    }
+
+
+
+    /* Returns the slot of <key>. Signed keys map to the upper half. */
+    static HASH_CONTAINERS_INLINE
+    size_t get_slot(const K &key) {
+        return size_t(key) & (CAPACITY - 1);
+    }
+
+
+
+    /* Returns the size, in bytes, of the memory block holding the arrays.
+     * Each array starts on a cache line boundary.
+     */
+    static HASH_CONTAINERS_INLINE
+    size_t get_memory_size() {
+        return internal::round_up_to_cache_line(NUM_WORDS * sizeof(meta_t))
+             + internal::round_up_to_cache_line(CAPACITY * sizeof(K))
+             + CAPACITY * sizeof(V)
+             + HASH_CONTAINERS_CACHE_LINE_SIZE - 1;
+    }
+
+
+
+    /* Allocates the table's memory block, with all slots unused. */
+    HASH_CONTAINERS_NO_INLINE
+    void allocate_table() {
+
+        assert(!this->memory);
+
+        this->memory = internal::allocate_block(this->get_char_allocator(), get_memory_size(), false);
+        assert(this->memory);
+
+        char *base = internal::align_to_cache_line(this->memory);
+
+        const size_t K_offs =          internal::round_up_to_cache_line(NUM_WORDS * sizeof(meta_t));
+        const size_t V_offs = K_offs + internal::round_up_to_cache_line(CAPACITY * sizeof(K));
+
+        this->valid       = reinterpret_cast<meta_t*>(base);
+        this->key_table   = reinterpret_cast<K*>(base + K_offs);
+        this->value_table = reinterpret_cast<V*>(base + V_offs);
+
+        memset(this->valid, 0, NUM_WORDS * sizeof(meta_t));
+    }
+
+
+
+    /* Checks whether slot <idx> holds an element. */
+    HASH_CONTAINERS_INLINE
+    bool is_used(size_t idx) const {
+        return (this->valid[idx / erase_policy_rehash::META_ELEMENTS_PER_WORD] >> (idx & (erase_policy_rehash::META_ELEMENTS_PER_WORD - 1))) & 1;
+    }
+
+
+
+    /* Returns the slot of <key> if it holds an element, ~0 otherwise. */
+    HASH_CONTAINERS_INLINE
+    size_t get_index(const K &key) const {
+        const size_t idx = get_slot(key);
+        return (this->memory && this->is_used(idx)) ? idx : ~size_t(0);
+    }
+
+
+
+    /* Stores a new element in the slot of <key>, which must be unused.
+     *
+     * Returns:
+     *     The slot of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t add_new(const K &key, const V &value) {
+
+        if (!this->memory) {
+            this->allocate_table();
+        }
+
+        const size_t idx = get_slot(key);
+        assert(!this->is_used(idx));
+
+        internal::construct(&this->key_table[idx],   key);
+        internal::construct(&this->value_table[idx], value);
+        this->valid[idx / erase_policy_rehash::META_ELEMENTS_PER_WORD] |= meta_t(1) << (idx & (erase_policy_rehash::META_ELEMENTS_PER_WORD - 1));
+        this->num_elements++;
+        return idx;
+    }
+
+
+
+    /* Destroys all the elements, leaving the bitmap as-is. */
+    HASH_CONTAINERS_INLINE
+    void destroy_elements() {
+        if (!this->num_elements) {
+            return;
+        }
+        for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
+            internal::destroy(&this->key_table[i]);
+            internal::destroy(&this->value_table[i]);
+        }
+    }
+
+
+
+    /* For forward iterating. */
+    HASH_CONTAINERS_INLINE
+    size_t get_first() const {
+        if (!this->memory) {
+            return ~size_t(0);
+        }
+        return erase_policy_rehash::get_first(CAPACITY - 1, this->valid);
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    size_t get_next(size_t old_pos) const {
+
+        assert(old_pos != ~size_t(0));
+
+        meta_t *valid_ptr = &this->valid[old_pos / erase_policy_rehash::META_ELEMENTS_PER_WORD];
+
+        return erase_policy_rehash::get_next(old_pos, valid_ptr, NUM_WORDS);
+    }
+
+
+
+    /* Containers can't be copied */
+    direct_index_table(const direct_index_table &);
+    direct_index_table& operator=(const direct_index_table &);
+
+
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor. No memory is allocated until the first insertion.
+     */
+    HASH_CONTAINERS_INLINE
+    direct_index_table() : valid(NULL), key_table(NULL), value_table(NULL), num_elements(0), memory(NULL) { }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit direct_index_table(const allocator_type &alloc)
+        : allocator_holder_t(char_allocator_t(alloc)),
+          valid(NULL), key_table(NULL), value_table(NULL), num_elements(0), memory(NULL) { }
+
+
+
+    /* Destructor.
+     */
+    HASH_CONTAINERS_INLINE
+    ~direct_index_table() {
+        this->destroy_elements();
+        if (this->memory) {
+            internal::deallocate_block(this->get_char_allocator(), this->memory, get_memory_size());
+        }
+    }
+
+
+
+    /* Inserts an element in the container. If the specified key is already
+     * present, then 'false' is returned and the container is not modified.
+     *
+     * Iterators are still valid after insert().
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(const K &key, const V &value) {
+        if (this->get_index(key) != ~size_t(0)) {
+            return false;
+        }
+        this->add_new(key, value);
+        return true;
+    }
+
+
+
+    /* Erases an element from the container, if present.
+     *
+     * Iterators to other elements are still valid after erase().
+     */
+    HASH_CONTAINERS_INLINE
+    void erase(const K &key) {
+        const size_t idx = this->get_index(key);
+        if (idx == ~size_t(0)) {
+            return;
+        }
+
+        internal::destroy(&this->key_table[idx]);
+        internal::destroy(&this->value_table[idx]);
+        this->valid[idx / erase_policy_rehash::META_ELEMENTS_PER_WORD] &= ~(meta_t(1) << (idx & (erase_policy_rehash::META_ELEMENTS_PER_WORD - 1)));
+        this->num_elements--;
+    }
+
+
+
+    /* Returns the number of valid elements in the container. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->num_elements;
+    }
+
+
+
+    /* Returns the number of slots of the container: 0 until the first
+     * insertion, and then one per possible key.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t capacity() const {
+        return this->memory ? CAPACITY : 0;
+    }
+
+
+
+    /* Returns a copy of the allocator of the container. */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return allocator_type(this->get_char_allocator());
+    }
+
+
+
+    /* Allocates the table's memory block, if <new_capacity> isn't 0. */
+    void reserve(size_t new_capacity) {
+        if (new_capacity && !this->memory) {
+            this->allocate_table();
+        }
+    }
+
+
+
+    /*******************************************************************
+     * Iterator interface
+     *******************************************************************/
+
+    class const_iterator;
+
+    /* Iterator for the container */
+    class iterator : public std::iterator<std::forward_iterator_tag,
+                                          std::pair<reference_wrapper<const K>, reference_wrapper<V> > > {
+
+        friend class direct_index_table;
+        friend class const_iterator;
+
+    protected:
+
+        size_t              pos;
+        direct_index_table* table;
+
+        iterator(size_t pos, direct_index_table* table) : pos(pos), table(table) { }
+
+    public:
+        iterator(const iterator& other) : pos(other.pos), table(other.table) { }
+
+
+        operator const_iterator() const {
+            return const_iterator(this->pos, this->table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        iterator& operator=(const iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<V> > operator*() {
+            return std::pair<reference_wrapper<const K>, reference_wrapper<V> >(this->table->key_table[this->pos], this->table->value_table[this->pos]);
+        }
+
+
+
+        iterator &operator++() {
+            this->pos = this->table->get_next(this->pos);
+            return *this;
+        }
+
+
+
+        iterator operator++(int) {
+            const iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Constant Iterator for the container */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<reference_wrapper<const K>, reference_wrapper<const V> > > {
+
+        friend class direct_index_table;
+        friend class iterator;
+
+    protected:
+
+        size_t                    pos;
+        const direct_index_table* table;
+
+        const_iterator(size_t pos, const direct_index_table* table) : pos(pos), table(table) { }
+
+    public:
+        const_iterator(const const_iterator& other) : pos(other.pos), table(other.table) { }
+        const_iterator(const       iterator& other) : pos(other.pos), table(other.table) { }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        const_iterator& operator=(const const_iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<const V> > operator*() {
+            return std::pair<reference_wrapper<const K>, reference_wrapper<const V> >(this->table->key_table[this->pos], this->table->value_table[this->pos]);
+        }
+
+
+
+        const_iterator &operator++() {
+            this->pos = this->table->get_next(this->pos);
+            return *this;
+        }
+
+
+
+        const_iterator operator++(int) {
+            const const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Returns an iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator begin() {
+        return iterator(this->get_first(), this);
+    }
+
+
+
+    /* Returns a constant iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    const_iterator cbegin() const {
+        return const_iterator(this->get_first(), this);
+    }
+
+
+
+    /* Returns an iterator to one past the last element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator end() {
+        return iterator(~size_t(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to one past the last element in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator cend() const {
+        return const_iterator(~size_t(0), this);
+    }
+
+
+
+    /* Looks up the specified key and returns a reference to the corresponding
+     * value. If the key is not present in the container, then a value object
+     * is default-constructed and inserted in the container, and then a
+     * reference to that object is returned.
+     *
+     * Elements never move, so iterators are still valid after use.
+     */
+    HASH_CONTAINERS_INLINE
+    V& operator[](const K& key) {
+        size_t idx = this->get_index(key);
+        if (idx == ~size_t(0)) {
+            idx = this->add_new(key, V());
+        }
+        return this->value_table[idx];
+    }
+
+
+
+    /* Counts the number of elements in the container matching the specified
+     * key: 0 or 1.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t count(const K& key) const {
+        return this->get_index(key) != ~size_t(0) ? 1 : 0;
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     A constant iterator to the element in the container. cend() is
+     *     returned if no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const K& key) const {
+        return const_iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     An iterator to the element in the container. end() is returned if
+     *     no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    iterator find(const K& key) {
+        return iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Clears the content of the container. The memory block is kept.
+     *
+     * Iterators are invalidated by clear().
+     */
+    HASH_CONTAINERS_INLINE
+    void clear() {
+        if (!this->memory) {
+            return;
+        }
+
+        this->destroy_elements();
+        this->num_elements = 0;
+        memset(this->valid, 0, NUM_WORDS * sizeof(meta_t));
+    }
+
+}; // class direct_index_table
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_DIRECT_INDEX_TABLE_H_GUARD */
+
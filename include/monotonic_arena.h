@@ -0,0 +1,288 @@
+/* Monotonic memory arena, and an allocator drawing from it.
+ *
+ * An arena hands out memory by bumping a pointer through large chunks, and
+ * never frees individual allocations. All the memory is given back at once,
+ * when the arena is released or destroyed. This suits many short-lived
+ * containers (e.g. the hash tables used while serving one request): growing
+ * a table costs a pointer bump instead of a malloc(), and the abandoned
+ * smaller table blocks simply stay in the arena until it is released.
+ *
+ * Usage:
+ *     hash_containers::monotonic_arena arena;
+ *     {
+ *         typedef hash_containers::closed_linear_probing_hash_table<
+ *                     K, V, hash, hash_containers::erase_policy_rehash, 32,
+ *                     hash_containers::arena_allocator<char> > table_t;
+ *         table_t table((hash_containers::arena_allocator<char>(&arena)));
+ *         ...
+ *     } // Containers must be destroyed before the arena is released
+ *     arena.release();
+ *
+ * In C++17, std::pmr::polymorphic_allocator<> on top of a
+ * std::pmr::monotonic_buffer_resource can also be used as the allocator of
+ * the containers. As with the standard containers, copies of a container
+ * then draw from the default resource, not the arena, and assignments and
+ * swaps keep each container's resource: only swap containers sharing one.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_MONOTONIC_ARENA_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_MONOTONIC_ARENA_H_GUARD 1
+
+#include <assert.h>   // For assert
+#include <stdlib.h>   // For malloc
+#include <stddef.h>   // For size_t, ptrdiff_t
+#include "common.h"
+
+
+/* Alignment of all the allocations from an arena. Must be a power of 2. */
+#ifndef HASH_CONTAINERS_ARENA_ALIGNMENT
+#define HASH_CONTAINERS_ARENA_ALIGNMENT 16
+#endif
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     monotonic_arena
+ *
+ * Bump allocator over a list of chunks. Chunks are allocated with malloc(),
+ * each one twice as large as the previous one, unless a single allocation
+ * needs more.
+ *
+ * The caller can optionally supply the first chunk (e.g. a buffer on the
+ * stack), which the arena will not free.
+ *
+ * Not thread-safe.
+ */
+class monotonic_arena {
+
+    /* Header at the start of each malloc()'d chunk */
+    struct chunk_t {
+        chunk_t *next;
+        size_t   size;
+    };
+
+    chunk_t *chunks;          // List of malloc()'d chunks, latest first
+    char    *cur;             // Next free byte in the current chunk
+    char    *end;             // End of the current chunk
+    char    *initial_buffer;  // Caller-supplied first chunk, if any
+    size_t   initial_size;
+    size_t   next_chunk_size;
+
+
+    /* Arenas can't be copied */
+    monotonic_arena(const monotonic_arena &);
+    monotonic_arena& operator=(const monotonic_arena &);
+
+
+    HASH_CONTAINERS_INLINE
+    static char *align_up(char *p) {
+        return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(p) + HASH_CONTAINERS_ARENA_ALIGNMENT - 1) & ~uintptr_t(HASH_CONTAINERS_ARENA_ALIGNMENT - 1));
+    }
+
+
+
+    /* Allocates a new chunk big enough for <size> bytes, and makes it the
+     * current chunk.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void *allocate_from_new_chunk(size_t size) {
+
+        const size_t header_size = (sizeof(chunk_t) + HASH_CONTAINERS_ARENA_ALIGNMENT - 1) & ~size_t(HASH_CONTAINERS_ARENA_ALIGNMENT - 1);
+
+        size_t chunk_size = this->next_chunk_size;
+        while (chunk_size < header_size + size + HASH_CONTAINERS_ARENA_ALIGNMENT) {
+            chunk_size *= 2;
+        }
+        this->next_chunk_size = chunk_size * 2;
+
+        chunk_t *chunk = static_cast<chunk_t*>(malloc(chunk_size));
+        assert(chunk);
+        if (!chunk) {
+            return NULL;
+        }
+
+        chunk->next  = this->chunks;
+        chunk->size  = chunk_size;
+        this->chunks = chunk;
+
+        this->cur = align_up(reinterpret_cast<char*>(chunk) + header_size);
+        this->end = reinterpret_cast<char*>(chunk) + chunk_size;
+
+        char *memory = this->cur;
+        this->cur += size;
+        return memory;
+    }
+
+
+
+public:
+    /* Constructs an empty arena. No memory is allocated until the first
+     * allocation.
+     *
+     * Parameters:
+     *     <first_chunk_size>: The size, in bytes, of the first chunk.
+     */
+    explicit monotonic_arena(size_t first_chunk_size = 4096)
+        : chunks(NULL), cur(NULL), end(NULL), initial_buffer(NULL),
+          initial_size(0), next_chunk_size(first_chunk_size ? first_chunk_size : 1) { }
+
+
+
+    /* Constructs an arena that first allocates from the caller-supplied
+     * <buffer> of <size> bytes. The buffer must outlive the arena, and is
+     * never freed by it.
+     */
+    monotonic_arena(void *buffer, size_t size)
+        : chunks(NULL), initial_buffer(static_cast<char*>(buffer)),
+          initial_size(size), next_chunk_size(size ? size : 4096) {
+        this->cur = align_up(this->initial_buffer);
+        this->end = this->initial_buffer + size;
+    }
+
+
+
+    /* Destructor. Releases all the memory of the arena. */
+    ~monotonic_arena() {
+        this->release();
+    }
+
+
+
+    /* Allocates <size> bytes from the arena, aligned to
+     * HASH_CONTAINERS_ARENA_ALIGNMENT.
+     *
+     * Returns:
+     *     A pointer to the memory, or NULL if out of memory.
+     */
+    HASH_CONTAINERS_INLINE
+    void *allocate(size_t size) {
+        char *memory = align_up(this->cur);
+        if (this->cur && memory <= this->end && size <= size_t(this->end - memory)) {
+            this->cur = memory + size;
+            return memory;
+        }
+        return this->allocate_from_new_chunk(size);
+    }
+
+
+
+    /* Does nothing: memory is only given back by release(). */
+    HASH_CONTAINERS_INLINE
+    void deallocate(void * /*memory*/, size_t /*size*/) { }
+
+
+
+    /* Releases all the memory allocated from the arena at once. The
+     * containers using the arena must have been destroyed beforehand.
+     *
+     * The arena can be reused afterwards. It restarts from the caller-supplied
+     * buffer, if any.
+     */
+    void release() {
+        while (this->chunks) {
+            chunk_t *next = this->chunks->next;
+            free(this->chunks);
+            this->chunks = next;
+        }
+        this->cur = this->initial_buffer ? align_up(this->initial_buffer) : NULL;
+        this->end = this->initial_buffer ? this->initial_buffer + this->initial_size : NULL;
+    }
+};
+
+
+
+/* Class:
+ *     arena_allocator<T>
+ *
+ * Allocator drawing from a monotonic_arena. Deallocation does nothing; the
+ * memory is reclaimed when the arena is released.
+ *
+ * Copies of the allocator share the same arena, and compare equal.
+ */
+template <typename T>
+class arena_allocator {
+
+    template <typename U> friend class arena_allocator;
+
+    monotonic_arena *arena;
+
+public:
+    typedef T         value_type;
+    typedef T*        pointer;
+    typedef const T*  const_pointer;
+    typedef T&        reference;
+    typedef const T&  const_reference;
+    typedef size_t    size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef arena_allocator<U> other;
+    };
+
+    arena_allocator(monotonic_arena *arena) : arena(arena) {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n, const void * /*hint*/ = 0) {
+        return static_cast<T*>(this->arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) {
+        this->arena->deallocate(p, n * sizeof(T));
+    }
+
+    size_t max_size() const {
+        return ~size_t(0) / sizeof(T);
+    }
+
+    monotonic_arena *get_arena() const {
+        return this->arena;
+    }
+
+    /* Pre-C++11 allocator requirements */
+    T       *address(T       &x) const { return internal::addressof(x); }
+    const T *address(const T &x) const { return internal::addressof(const_cast<T&>(x)); }
+
+    void construct(T *p, const T &v) { internal::construct(p, v); }
+    void destroy(T *p)               { internal::destroy(p); }
+};
+
+template <typename T, typename U>
+HASH_CONTAINERS_INLINE
+bool operator==(const arena_allocator<T> &a, const arena_allocator<U> &b) { return a.get_arena() == b.get_arena(); }
+
+template <typename T, typename U>
+HASH_CONTAINERS_INLINE
+bool operator!=(const arena_allocator<T> &a, const arena_allocator<U> &b) { return a.get_arena() != b.get_arena(); }
+
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_MONOTONIC_ARENA_H_GUARD */
+
@@ -0,0 +1,991 @@
+/* Associative container, hash table of pointers to stable nodes.
+ *
+ * The elements are stored in nodes, which are carved out of slabs owned by
+ * the container. The hash table itself only holds pointers to the nodes,
+ * with linear probing on conflicts. So:
+ *   - elements never move: pointers and references to keys and values stay
+ *     valid until the element is erased, even as the table grows;
+ *   - growing the table only rehashes the pointers, using the hash kept in
+ *     each node;
+ *   - nodes don't need one allocation each, unlike std::unordered_map's.
+ *
+ * The low bits of the pointers, which are always 0 due to the alignment of
+ * the nodes, hold a few bits of the hash of the key. Most mismatching slots
+ * are thus skipped without dereferencing their node.
+ *
+ * Erased nodes are recycled by later insertions. The slabs are only
+ * released when the container is destroyed.
+ *
+ * Objects must either be POD types, or must provide the appropriate ctors and
+ * assignment operators.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_NODE_HASH_TABLE_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_NODE_HASH_TABLE_H_GUARD 1
+
+#include <assert.h>   // For assert
+#include <iterator>   // For std::iterator<>
+#include <string.h>   // For memset
+#include "common.h"
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     node_hash_table<K, V,
+ *                     hash_functor = std::hash<K>, // C++11
+ *                     allocator    = table_allocator<char>
+ *                     >
+ *
+ * Objects of this class are associative containers mapping objects of type
+ * <K> to objects of type <V>, using the hash function <hash_functor>.
+ *
+ * Template Parameters:
+ *    <K>           : the type of the key of the associative container.
+ *    <V>           : the type of the value of the associative container.
+ *    <hash_functor>: a functor that will hash the key to a size_t. Default
+ *                    value is only provided in C++11. It is stored in the
+ *                    container, so it can hold state such as a seed (see
+ *                    seeded_hash<>); empty functors take no space.
+ *    <allocator>   : the allocator used for the table and the slabs. It is
+ *                    rebound to char.
+ */
+template <typename K,
+          typename V,
+#if __cplusplus >= 201103L
+          typename hash_functor = std::hash<K>,
+#else
+          typename hash_functor,
+#endif
+          typename allocator = table_allocator<char>
+          >
+class node_hash_table;
+
+
+
+namespace internal {
+
+    /* An element of a node hash table. */
+    template <typename K, typename V>
+    struct node_hash_table_node_t {
+        size_t hash;
+        K      key;
+        V      value;
+    };
+
+
+
+    /* Pool of fixed-size nodes of type <T>, carved out of slabs.
+     *
+     * Slabs are allocated as needed, each one twice as large as the previous
+     * one, up to MAX_SLAB_NODES nodes. Released nodes go on a free list,
+     * which is threaded through the nodes themselves. The pool neither
+     * constructs nor destroys the nodes.
+     *
+     * The allocator is passed to each method, so that the owner of the pool
+     * can store it.
+     */
+    template <typename T>
+    class slab_pool_t {
+
+        /* Header at the start of each slab */
+        struct slab_t {
+            slab_t *next;
+            size_t  num_nodes;
+        };
+
+        union free_node_t {
+            free_node_t *next;
+            char         bytes[sizeof(T)];
+        };
+
+        static const size_t MIN_SLAB_NODES = 16;
+        static const size_t MAX_SLAB_NODES = 4096;
+
+        slab_t      *slabs;
+        free_node_t *free_list;
+        T           *bump;          // Next never-used node of the current slab
+        T           *bump_end;
+        size_t       total_nodes;   // In all slabs
+
+
+        /* Nodes start on the first cache line after the header */
+        static HASH_CONTAINERS_INLINE
+        size_t get_header_size() {
+            return round_up_to_cache_line(sizeof(slab_t));
+        }
+
+
+
+        template <typename A>
+        HASH_CONTAINERS_NO_INLINE
+        void add_slab(A &alloc, size_t num_nodes) {
+            char *memory = allocate_block(alloc, get_header_size() + num_nodes * sizeof(T), false);
+            assert(memory);
+
+            slab_t *slab    = reinterpret_cast<slab_t*>(memory);
+            slab->next      = this->slabs;
+            slab->num_nodes = num_nodes;
+            this->slabs     = slab;
+
+            this->total_nodes += num_nodes;
+
+            this->bump     = reinterpret_cast<T*>(memory + get_header_size());
+            this->bump_end = this->bump + num_nodes;
+        }
+
+
+
+    public:
+        slab_pool_t() : slabs(NULL), free_list(NULL), bump(NULL), bump_end(NULL), total_nodes(0) { }
+
+
+
+        /* Returns the storage for one node. */
+        template <typename A>
+        HASH_CONTAINERS_INLINE
+        T *allocate(A &alloc) {
+            if (this->free_list) {
+                free_node_t *node = this->free_list;
+                this->free_list = node->next;
+                return reinterpret_cast<T*>(node);
+            }
+            if (this->bump == this->bump_end) {
+                const size_t num_nodes = this->slabs ? this->slabs->num_nodes * 2 : MIN_SLAB_NODES;
+                this->add_slab(alloc, num_nodes < MAX_SLAB_NODES ? num_nodes : MAX_SLAB_NODES);
+            }
+            return this->bump++;
+        }
+
+
+
+        /* Returns a node to the pool, for reuse by allocate(). */
+        HASH_CONTAINERS_INLINE
+        void release(T *node) {
+            free_node_t *free_node = reinterpret_cast<free_node_t*>(node);
+            free_node->next = this->free_list;
+            this->free_list = free_node;
+        }
+
+
+
+        /* Makes sure that the next <num_nodes> calls to allocate() don't
+         * allocate memory, given <num_allocated> nodes currently in use.
+         */
+        template <typename A>
+        void reserve(A &alloc, size_t num_nodes, size_t num_allocated) {
+            const size_t available = this->total_nodes - num_allocated;
+
+            if (num_nodes > available) {
+                // Keep the rest of the current slab on the free list
+                while (this->bump != this->bump_end) {
+                    this->release(this->bump++);
+                }
+                this->add_slab(alloc, num_nodes - available);
+            }
+        }
+
+
+
+        /* Releases all the slabs. All nodes must have been destroyed. */
+        template <typename A>
+        void free_all(A &alloc) {
+            while (this->slabs) {
+                slab_t *next = this->slabs->next;
+                deallocate_block(alloc, reinterpret_cast<char*>(this->slabs), get_header_size() + this->slabs->num_nodes * sizeof(T));
+                this->slabs = next;
+            }
+            this->free_list = NULL;
+            this->bump      = NULL;
+            this->bump_end  = NULL;
+            this->total_nodes = 0;
+        }
+    };
+
+
+
+    /* Table of empty node hash tables: a single, empty, slot. It is never
+     * written to.
+     */
+    template <typename slot_t>
+    struct empty_table_slots {
+        static const slot_t slots[1];
+    };
+
+    template <typename slot_t>
+    const slot_t empty_table_slots<slot_t>::slots[1] = { 0 };
+} // namespace internal
+
+
+/***************************************************************************
+ */
+
+template <typename K,
+          typename V,
+          typename hash_functor,
+          typename allocator>
+class node_hash_table : private internal::ebo_holder<typename internal::rebind_alloc<allocator, char>::type, 0>,
+                        private internal::ebo_holder<hash_functor, 1> {
+
+    typedef internal::node_hash_table_node_t<K, V> node_t;
+    typedef uintptr_t                              slot_t;
+
+    typedef typename internal::rebind_alloc<allocator, char>::type char_allocator_t;
+    typedef internal::ebo_holder<char_allocator_t, 0>             allocator_holder_t;
+    typedef internal::ebo_holder<hash_functor, 1>                 hash_functor_holder_t;
+
+    /* Bits of the slots that hold hash bits rather than pointer bits. Nodes
+     * are at least aligned on size_t.
+     */
+    static const slot_t TAG_MASK = (sizeof(size_t) >= 8) ? 7 : 3;
+
+    /* Capacity of the first table allocated. */
+    static const size_t MIN_CAPACITY = 16;
+
+
+    slot_t                        *slots;     // 0 for empty slots
+    size_t                         num_nodes;
+    size_t                         capacity_minus_1;
+    internal::slab_pool_t<node_t>  pool;
+
+
+    /* Returns the allocator used for the container's memory. */
+    HASH_CONTAINERS_INLINE
+    char_allocator_t &get_char_allocator() {
+        return static_cast<allocator_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const char_allocator_t &get_char_allocator() const {
+        return static_cast<const allocator_holder_t&>(*this).get();
+    }
+
+
+
+    /* Returns the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor &get_hash_functor() {
+        return static_cast<hash_functor_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const hash_functor &get_hash_functor() const {
+        return static_cast<const hash_functor_holder_t&>(*this).get();
+    }
+
+
+
+    /* Points the container at the shared, read-only, empty table. */
+    HASH_CONTAINERS_INLINE
+    void init_empty_table() {
+        this->slots            = const_cast<slot_t*>(&internal::empty_table_slots<slot_t>::slots[0]);
+        this->num_nodes        = 0;
+        this->capacity_minus_1 = 0;
+    }
+
+
+
+    /* Checks whether the container is using the shared empty table. */
+    HASH_CONTAINERS_INLINE
+    bool is_empty_table() const {
+        return this->slots == &internal::empty_table_slots<slot_t>::slots[0];
+    }
+
+
+
+    /* Returns the tag of a hash, stored in the low bits of the slots. The
+     * hash is mixed first: its low bits select the slot, and the top bits of
+     * weak hashes (such as the identity std::hash<> of integers) are often 0.
+     */
+    static HASH_CONTAINERS_INLINE
+    slot_t get_tag(size_t hash) {
+        return slot_t(internal::mix64(uint64_t(hash))) & TAG_MASK;
+    }
+
+
+
+    static HASH_CONTAINERS_INLINE
+    node_t *get_node(slot_t slot) {
+        return reinterpret_cast<node_t*>(slot & ~TAG_MASK);
+    }
+
+
+
+    static HASH_CONTAINERS_INLINE
+    slot_t make_slot(node_t *node) {
+        assert((reinterpret_cast<slot_t>(node) & TAG_MASK) == 0);
+        return reinterpret_cast<slot_t>(node) | get_tag(node->hash);
+    }
+
+
+
+    /* Replaces the table by one of <new_size> slots, and re-inserts all the
+     * node pointers, using the hashes stored in the nodes.
+     *
+     * Parameters:
+     *     <new_size>: The new size of the table. Must be a power of 2, and
+     *                 at least twice the number of elements.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void resize_table(size_t new_size) {
+
+        assert((new_size & (new_size - 1)) == 0);
+        assert(new_size >= this->num_nodes * 2);
+
+        slot_t *new_slots = reinterpret_cast<slot_t*>(internal::allocate_block(this->get_char_allocator(), new_size * sizeof(slot_t), true));
+        assert(new_slots);
+
+        if (!this->is_empty_table()) {
+            for (size_t i = 0; i <= this->capacity_minus_1; i++) {
+                const slot_t slot = this->slots[i];
+                if (!slot) {
+                    continue;
+                }
+
+                size_t new_pos = get_node(slot)->hash & (new_size - 1);
+                while (new_slots[new_pos]) {
+                    new_pos = (new_pos + 1) & (new_size - 1);
+                }
+                new_slots[new_pos] = slot;
+            }
+
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(this->slots), (this->capacity_minus_1 + 1) * sizeof(slot_t));
+        }
+
+        this->slots            = new_slots;
+        this->capacity_minus_1 = new_size - 1;
+    }
+
+
+
+    /* Destroys all the elements, returning their nodes to the pool. */
+    HASH_CONTAINERS_INLINE
+    void destroy_nodes() {
+        if (!this->num_nodes) {
+            return;
+        }
+        for (size_t i = 0; i <= this->capacity_minus_1; i++) {
+            if (this->slots[i]) {
+                node_t *node = get_node(this->slots[i]);
+                internal::destroy(&node->key);
+                internal::destroy(&node->value);
+                this->pool.release(node);
+            }
+        }
+    }
+
+
+
+    /* Maps the key to a position in the table.
+     *
+     * Iterators are still valid after find_pos().
+     *
+     * Parameters:
+     *     <found>: (out) Set to true if the key was found in the container.
+     *     <key>  : The key to look-up.
+     *     <hash> : The hash of the <key> parameter.
+     *
+     * Returns:
+     *     If <found> is true, the position of the slot pointing to the
+     *     element. Otherwise, the empty slot that ended the probe sequence.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t find_pos(bool &found /*out*/, const K &key, size_t hash) const {
+
+        // The table is never full, so the probe ends on an empty slot
+        const slot_t tag = get_tag(hash);
+        size_t       pos = hash & this->capacity_minus_1;
+
+        found = false;
+
+        while (true) {
+            const slot_t slot = this->slots[pos];
+
+            // Element doesn't exist
+            if (!slot) {
+                return pos;
+            }
+
+            // Found element. Only dereference the node if the tags match.
+            if ((slot & TAG_MASK) == tag) {
+                const node_t *node = get_node(slot);
+                if (node->hash == hash && node->key == key) {
+                    found = true;
+                    return pos;
+                }
+            }
+
+            // Didn't find it, try the next spot until we do (and wrap around at the ends)
+            pos = (pos + 1) & this->capacity_minus_1;
+        }
+    }
+
+
+
+    /* Maps the key to the position of its slot.
+     *
+     * Returns:
+     *     The position of the slot, or ~0 if the key isn't present.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_index(const K &key) const {
+
+        size_t hash = internal::call_const_hash(this->get_hash_functor(), key);
+
+        bool found;
+        const size_t pos = this->find_pos(found, key, hash);
+        return found ? pos : ~size_t(0);
+    }
+
+
+
+    /* Adds a new element to the container. The element's key must *not*
+     * already be present.
+     *
+     * Iterators should be assumed to be invalid after add_new(). Pointers
+     * and references to elements stay valid. If copying the key or value
+     * throws, the node goes back to the pool.
+     *
+     * Parameters:
+     *     <key>  : The key to store.
+     *     <value>: The value to store.
+     *     <hash> : The hash of the <key> parameter.
+     *
+     * Returns:
+     *     The node of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    node_t *add_new(const K &key, const V &value, size_t hash) {
+
+        // Keep the load factor at or below 1/2
+        if ((this->num_nodes + 1) * 2 > this->capacity_minus_1 + 1) {
+            const size_t new_size = (this->capacity_minus_1 + 1) * 2;
+            this->resize_table(new_size > MIN_CAPACITY ? new_size : MIN_CAPACITY);
+        }
+
+        size_t pos = hash & this->capacity_minus_1;
+        while (this->slots[pos]) {
+            pos = (pos + 1) & this->capacity_minus_1;
+        }
+
+        node_t *node = this->pool.allocate(this->get_char_allocator());
+        node->hash = hash;
+        HASH_CONTAINERS_TRY {
+            internal::construct(&node->key, key);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->pool.release(node);
+            HASH_CONTAINERS_RETHROW;
+        }
+        HASH_CONTAINERS_TRY {
+            internal::construct(&node->value, value);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            internal::destroy(&node->key);
+            this->pool.release(node);
+            HASH_CONTAINERS_RETHROW;
+        }
+
+        this->slots[pos] = make_slot(node);
+        this->num_nodes++;
+        return node;
+    }
+
+
+
+    /* Erases the element pointed to by slot <pos>. The contiguous span of
+     * slots after <pos> is then rehashed, as erase_policy_rehash does. Only
+     * pointers move.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void do_erase(size_t pos) {
+
+        node_t *node = get_node(this->slots[pos]);
+        internal::destroy(&node->key);
+        internal::destroy(&node->value);
+        this->pool.release(node);
+        this->num_nodes--;
+
+        size_t hole = pos;
+        for (size_t pos2 = (hole + 1) & this->capacity_minus_1; this->slots[pos2]; pos2 = (pos2 + 1) & this->capacity_minus_1) {
+
+            const size_t home = get_node(this->slots[pos2])->hash & this->capacity_minus_1;
+
+            if ((hole <= pos2) ? ((hole < home) && (home <= pos2)) : ((hole < home) || (home <= pos2))) {
+                continue;
+            }
+
+            this->slots[hole] = this->slots[pos2];
+            hole = pos2;
+        }
+        this->slots[hole] = 0;
+    }
+
+
+
+    /* Returns the position of the first used slot at or after <pos>, or ~0
+     * if there are none.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_next_from(size_t pos) const {
+        if (this->is_empty_table()) {
+            return ~size_t(0);
+        }
+        for (; pos <= this->capacity_minus_1; pos++) {
+            if (this->slots[pos]) {
+                return pos;
+            }
+        }
+        return ~size_t(0);
+    }
+
+
+
+    /* Containers can't be copied */
+    node_hash_table(const node_hash_table &);
+    node_hash_table& operator=(const node_hash_table &);
+
+
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor. No memory is allocated until the first insertion.
+     */
+    HASH_CONTAINERS_INLINE
+    node_hash_table() {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit node_hash_table(const allocator_type &alloc)
+        : allocator_holder_t(char_allocator_t(alloc)) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will hash keys with (a copy of)
+     * <hash>, and allocate memory through (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit node_hash_table(const hash_functor &hash, const allocator_type &alloc = allocator_type())
+        : allocator_holder_t(char_allocator_t(alloc)),
+          hash_functor_holder_t(hash) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Destructor.
+     */
+    HASH_CONTAINERS_INLINE
+    ~node_hash_table() {
+        this->destroy_nodes();
+        this->pool.free_all(this->get_char_allocator());
+        if (!this->is_empty_table()) {
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(this->slots), (this->capacity_minus_1 + 1) * sizeof(slot_t));
+        }
+    }
+
+
+
+    /* Inserts an element in the container. If the specified key is already
+     * present, then 'false' is returned and the container is not modified.
+     *
+     * Iterators should be assumed to be invalid after insert(), if it
+     * returns 'true'. Pointers and references to elements stay valid.
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(const K &key, const V &value) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        this->find_pos(found, key, hash);
+        if (found) {
+            return false;
+        }
+        this->add_new(key, value, hash);
+        return true;
+    }
+
+
+
+    /* Erases an element from the table, if present.
+     *
+     * Iterators should be assumed to be invalid after erase(). Pointers and
+     * references to other elements stay valid.
+     */
+    HASH_CONTAINERS_INLINE
+    void erase(const K &key) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t pos = this->find_pos(found, key, hash);
+        if (found) {
+            this->do_erase(pos);
+        }
+    }
+
+
+
+    /* Returns the number of valid elements in the container. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->num_nodes;
+    }
+
+
+
+    /* Returns the number of slots of the table. */
+    HASH_CONTAINERS_INLINE
+    size_t capacity() const {
+        return this->is_empty_table() ? 0 : this->capacity_minus_1 + 1;
+    }
+
+
+
+    /* Returns a copy of the allocator of the container. */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return allocator_type(this->get_char_allocator());
+    }
+
+
+
+    /* Returns a copy of the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor hash_function() const {
+        return this->get_hash_functor();
+    }
+
+
+
+    /* Makes room for <num_elements> elements, both in the table and in the
+     * slabs, so that inserting them doesn't cause any allocation.
+     */
+    void reserve(size_t num_elements) {
+        if (num_elements * 2 > this->capacity()) {
+            const size_t new_size = internal::round_up_to_next_power_of_2(num_elements * 2);
+            this->resize_table(new_size > MIN_CAPACITY ? new_size : MIN_CAPACITY);
+        }
+        if (num_elements > this->num_nodes) {
+            this->pool.reserve(this->get_char_allocator(), num_elements - this->num_nodes, this->num_nodes);
+        }
+    }
+
+
+
+    /*******************************************************************
+     * Iterator interface
+     *******************************************************************/
+
+    class const_iterator;
+
+    /* Iterator for the container */
+    class iterator : public std::iterator<std::forward_iterator_tag,
+                                          std::pair<reference_wrapper<const K>, reference_wrapper<V> > > {
+
+        friend class node_hash_table;
+        friend class const_iterator;
+
+    protected:
+
+        size_t           pos;
+        node_hash_table* table;
+
+        iterator(size_t pos, node_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        iterator(const iterator& other) : pos(other.pos), table(other.table) { }
+
+
+        operator const_iterator() const {
+            return const_iterator(this->pos, this->table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        iterator& operator=(const iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<V> > operator*() {
+            node_t *node = get_node(this->table->slots[this->pos]);
+            return std::pair<reference_wrapper<const K>, reference_wrapper<V> >(node->key, node->value);
+        }
+
+
+
+        iterator &operator++() {
+            this->pos = this->table->get_next_from(this->pos + 1);
+            return *this;
+        }
+
+
+
+        iterator operator++(int) {
+            const iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Constant Iterator for the container */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<reference_wrapper<const K>, reference_wrapper<const V> > > {
+
+        friend class node_hash_table;
+        friend class iterator;
+
+    protected:
+
+        size_t                 pos;
+        const node_hash_table* table;
+
+        const_iterator(size_t pos, const node_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        const_iterator(const const_iterator& other) : pos(other.pos), table(other.table) { }
+        const_iterator(const       iterator& other) : pos(other.pos), table(other.table) { }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        const_iterator& operator=(const const_iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<const V> > operator*() {
+            const node_t *node = get_node(this->table->slots[this->pos]);
+            return std::pair<reference_wrapper<const K>, reference_wrapper<const V> >(node->key, node->value);
+        }
+
+
+
+        const_iterator &operator++() {
+            this->pos = this->table->get_next_from(this->pos + 1);
+            return *this;
+        }
+
+
+
+        const_iterator operator++(int) {
+            const const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Returns an iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator begin() {
+        return iterator(this->get_next_from(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    const_iterator cbegin() const {
+        return const_iterator(this->get_next_from(0), this);
+    }
+
+
+
+    /* Returns an iterator to one past the last element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator end() {
+        return iterator(~size_t(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to one past the last element in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator cend() const {
+        return const_iterator(~size_t(0), this);
+    }
+
+
+
+    /* Looks up the specified key and returns a reference to the corresponding
+     * value. If the key is not present in the container, then a value object
+     * is default-constructed and inserted in the container, and then a
+     * reference to that object is returned.
+     *
+     * The reference stays valid until the element is erased.
+     */
+    HASH_CONTAINERS_INLINE
+    V& operator[](const K& key) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool found;
+        const size_t pos = this->find_pos(found, key, hash);
+
+        if (found) {
+            return get_node(this->slots[pos])->value;
+        }
+        return this->add_new(key, V(), hash)->value;
+    }
+
+
+
+    /* Counts the number of elements in the container matching the specified
+     * key: 0 or 1.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t count(const K& key) const {
+        return this->get_index(key) != ~size_t(0) ? 1 : 0;
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     A constant iterator to the element in the container. cend() is
+     *     returned if no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const K& key) const {
+        return const_iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     An iterator to the element in the container. end() is returned if
+     *     no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    iterator find(const K& key) {
+        return iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Clears the content of the container. The capacity of the container is
+     * unchanged, and the nodes are kept for reuse.
+     *
+     * Iterators are invalidated by clear().
+     */
+    HASH_CONTAINERS_INLINE
+    void clear() {
+        if (this->is_empty_table()) {
+            return;
+        }
+
+        this->destroy_nodes();
+        this->num_nodes = 0;
+        memset(this->slots, 0, (this->capacity_minus_1 + 1) * sizeof(slot_t));
+    }
+
+}; // class node_hash_table
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_NODE_HASH_TABLE_H_GUARD */
+
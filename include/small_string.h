@@ -0,0 +1,269 @@
+/* String key type for the hash containers, with inline storage and a cached
+ * hash.
+ *
+ * Keys of type std::string make lookups slow: the hash of the key is
+ * recomputed each time the table grows or erase() rehashes, and comparing
+ * keys follows a pointer to the heap. small_string instead:
+ *   - stores strings of up to INLINE_CAPACITY (22) bytes inside the object,
+ *     so comparing them doesn't touch any other memory;
+ *   - hashes the string once, on construction, and keeps the hash. Hashing
+ *     the key is then free, and comparisons start by the hashes, so
+ *     mismatches almost never compare characters.
+ * Longer strings are kept on the heap, and still benefit from the cached
+ * hash.
+ *
+ * Use small_string_hash (or std::hash<small_string> in C++11) as the hash
+ * functor of the containers.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_SMALL_STRING_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_SMALL_STRING_H_GUARD 1
+
+#include <string.h>   // For memcpy, memcmp, strlen
+#include <string>     // For std::string
+#include <utility>    // For std::swap<>
+#if __cplusplus >= 201103L
+#include <functional> // For std::hash<>
+#endif
+#include "common.h"
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     small_string
+ *
+ * Immutable string, with its hash computed on construction. Strings of up
+ * to INLINE_CAPACITY bytes are stored inside the object.
+ */
+class small_string {
+public:
+    static const size_t INLINE_CAPACITY = 22;
+
+private:
+    size_t hash;
+    size_t length;
+    union {
+        char  bytes[INLINE_CAPACITY + 1]; // NUL terminated
+        char *ptr;                        // When length > INLINE_CAPACITY
+    } u;
+
+
+    HASH_CONTAINERS_INLINE
+    bool is_inline() const {
+        return this->length <= INLINE_CAPACITY;
+    }
+
+
+
+    /* Copies <len> bytes from <str>, which aren't hashed yet. */
+    HASH_CONTAINERS_INLINE
+    void init(const char *str, size_t len) {
+        this->length = len;
+
+        char *dst = this->u.bytes;
+        if (!this->is_inline()) {
+            dst = this->u.ptr = new char[len + 1];
+        }
+        memcpy(dst, str, len);
+        dst[len] = '\0';
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    void release() {
+        if (!this->is_inline()) {
+            delete[] this->u.ptr;
+        }
+    }
+
+
+
+public:
+    /* Constructs an empty string. */
+    HASH_CONTAINERS_INLINE
+    small_string() {
+        this->init("", 0);
+        this->hash = size_t(internal::hash_bytes("", 0));
+    }
+
+
+
+    /* Constructs a copy of the NUL terminated string <str>. */
+    HASH_CONTAINERS_INLINE
+    small_string(const char *str) {
+        this->init(str, strlen(str));
+        this->hash = size_t(internal::hash_bytes(this->data(), this->length));
+    }
+
+
+
+    /* Constructs a copy of the <len> bytes at <str>. */
+    HASH_CONTAINERS_INLINE
+    small_string(const char *str, size_t len) {
+        this->init(str, len);
+        this->hash = size_t(internal::hash_bytes(this->data(), this->length));
+    }
+
+
+
+    /* Constructs a copy of <str>. */
+    HASH_CONTAINERS_INLINE
+    small_string(const std::string &str) {
+        this->init(str.data(), str.size());
+        this->hash = size_t(internal::hash_bytes(this->data(), this->length));
+    }
+
+
+
+    /* Copy constructor. The hash is copied, not recomputed. */
+    HASH_CONTAINERS_INLINE
+    small_string(const small_string &other) {
+        this->init(other.data(), other.length);
+        this->hash = other.hash;
+    }
+
+
+
+#if __cplusplus >= 201103L
+    /* Move constructor: takes over the heap storage of long strings. */
+    HASH_CONTAINERS_INLINE
+    small_string(small_string &&other) noexcept : hash(other.hash), length(other.length), u(other.u) {
+        other.length     = 0;
+        other.u.bytes[0] = '\0';
+        other.hash       = size_t(internal::hash_bytes("", 0));
+    }
+#endif
+
+
+
+    HASH_CONTAINERS_INLINE
+    ~small_string() {
+        this->release();
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    small_string &operator=(const small_string &other) {
+        if (this != &other) {
+            // Copy first, so that *this is left untouched if that throws
+            small_string copy(other);
+            std::swap(this->hash,   copy.hash);
+            std::swap(this->length, copy.length);
+            std::swap(this->u,      copy.u);
+        }
+        return *this;
+    }
+
+
+
+    /* Returns the characters of the string, NUL terminated. */
+    HASH_CONTAINERS_INLINE
+    const char *data() const {
+        return this->is_inline() ? this->u.bytes : this->u.ptr;
+    }
+
+    HASH_CONTAINERS_INLINE
+    const char *c_str() const {
+        return this->data();
+    }
+
+
+
+    /* Returns the length of the string, in bytes. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->length;
+    }
+
+
+
+    /* Returns the hash of the string, computed on construction. */
+    HASH_CONTAINERS_INLINE
+    size_t get_hash() const {
+        return this->hash;
+    }
+
+
+
+    /* Returns a copy of the string, as a std::string. */
+    std::string str() const {
+        return std::string(this->data(), this->length);
+    }
+
+
+
+    /* Compares the hashes and lengths first: different strings almost never
+     * get to comparing their bytes.
+     */
+    HASH_CONTAINERS_INLINE
+    bool operator==(const small_string &other) const {
+        return this->hash   == other.hash
+            && this->length == other.length
+            && memcmp(this->data(), other.data(), this->length) == 0;
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    bool operator!=(const small_string &other) const {
+        return !(*this == other);
+    }
+};
+
+
+
+/* small_string never points into itself: tables relocate it with memcpy(). */
+template <>
+struct is_trivially_relocatable<small_string> {
+    static const bool value = true;
+};
+
+
+
+/* Hash functor for small_string keys: returns the cached hash. */
+struct small_string_hash {
+    HASH_CONTAINERS_INLINE
+    size_t operator()(const small_string &str) const {
+        return str.get_hash();
+    }
+};
+
+}; // namespace hash_containers
+
+
+
+#if __cplusplus >= 201103L
+namespace std {
+    template <>
+    struct hash<hash_containers::small_string> : hash_containers::small_string_hash { };
+}
+#endif
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_SMALL_STRING_H_GUARD */
+
@@ -0,0 +1,1063 @@
+/* Associative container, memory-compact hash table with linear probing.
+ *
+ * Like closed_linear_probing_hash_table, elements are placed in a table of
+ * slots using the hash of the key, with linear probing on conflicts. However,
+ * empty slots take (almost) no memory: the slots are split in groups of 32,
+ * and each group only stores its occupied slots, packed in a small array. A
+ * bitmap per group tells which slots are occupied, and the position of an
+ * element in its group's array is the number of occupied slots before it
+ * (a popcount of the bitmap).
+ *
+ * The overhead is 32 bits of bitmap and one pointer per group, which is 3
+ * bits per slot on 64-bit platforms, plus the allocator's own overhead for
+ * each non-empty group array. Inserting or erasing an element reallocates
+ * its group's array, so this container trades speed for memory; it is meant
+ * for very large key sets that must stay resident on smaller machines.
+ *
+ * Erasing rehashes the following elements, like erase_policy_rehash.
+ *
+ * Objects must either be POD types, or must provide the appropriate ctors and
+ * assignment operators.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_SPARSE_HASH_TABLE_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_SPARSE_HASH_TABLE_H_GUARD 1
+
+#include <assert.h>   // For assert
+#include <iterator>   // For std::iterator<>
+#include <string.h>   // For memset
+#include "common.h"
+#include "closed_linear_probing_hash_table.h" // For erase_policy_rehash
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     sparse_hash_table<K, V,
+ *                       hash_functor = std::hash<K>, // C++11
+ *                       allocator    = table_allocator<char>
+ *                       >
+ *
+ * Objects of this class are associative containers mapping objects of type
+ * <K> to objects of type <V>, using the hash function <hash_functor>.
+ *
+ * Template Parameters:
+ *    <K>           : the type of the key of the associative container.
+ *    <V>           : the type of the value of the associative container.
+ *    <hash_functor>: a functor that will hash the key to a size_t. Default
+ *                    value is only provided in C++11. It is stored in the
+ *                    container, so it can hold state such as a seed (see
+ *                    seeded_hash<>); empty functors take no space.
+ *    <allocator>   : the allocator used for the table and group arrays. It is
+ *                    rebound to char. Group arrays are reallocated often, so
+ *                    allocators that don't reuse freed memory (such as
+ *                    arena_allocator) are a poor fit.
+ */
+template <typename K,
+          typename V,
+#if __cplusplus >= 201103L
+          typename hash_functor = std::hash<K>,
+#else
+          typename hash_functor,
+#endif
+          typename allocator = table_allocator<char>
+          >
+class sparse_hash_table;
+
+
+
+namespace internal {
+
+    /* An element of a sparse hash table, in its group's array. */
+    template <typename K, typename V>
+    struct sparse_hash_table_entry_t {
+        K key;
+        V value;
+    };
+
+
+
+    template <typename K, typename V>
+    struct sparse_hash_table_data_t {
+
+        typedef erase_policy_rehash::meta_t       meta_t;
+        typedef sparse_hash_table_entry_t<K, V>   entry_t;
+
+        /* The bitmap of occupied slots has the same layout as the meta-data
+         * of erase_policy_rehash: one word per group of slots.
+         */
+        meta_t   *valid;
+        entry_t **groups;  // Packed elements of each group, or NULL if the group is empty
+        size_t    size;
+        size_t    capacity_minus_1;
+        char     *memory;  // Heap block holding the bitmap and group arrays, or NULL
+
+
+        sparse_hash_table_data_t() :
+                   valid(NULL), groups(NULL), size(0), capacity_minus_1(0), memory(NULL) {}
+
+
+        static HASH_CONTAINERS_INLINE
+        size_t get_num_groups(size_t capacity) {
+            return (capacity + erase_policy_rehash::META_ELEMENTS_PER_WORD - 1) / erase_policy_rehash::META_ELEMENTS_PER_WORD;
+        }
+
+
+        /* Returns the size, in bytes, of the memory block holding the bitmap
+         * and the group array pointers of a table of <capacity> slots.
+         */
+        static HASH_CONTAINERS_INLINE
+        size_t get_memory_size(size_t capacity) {
+            const size_t valid_size = (get_num_groups(capacity) * sizeof(meta_t) + sizeof(entry_t*) - 1) & ~(sizeof(entry_t*) - 1);
+            return valid_size + get_num_groups(capacity) * sizeof(entry_t*);
+        }
+
+
+        template <typename A>
+        HASH_CONTAINERS_NO_INLINE
+        sparse_hash_table_data_t(size_t capacity, A &alloc) {
+
+            assert(capacity > 0);
+            assert((capacity & (capacity - 1)) == 0);
+
+            const size_t valid_size = (get_num_groups(capacity) * sizeof(meta_t) + sizeof(entry_t*) - 1) & ~(sizeof(entry_t*) - 1);
+
+            // All slots start empty, and all group arrays NULL
+            this->memory = internal::allocate_block(alloc, get_memory_size(capacity), true);
+            assert(this->memory);
+
+            this->valid  = reinterpret_cast<meta_t*>(this->memory);
+            this->groups = reinterpret_cast<entry_t**>(this->memory + valid_size);
+
+            this->size = 0;
+            this->capacity_minus_1 = capacity - 1;
+        }
+
+
+        /* Releases the memory block allocated by the capacity constructor.
+         * The group arrays must already have been released.
+         */
+        template <typename A>
+        HASH_CONTAINERS_INLINE
+        void free_memory(A &alloc) {
+            internal::deallocate_block(alloc, this->memory, get_memory_size(this->capacity_minus_1 + 1));
+        }
+    };
+} // namespace internal
+
+
+/***************************************************************************
+ */
+
+template <typename K,
+          typename V,
+          typename hash_functor,
+          typename allocator>
+class sparse_hash_table : private internal::ebo_holder<typename internal::rebind_alloc<allocator, char>::type, 0>,
+                          private internal::ebo_holder<hash_functor, 1> {
+
+    typedef internal::sparse_hash_table_data_t<K, V>        data_t;
+    typedef typename data_t::entry_t                        entry_t;
+    typedef erase_policy_rehash::meta_t                     meta_t;
+
+    typedef typename internal::rebind_alloc<allocator, char>::type char_allocator_t;
+    typedef internal::ebo_holder<char_allocator_t, 0>             allocator_holder_t;
+    typedef internal::ebo_holder<hash_functor, 1>                 hash_functor_holder_t;
+
+    static const size_t GROUP_SIZE = erase_policy_rehash::META_ELEMENTS_PER_WORD;
+
+    /* Capacity of the first table allocated. */
+    static const size_t MIN_CAPACITY = GROUP_SIZE;
+
+
+    data_t data;
+
+
+    /* Returns the allocator used for the table's memory. */
+    HASH_CONTAINERS_INLINE
+    char_allocator_t &get_char_allocator() {
+        return static_cast<allocator_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const char_allocator_t &get_char_allocator() const {
+        return static_cast<const allocator_holder_t&>(*this).get();
+    }
+
+
+
+    /* Returns the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor &get_hash_functor() {
+        return static_cast<hash_functor_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const hash_functor &get_hash_functor() const {
+        return static_cast<const hash_functor_holder_t&>(*this).get();
+    }
+
+
+
+    /* Points the container at the shared, read-only, empty table. Memory is
+     * only allocated on the first insertion.
+     */
+    HASH_CONTAINERS_INLINE
+    void init_empty_table() {
+        this->data        = data_t();
+        this->data.valid  = const_cast<meta_t*>(&internal::empty_table_meta<meta_t>::valid[0]);
+    }
+
+
+
+    /* Checks whether the container is using the shared empty table. */
+    HASH_CONTAINERS_INLINE
+    bool is_empty_table() const {
+        return !this->data.memory;
+    }
+
+
+
+    /* Returns the element in slot <idx>, which must be occupied, or about to
+     * be: its position in the group array is the number of occupied slots
+     * before it in the group.
+     */
+    static HASH_CONTAINERS_INLINE
+    entry_t *get_entry(const data_t &data, size_t idx) {
+        const meta_t word = data.valid[idx / GROUP_SIZE];
+        const meta_t mask = (meta_t(1) << (idx & (GROUP_SIZE - 1))) - 1;
+        return data.groups[idx / GROUP_SIZE] + internal::popcount32(word & mask);
+    }
+
+
+
+    static HASH_CONTAINERS_INLINE
+    bool is_slot_used(const meta_t *valid, size_t idx) {
+        return (valid[idx / GROUP_SIZE] >> (idx & (GROUP_SIZE - 1))) & 1;
+    }
+
+
+
+    /* Allocates the array of a group of <n> elements. */
+    HASH_CONTAINERS_INLINE
+    entry_t *allocate_entries(size_t n) {
+        entry_t *entries = reinterpret_cast<entry_t*>(internal::allocate_block(this->get_char_allocator(), n * sizeof(entry_t), false));
+        assert(entries);
+        return entries;
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    void free_entries(entry_t *entries, size_t n) {
+        internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(entries), n * sizeof(entry_t));
+    }
+
+
+
+    /* Moves the element at <src> to the unconstructed entry <dst>. */
+    static HASH_CONTAINERS_INLINE
+    void relocate_entry(entry_t *dst, entry_t *src) {
+        internal::relocate(&dst->key,   src->key);
+        internal::relocate(&dst->value, src->value);
+    }
+
+
+
+    /* Marks slot <idx> as occupied, and makes room for its element in the
+     * group array. Other pointers to elements of the group are invalidated.
+     *
+     * Returns:
+     *     The (unconstructed) entry of the slot.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    entry_t *insert_into_group(data_t &data, size_t idx) {
+
+        const size_t   group = idx / GROUP_SIZE;
+        const unsigned bit   = idx & (GROUP_SIZE - 1);
+        const meta_t   word  = data.valid[group];
+        const size_t   n     = internal::popcount32(word);
+        const size_t   r     = internal::popcount32(word & ((meta_t(1) << bit) - 1));
+
+        assert(!((word >> bit) & 1));
+
+        entry_t *old_entries = data.groups[group];
+        entry_t *entries     = this->allocate_entries(n + 1);
+
+        for (size_t i = 0; i < r; i++) {
+            relocate_entry(&entries[i], &old_entries[i]);
+        }
+        for (size_t i = r; i < n; i++) {
+            relocate_entry(&entries[i + 1], &old_entries[i]);
+        }
+        if (old_entries) {
+            this->free_entries(old_entries, n);
+        }
+
+        data.groups[group] = entries;
+        data.valid[group]  = word | (meta_t(1) << bit);
+        return &entries[r];
+    }
+
+
+
+    /* Marks slot <idx> as empty, and removes its element from the group
+     * array. The element must already have been destroyed. Other pointers to
+     * elements of the group are invalidated.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void remove_from_group(data_t &data, size_t idx) {
+
+        const size_t   group = idx / GROUP_SIZE;
+        const unsigned bit   = idx & (GROUP_SIZE - 1);
+        const meta_t   word  = data.valid[group];
+        const size_t   n     = internal::popcount32(word);
+        const size_t   r     = internal::popcount32(word & ((meta_t(1) << bit) - 1));
+
+        assert((word >> bit) & 1);
+
+        entry_t *old_entries = data.groups[group];
+        entry_t *entries     = NULL;
+
+        if (n > 1) {
+            entries = this->allocate_entries(n - 1);
+            for (size_t i = 0; i < r; i++) {
+                relocate_entry(&entries[i], &old_entries[i]);
+            }
+            for (size_t i = r + 1; i < n; i++) {
+                relocate_entry(&entries[i - 1], &old_entries[i]);
+            }
+        }
+        this->free_entries(old_entries, n);
+
+        data.groups[group] = entries;
+        data.valid[group]  = word & ~(meta_t(1) << bit);
+    }
+
+
+
+    /* Returns the first empty slot of the probe sequence of <hash>, in the
+     * bitmap <valid>.
+     */
+    static HASH_CONTAINERS_INLINE
+    size_t find_free_slot(const meta_t *valid, size_t capacity_minus_1, size_t hash) {
+        size_t idx = hash & capacity_minus_1;
+        while (is_slot_used(valid, idx)) {
+            idx = (idx + 1) & capacity_minus_1;
+        }
+        return idx;
+    }
+
+
+
+    /* Destroys all the elements and releases the group arrays. The bitmap is
+     * left as is.
+     */
+    HASH_CONTAINERS_INLINE
+    void destroy_groups() {
+        const size_t num_groups = data_t::get_num_groups(this->data.capacity_minus_1 + 1);
+
+        for (size_t group = 0; group < num_groups; group++) {
+            entry_t *entries = this->data.groups[group];
+            if (!entries) {
+                continue;
+            }
+            const size_t n = internal::popcount32(this->data.valid[group]);
+            for (size_t i = 0; i < n; i++) {
+                internal::destroy(&entries[i].key);
+                internal::destroy(&entries[i].value);
+            }
+            this->free_entries(entries, n);
+        }
+    }
+
+
+
+    /* Changes the size of the hash table.
+     *
+     * Iterators are all invalidated.
+     *
+     * Parameters:
+     *     <new_size>: The new size of the table. Must be a power of 2, and
+     *                 larger than the number of elements.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void resize_table(size_t new_size) {
+
+        assert((new_size & (new_size - 1)) == 0);
+        assert(new_size > this->data.size);
+
+        data_t new_data(new_size, this->get_char_allocator());
+
+        if (this->data.size) {
+            hash_functor &hash_func = this->get_hash_functor();
+            const size_t num_groups = data_t::get_num_groups(new_size);
+
+            /* Find the slots of all the elements first, so that each group
+             * array is allocated once, at its final size.
+             */
+            for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
+                const size_t idx = find_free_slot(new_data.valid, new_data.capacity_minus_1, hash_func(get_entry(this->data, i)->key));
+                new_data.valid[idx / GROUP_SIZE] |= meta_t(1) << (idx & (GROUP_SIZE - 1));
+            }
+            for (size_t group = 0; group < num_groups; group++) {
+                if (new_data.valid[group]) {
+                    new_data.groups[group] = this->allocate_entries(internal::popcount32(new_data.valid[group]));
+                }
+            }
+
+            /* Probing again, in the same order, lands on the same slots. */
+            meta_t *placed = reinterpret_cast<meta_t*>(internal::allocate_block(this->get_char_allocator(), num_groups * sizeof(meta_t), true));
+            assert(placed);
+
+            for (size_t i = this->get_first(); i != ~size_t(0); i = this->get_next(i)) {
+                entry_t     *entry = get_entry(this->data, i);
+                const size_t idx   = find_free_slot(placed, new_data.capacity_minus_1, hash_func(entry->key));
+                placed[idx / GROUP_SIZE] |= meta_t(1) << (idx & (GROUP_SIZE - 1));
+                relocate_entry(get_entry(new_data, idx), entry);
+            }
+
+            internal::deallocate_block(this->get_char_allocator(), reinterpret_cast<char*>(placed), num_groups * sizeof(meta_t));
+            new_data.size = this->data.size;
+        }
+
+        /* Delete old table and reassign */
+        if (this->data.memory) {
+            const size_t num_groups = data_t::get_num_groups(this->data.capacity_minus_1 + 1);
+            for (size_t group = 0; group < num_groups; group++) {
+                if (this->data.groups[group]) {
+                    this->free_entries(this->data.groups[group], internal::popcount32(this->data.valid[group]));
+                }
+            }
+            this->data.free_memory(this->get_char_allocator());
+        }
+
+        this->data = new_data;
+    }
+
+
+
+    /* Maps the key into the table, returning the index of the matched element.
+     *
+     * Iterators are still valid after get_index().
+     *
+     * Parameters:
+     *     <valid>: (out) Set to true if the key was found in the container.
+     *     <key>  : The key to look-up.
+     *     <hash> : The hash of the <key> parameter.
+     *
+     * Returns:
+     *     If <valid> is true, then the return value is the slot of the
+     *     element. Otherwise, the return value is garbage.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_index(bool &valid /*out*/, const K &key, size_t hash) const {
+
+        const size_t orig_idx = hash & this->data.capacity_minus_1;
+        size_t       idx      = orig_idx;
+
+        valid = false;
+
+        do {
+            // Element doesn't exist
+            if (!is_slot_used(this->data.valid, idx)) {
+                break;
+            }
+
+            // Found element
+            if (get_entry(this->data, idx)->key == key) {
+                valid = true;
+                return idx;
+            }
+
+            // Didn't find it, try the next spot until we do (and wrap around at the ends)
+            idx = (idx + 1) & this->data.capacity_minus_1;
+        } while (idx != orig_idx);
+
+        return ~size_t(0);
+    }
+
+
+
+    HASH_CONTAINERS_INLINE
+    size_t get_index(bool &valid, const K &key) const {
+
+        size_t hash = internal::call_const_hash(this->get_hash_functor(), key);
+        return this->get_index(valid, key, hash);
+    }
+
+
+
+    /* Adds a new element to table. The element's key must *not* already be
+     * present.
+     *
+     * This function could cause a reallocation of the table data and a
+     * rehash of all elements if the load factor gets too high and there's a
+     * collision.
+     *
+     * Iterators should be assumed to be invalid after add_new(). If
+     * copying the key or value throws, the slot is given back.
+     *
+     * Returns:
+     *     The slot of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t add_new(const K &key, const V &value, size_t hash) {
+
+        restart:
+        // The shared empty table is read-only; get real storage first
+        if (this->is_empty_table()) {
+            this->resize_table(MIN_CAPACITY);
+        }
+
+        size_t idx = hash & this->data.capacity_minus_1;
+
+        while (is_slot_used(this->data.valid, idx)) {
+
+            assert(get_entry(this->data, idx)->key != key);
+
+            /* If we have a collision AND load factor is too high, increase
+             * table size.
+             */
+            if (this->data.size * 2 > this->data.capacity_minus_1) {
+                this->resize_table((this->data.capacity_minus_1 + 1) * 2);
+                goto restart;
+            }
+
+            // There is a collision, try the next spot over
+            idx = (idx + 1) & this->data.capacity_minus_1;
+        }
+
+        entry_t *entry = this->insert_into_group(this->data, idx);
+        HASH_CONTAINERS_TRY {
+            internal::construct(&entry->key, key);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            this->remove_from_group(this->data, idx);
+            HASH_CONTAINERS_RETHROW;
+        }
+        HASH_CONTAINERS_TRY {
+            internal::construct(&entry->value, value);
+        }
+        HASH_CONTAINERS_CATCH_ALL {
+            internal::destroy(&entry->key);
+            this->remove_from_group(this->data, idx);
+            HASH_CONTAINERS_RETHROW;
+        }
+        this->data.size++;
+        return idx;
+    }
+
+
+
+    /* Erases the element in slot <idx>, then rehashes the contiguous span
+     * of elements after it, as erase_policy_rehash does.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void do_erase(size_t idx) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        const size_t capacity_minus_1 = this->data.capacity_minus_1;
+
+        entry_t *entry = get_entry(this->data, idx);
+        internal::destroy(&entry->key);
+        internal::destroy(&entry->value);
+        this->remove_from_group(this->data, idx);
+
+        for (size_t idx2 = (idx + 1) & capacity_minus_1; is_slot_used(this->data.valid, idx2); idx2 = (idx2 + 1) & capacity_minus_1) {
+
+            const size_t key2 = hash_func(get_entry(this->data, idx2)->key) & capacity_minus_1;
+
+            if ((idx <= idx2) ? ((idx < key2) && (key2 <= idx2)) : ((idx < key2) || (key2 <= idx2))) {
+                continue;
+            }
+
+            // Move the element back into the hole. Both groups may be
+            // reallocated, so look up the source again.
+            entry_t *dst = this->insert_into_group(this->data, idx);
+            relocate_entry(dst, get_entry(this->data, idx2));
+            this->remove_from_group(this->data, idx2);
+
+            idx = idx2;
+        }
+
+        this->data.size--;
+    }
+
+
+
+    /* Finds the first element in the table and returns its slot, or ~0 if
+     * the table is empty.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_first() const {
+        return erase_policy_rehash::get_first(this->data.capacity_minus_1, this->data.valid);
+    }
+
+
+
+    /* Finds the element after slot <old_pos> and returns its slot, or ~0 if
+     * there are no more elements.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_next(size_t old_pos) const {
+
+        assert(old_pos != ~size_t(0));
+
+        const size_t num_valid_words = data_t::get_num_groups(this->data.capacity_minus_1 + 1);
+        meta_t           *valid_ptr  = &this->data.valid[old_pos / GROUP_SIZE];
+
+        return erase_policy_rehash::get_next(old_pos, valid_ptr, num_valid_words);
+    }
+
+
+
+    /* Containers can't be copied */
+    sparse_hash_table(const sparse_hash_table &);
+    sparse_hash_table& operator=(const sparse_hash_table &);
+
+
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor. No memory is allocated until the first insertion.
+     */
+    HASH_CONTAINERS_INLINE
+    sparse_hash_table() {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit sparse_hash_table(const allocator_type &alloc)
+        : allocator_holder_t(char_allocator_t(alloc)) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will hash keys with (a copy of)
+     * <hash>, and allocate memory through (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit sparse_hash_table(const hash_functor &hash, const allocator_type &alloc = allocator_type())
+        : allocator_holder_t(char_allocator_t(alloc)),
+          hash_functor_holder_t(hash) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Destructor.
+     */
+    HASH_CONTAINERS_INLINE
+    ~sparse_hash_table() {
+        if (this->data.memory) {
+            this->destroy_groups();
+            this->data.free_memory(this->get_char_allocator());
+        }
+    }
+
+
+
+    /* Inserts an element in table. If the specified key is already present,
+     * then 'false' is returned and the container is not modified. If the
+     * specified key is not present, then the specified key and value pair
+     * are stored in the container and 'true' is returned.
+     *
+     * Iterators should be assumed to be invalid after insert(), if it
+     * returns 'true'.
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(const K &key, const V &value) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool valid;
+        this->get_index(valid, key, hash);
+        if (valid) {
+            return false;
+        }
+        this->add_new(key, value, hash);
+        return true;
+    }
+
+
+
+    /* Erases an element from the table, if present.
+     *
+     * Iterators are invalidated by erase(), as elements move between
+     * groups.
+     */
+    HASH_CONTAINERS_INLINE
+    void erase(const K &key) {
+        bool valid;
+        const size_t idx = this->get_index(valid, key);
+        if (valid) {
+            this->do_erase(idx);
+        }
+    }
+
+
+
+    /* Returns the number of valid elements in the container. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->data.size;
+    }
+
+
+
+    /* Returns the number of slots of the table. */
+    HASH_CONTAINERS_INLINE
+    size_t capacity() const {
+        return this->is_empty_table() ? 0 : this->data.capacity_minus_1 + 1;
+    }
+
+
+
+    /* Returns a copy of the allocator of the container. */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return allocator_type(this->get_char_allocator());
+    }
+
+
+
+    /* Returns a copy of the functor hashing keys. */
+    HASH_CONTAINERS_INLINE
+    hash_functor hash_function() const {
+        return this->get_hash_functor();
+    }
+
+
+
+    /* Allocates increased capacity for the container. If <new_capacity> is
+     * less than or equal than the current capacity, then this function does
+     * nothing, preserving iterators.
+     */
+    void reserve(size_t new_capacity) {
+        if (new_capacity > this->capacity()) {
+            new_capacity = internal::round_up_to_next_power_of_2(new_capacity > MIN_CAPACITY ? new_capacity : MIN_CAPACITY);
+            this->resize_table(new_capacity);
+        }
+    }
+
+
+
+    /*******************************************************************
+     * Iterator interface
+     *******************************************************************/
+
+    class const_iterator;
+
+    /* Iterator for the container */
+    class iterator : public std::iterator<std::forward_iterator_tag,
+                                          std::pair<reference_wrapper<const K>, reference_wrapper<V> > > {
+
+        friend class sparse_hash_table;
+        friend class const_iterator;
+
+    protected:
+
+        size_t             pos;
+        sparse_hash_table* table;
+
+        iterator(size_t pos, sparse_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        iterator(const iterator& other) : pos(other.pos), table(other.table) { }
+
+
+        operator const_iterator() const {
+            return const_iterator(this->pos, this->table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        iterator& operator=(const iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<V> > operator*() {
+            entry_t *entry = get_entry(this->table->data, this->pos);
+            return std::pair<reference_wrapper<const K>, reference_wrapper<V> >(entry->key, entry->value);
+        }
+
+
+
+        iterator &operator++() {
+            this->pos = this->table->get_next(this->pos);
+            return *this;
+        }
+
+
+
+        iterator operator++(int) {
+            const iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Constant Iterator for the container */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<reference_wrapper<const K>, reference_wrapper<const V> > > {
+
+        friend class sparse_hash_table;
+        friend class iterator;
+
+    protected:
+
+        size_t                   pos;
+        const sparse_hash_table* table;
+
+        const_iterator(size_t pos, const sparse_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        const_iterator(const const_iterator& other) : pos(other.pos), table(other.table) { }
+        const_iterator(const       iterator& other) : pos(other.pos), table(other.table) { }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        const_iterator& operator=(const const_iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<reference_wrapper<const K>, reference_wrapper<const V> > operator*() {
+            const entry_t *entry = get_entry(this->table->data, this->pos);
+            return std::pair<reference_wrapper<const K>, reference_wrapper<const V> >(entry->key, entry->value);
+        }
+
+
+
+        const_iterator &operator++() {
+            this->pos = this->table->get_next(this->pos);
+            return *this;
+        }
+
+
+
+        const_iterator operator++(int) {
+            const const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Returns an iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator begin() {
+        return iterator(this->get_first(), this);
+    }
+
+
+
+    /* Returns a constant iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    const_iterator cbegin() const {
+        return const_iterator(this->get_first(), this);
+    }
+
+
+
+    /* Returns an iterator to one past the last element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator end() {
+        return iterator(~size_t(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to one past the last element in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator cend() const {
+        return const_iterator(~size_t(0), this);
+    }
+
+
+
+    /* Looks up the specified key and returns a reference to the corresponding
+     * value. If the key is not present in the container, then a value object
+     * is default-constructed and inserted in the container, and then a
+     * reference to that object is returned.
+     *
+     * The reference is invalidated by the next insertion or erasure.
+     */
+    HASH_CONTAINERS_INLINE
+    V& operator[](const K& key) {
+
+        hash_functor &hash_func = this->get_hash_functor();
+        size_t hash = hash_func(key);
+
+        bool valid;
+        size_t idx = this->get_index(valid, key, hash);
+
+        if (!valid) {
+            idx = this->add_new(key, V(), hash);
+        }
+        return get_entry(this->data, idx)->value;
+    }
+
+
+
+    /* Counts the number of elements in the container matching the specified
+     * key: 0 or 1.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t count(const K& key) const {
+        bool valid;
+        this->get_index(valid, key);
+        return valid ? 1 : 0;
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     A constant iterator to the element in the container. cend() is
+     *     returned if no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const K& key) const {
+        bool valid;
+        size_t pos = this->get_index(valid, key);
+        return const_iterator(pos, this);
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     An iterator to the element in the container. end() is returned if
+     *     no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    iterator find(const K& key) {
+        bool valid;
+        size_t pos = this->get_index(valid, key);
+        return iterator(pos, this);
+    }
+
+
+
+    /* Clears the content of the container, and releases the group arrays.
+     * The capacity of the container is unchanged.
+     *
+     * Iterators are invalidated by clear().
+     */
+    HASH_CONTAINERS_INLINE
+    void clear() {
+        if (this->is_empty_table()) {
+            return;
+        }
+
+        this->destroy_groups();
+        memset(this->data.memory, 0, data_t::get_memory_size(this->data.capacity_minus_1 + 1));
+        this->data.size = 0;
+    }
+
+}; // class sparse_hash_table
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_SPARSE_HASH_TABLE_H_GUARD */
+
@@ -0,0 +1,919 @@
+/* Associative container with string keys, whose bytes are stored in an arena.
+ *
+ * Tables with std::string keys scatter the key bytes all over the heap: each
+ * probe follows a pointer to a random address, and each key costs an
+ * allocation. Here, the bytes of all the keys are appended to a single,
+ * contiguous arena owned by the container, and the table only holds the
+ * offset and length of each key in the arena, along with 32 bits of its hash.
+ * So:
+ *   - probes compare the hashes first, and only read the arena for likely
+ *     matches;
+ *   - growing the table doesn't hash the keys again, nor touch the arena;
+ *   - keys don't need one allocation each.
+ *
+ * Erased keys leave their bytes in the arena, until it has to grow: the live
+ * keys are then compacted into the new arena.
+ *
+ * Keys are passed as string_ref, which converts from const char *,
+ * std::string and, in C++17, std::string_view, without copying the string.
+ * Lookups never build a std::string.
+ *
+ * Values must either be POD types, or must provide the appropriate ctors and
+ * assignment operators.
+ *
+ * https://github.com/rohannessian/hash_containers/
+ *
+ * Copyright (c) 2016, 2017 Robert Jr Ohannessian
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef INCLUDE_HASH_CONTAINERS_STRING_ARENA_HASH_TABLE_H_GUARD
+#define INCLUDE_HASH_CONTAINERS_STRING_ARENA_HASH_TABLE_H_GUARD 1
+
+#include <assert.h>   // For assert
+#include <iterator>   // For std::iterator<>
+#include <string.h>   // For memcpy, memcmp, strlen
+#include <string>     // For std::string
+#if __cplusplus >= 201703L
+#include <string_view> // For std::string_view
+#endif
+#include "common.h"
+
+
+
+namespace hash_containers {
+
+/* Class:
+ *     string_ref
+ *
+ * Reference to a string that lives elsewhere: a pointer and a length. The
+ * string doesn't need to be NUL terminated.
+ */
+class string_ref {
+    const char *ptr;
+    size_t      len;
+
+public:
+    HASH_CONTAINERS_INLINE string_ref(const char *str, size_t len) : ptr(str), len(len) { }
+    HASH_CONTAINERS_INLINE string_ref(const char *str)             : ptr(str), len(strlen(str)) { }
+    HASH_CONTAINERS_INLINE string_ref(const std::string &str)      : ptr(str.data()), len(str.size()) { }
+#if __cplusplus >= 201703L
+    HASH_CONTAINERS_INLINE string_ref(std::string_view str)        : ptr(str.data()), len(str.size()) { }
+#endif
+
+    HASH_CONTAINERS_INLINE const char *data() const { return this->ptr; }
+    HASH_CONTAINERS_INLINE size_t      size() const { return this->len; }
+
+    /* Returns a copy of the string, as a std::string. */
+    std::string str() const {
+        return std::string(this->ptr, this->len);
+    }
+
+    HASH_CONTAINERS_INLINE
+    bool operator==(const string_ref &other) const {
+        return this->len == other.len && (!this->len || memcmp(this->ptr, other.ptr, this->len) == 0);
+    }
+
+    HASH_CONTAINERS_INLINE
+    bool operator!=(const string_ref &other) const {
+        return !(*this == other);
+    }
+};
+
+
+
+/* Class:
+ *     string_arena_hash_table<V,
+ *                             allocator = table_allocator<char>
+ *                             >
+ *
+ * Objects of this class are associative containers mapping strings to
+ * objects of type <V>.
+ *
+ * Template Parameters:
+ *    <V>           : the type of the value of the associative container.
+ *    <allocator>   : the allocator used for the table and the arena. It is
+ *                    rebound to char.
+ */
+template <typename V,
+          typename allocator = table_allocator<char>
+          >
+class string_arena_hash_table;
+
+
+
+namespace internal {
+
+    /* A slot of a string arena hash table: where the key is in the arena,
+     * and its hash. Empty slots have a length of ~0.
+     */
+    struct string_arena_slot_t {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t hash;
+    };
+
+
+
+    /* Slot of empty string arena hash tables. It is never written to. */
+    template <typename slot_t>
+    struct empty_string_arena_slots {
+        static const slot_t slots[1];
+    };
+
+    template <typename slot_t>
+    const slot_t empty_string_arena_slots<slot_t>::slots[1] = { { 0, ~uint32_t(0), 0 } };
+} // namespace internal
+
+
+/***************************************************************************
+ */
+
+template <typename V,
+          typename allocator>
+class string_arena_hash_table : private internal::ebo_holder<typename internal::rebind_alloc<allocator, char>::type, 0> {
+
+    typedef internal::string_arena_slot_t slot_t;
+
+    typedef typename internal::rebind_alloc<allocator, char>::type char_allocator_t;
+    typedef internal::ebo_holder<char_allocator_t, 0>             allocator_holder_t;
+
+    /* Length of empty slots */
+    static const uint32_t EMPTY = ~uint32_t(0);
+
+    /* Capacity of the first table allocated. */
+    static const size_t MIN_CAPACITY = 16;
+
+    /* Size of the first arena allocated. */
+    static const size_t MIN_ARENA_SIZE = 256;
+
+
+    slot_t *slots;
+    V      *value_table;
+    size_t  num_elements;
+    size_t  capacity_minus_1;
+    char   *memory;             // Heap block holding the slots and values, or NULL
+
+    char   *arena;              // Key bytes, or NULL
+    size_t  arena_size;         // Bytes used, including erased keys
+    size_t  arena_capacity;
+    size_t  arena_garbage;      // Bytes of erased keys
+
+
+    /* Returns the allocator used for the container's memory. */
+    HASH_CONTAINERS_INLINE
+    char_allocator_t &get_char_allocator() {
+        return static_cast<allocator_holder_t&>(*this).get();
+    }
+
+    HASH_CONTAINERS_INLINE
+    const char_allocator_t &get_char_allocator() const {
+        return static_cast<const allocator_holder_t&>(*this).get();
+    }
+
+
+
+    /* Returns the 32-bit hash kept in the slots of key <key>. */
+    static HASH_CONTAINERS_INLINE
+    uint32_t get_hash(const string_ref &key) {
+        const uint64_t h = internal::hash_bytes(key.data(), key.size());
+        return uint32_t(h ^ (h >> 32));
+    }
+
+
+
+    /* Returns the key of slot <pos>. */
+    HASH_CONTAINERS_INLINE
+    string_ref get_key(size_t pos) const {
+        return string_ref(this->arena + this->slots[pos].offset, this->slots[pos].length);
+    }
+
+
+
+    /* Returns the size, in bytes, of the memory block holding the slots and
+     * the values of a table of <capacity> elements.
+     */
+    static HASH_CONTAINERS_INLINE
+    size_t get_memory_size(size_t capacity) {
+        return internal::round_up_to_cache_line(capacity * sizeof(slot_t))
+             + capacity * sizeof(V)
+             + HASH_CONTAINERS_CACHE_LINE_SIZE - 1;
+    }
+
+
+
+    /* Points the container at the shared, read-only, empty table. */
+    HASH_CONTAINERS_INLINE
+    void init_empty_table() {
+        this->slots            = const_cast<slot_t*>(&internal::empty_string_arena_slots<slot_t>::slots[0]);
+        this->value_table      = NULL;
+        this->num_elements     = 0;
+        this->capacity_minus_1 = 0;
+        this->memory           = NULL;
+        this->arena            = NULL;
+        this->arena_size       = 0;
+        this->arena_capacity   = 0;
+        this->arena_garbage    = 0;
+    }
+
+
+
+    /* Replaces the table by one of <new_size> slots, and re-inserts all the
+     * elements, using the hashes kept in the slots. The arena is untouched.
+     *
+     * Parameters:
+     *     <new_size>: The new size of the table. Must be a power of 2, and
+     *                 at least twice the number of elements.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void resize_table(size_t new_size) {
+
+        assert((new_size & (new_size - 1)) == 0);
+        assert(new_size >= this->num_elements * 2);
+
+        char *new_memory = internal::allocate_block(this->get_char_allocator(), get_memory_size(new_size), false);
+        assert(new_memory);
+
+        char   *base       = internal::align_to_cache_line(new_memory);
+        slot_t *new_slots  = reinterpret_cast<slot_t*>(base);
+        V      *new_values = reinterpret_cast<V*>(base + internal::round_up_to_cache_line(new_size * sizeof(slot_t)));
+
+        for (size_t i = 0; i < new_size; i++) {
+            new_slots[i].length = EMPTY;
+        }
+
+        if (this->memory) {
+            for (size_t i = 0; i <= this->capacity_minus_1; i++) {
+                if (this->slots[i].length == EMPTY) {
+                    continue;
+                }
+
+                size_t new_pos = this->slots[i].hash & (new_size - 1);
+                while (new_slots[new_pos].length != EMPTY) {
+                    new_pos = (new_pos + 1) & (new_size - 1);
+                }
+                new_slots[new_pos] = this->slots[i];
+                internal::relocate(&new_values[new_pos], this->value_table[i]);
+            }
+
+            internal::deallocate_block(this->get_char_allocator(), this->memory, get_memory_size(this->capacity_minus_1 + 1));
+        }
+
+        this->slots            = new_slots;
+        this->value_table      = new_values;
+        this->capacity_minus_1 = new_size - 1;
+        this->memory           = new_memory;
+    }
+
+
+
+    /* Replaces the arena by one with room for <extra_size> more bytes. The
+     * keys of the elements are compacted into the new arena, dropping the
+     * bytes of erased keys.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void grow_arena(size_t extra_size) {
+
+        // Offsets into the arena are 32-bit
+        const uint64_t max_capacity = ~uint32_t(0);
+        const size_t   live_size    = this->arena_size - this->arena_garbage;
+        if (uint64_t(live_size) + extra_size > max_capacity) {
+            HASH_CONTAINERS_THROW_LENGTH_ERROR("string_arena_hash_table: the keys exceed 4 GiB");
+        }
+
+        uint64_t new_capacity = (uint64_t(live_size) + extra_size) * 2;
+        if (new_capacity < MIN_ARENA_SIZE) {
+            new_capacity = MIN_ARENA_SIZE;
+        }
+        if (new_capacity > max_capacity) {
+            new_capacity = max_capacity;
+        }
+
+        char *new_arena = internal::allocate_block(this->get_char_allocator(), size_t(new_capacity), false);
+        assert(new_arena);
+
+        size_t new_size = 0;
+        for (size_t i = 0; i <= this->capacity_minus_1 && this->num_elements; i++) {
+            if (this->slots[i].length == EMPTY) {
+                continue;
+            }
+            // Empty keys may not have an arena to copy from
+            if (this->slots[i].length) {
+                memcpy(new_arena + new_size, this->arena + this->slots[i].offset, this->slots[i].length);
+            }
+            this->slots[i].offset = uint32_t(new_size);
+            new_size += this->slots[i].length;
+        }
+
+        if (this->arena) {
+            internal::deallocate_block(this->get_char_allocator(), this->arena, this->arena_capacity);
+        }
+
+        this->arena          = new_arena;
+        this->arena_size     = new_size;
+        this->arena_capacity = size_t(new_capacity);
+        this->arena_garbage  = 0;
+    }
+
+
+
+    /* Maps the key to a position in the table.
+     *
+     * Parameters:
+     *     <found>: (out) Set to true if the key was found in the container.
+     *     <key>  : The key to look-up.
+     *     <hash> : The hash of the <key> parameter, from get_hash().
+     *
+     * Returns:
+     *     If <found> is true, the position of the element. Otherwise, the
+     *     empty slot that ended the probe sequence.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t find_pos(bool &found /*out*/, const string_ref &key, uint32_t hash) const {
+
+        // The table is never full, so the probe ends on an empty slot
+        size_t pos = hash & this->capacity_minus_1;
+
+        found = false;
+
+        while (true) {
+            const slot_t &slot = this->slots[pos];
+
+            // Element doesn't exist
+            if (slot.length == EMPTY) {
+                return pos;
+            }
+
+            // Found element. The arena is only read when the hashes match.
+            if (slot.hash == hash && slot.length == key.size()
+             && (!slot.length || memcmp(this->arena + slot.offset, key.data(), key.size()) == 0)) {
+                found = true;
+                return pos;
+            }
+
+            // Didn't find it, try the next spot until we do (and wrap around at the ends)
+            pos = (pos + 1) & this->capacity_minus_1;
+        }
+    }
+
+
+
+    /* Maps the key to the position of its element.
+     *
+     * Returns:
+     *     The position of the element, or ~0 if the key isn't present.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_index(const string_ref &key) const {
+        bool found;
+        const size_t pos = this->find_pos(found, key, get_hash(key));
+        return found ? pos : ~size_t(0);
+    }
+
+
+
+    /* Adds a new element to the container. The element's key must *not*
+     * already be present, nor point into the arena.
+     *
+     * Iterators should be assumed to be invalid after add_new().
+     *
+     * Returns:
+     *     The position of the inserted element.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t add_new(const string_ref &key, const V &value, uint32_t hash) {
+
+        // The length of a key is 32-bit, and ~0 marks empty slots
+        if (uint64_t(key.size()) >= EMPTY) {
+            HASH_CONTAINERS_THROW_LENGTH_ERROR("string_arena_hash_table: key longer than 4 GiB");
+        }
+
+        // Keep the load factor at or below 1/2
+        if ((this->num_elements + 1) * 2 > this->capacity_minus_1 + 1) {
+            const size_t new_size = (this->capacity_minus_1 + 1) * 2;
+            this->resize_table(new_size > MIN_CAPACITY ? new_size : MIN_CAPACITY);
+        }
+        if (this->arena_size + key.size() > this->arena_capacity) {
+            this->grow_arena(key.size());
+        }
+
+        size_t pos = hash & this->capacity_minus_1;
+        while (this->slots[pos].length != EMPTY) {
+            pos = (pos + 1) & this->capacity_minus_1;
+        }
+
+        internal::construct(&this->value_table[pos], value);
+
+        // An empty key may have no arena, and a NULL data()
+        if (key.size()) {
+            memcpy(this->arena + this->arena_size, key.data(), key.size());
+        }
+        this->slots[pos].offset = uint32_t(this->arena_size);
+        this->slots[pos].length = uint32_t(key.size());
+        this->slots[pos].hash   = hash;
+        this->arena_size += key.size();
+
+        this->num_elements++;
+        return pos;
+    }
+
+
+
+    /* Erases the element at position <pos>. Its key bytes stay in the arena
+     * until it is compacted. The contiguous span of slots after <pos> is then
+     * rehashed, as erase_policy_rehash does, using the hashes kept in the
+     * slots.
+     */
+    HASH_CONTAINERS_NO_INLINE
+    void do_erase(size_t pos) {
+
+        internal::destroy(&this->value_table[pos]);
+        this->arena_garbage += this->slots[pos].length;
+        this->num_elements--;
+
+        size_t hole = pos;
+        for (size_t pos2 = (hole + 1) & this->capacity_minus_1; this->slots[pos2].length != EMPTY; pos2 = (pos2 + 1) & this->capacity_minus_1) {
+
+            const size_t home = this->slots[pos2].hash & this->capacity_minus_1;
+
+            if ((hole <= pos2) ? ((hole < home) && (home <= pos2)) : ((hole < home) || (home <= pos2))) {
+                continue;
+            }
+
+            this->slots[hole] = this->slots[pos2];
+            internal::relocate(&this->value_table[hole], this->value_table[pos2]);
+            hole = pos2;
+        }
+        this->slots[hole].length = EMPTY;
+    }
+
+
+
+    /* Destroys all the values of the container. */
+    HASH_CONTAINERS_INLINE
+    void destroy_values() {
+        if (!this->num_elements) {
+            return;
+        }
+        for (size_t i = 0; i <= this->capacity_minus_1; i++) {
+            if (this->slots[i].length != EMPTY) {
+                internal::destroy(&this->value_table[i]);
+            }
+        }
+    }
+
+
+
+    /* Returns the position of the first element at or after <pos>, or ~0
+     * if there are none.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t get_next_from(size_t pos) const {
+        if (!this->memory) {
+            return ~size_t(0);
+        }
+        for (; pos <= this->capacity_minus_1; pos++) {
+            if (this->slots[pos].length != EMPTY) {
+                return pos;
+            }
+        }
+        return ~size_t(0);
+    }
+
+
+
+    /* Containers can't be copied */
+    string_arena_hash_table(const string_arena_hash_table &);
+    string_arena_hash_table& operator=(const string_arena_hash_table &);
+
+
+
+public:
+    typedef allocator allocator_type;
+
+
+
+    /* Default constructor. No memory is allocated until the first insertion.
+     */
+    HASH_CONTAINERS_INLINE
+    string_arena_hash_table() {
+        this->init_empty_table();
+    }
+
+
+
+    /* Constructs an empty container, which will allocate memory through
+     * (a copy of) <alloc>.
+     */
+    HASH_CONTAINERS_INLINE
+    explicit string_arena_hash_table(const allocator_type &alloc)
+        : allocator_holder_t(char_allocator_t(alloc)) {
+        this->init_empty_table();
+    }
+
+
+
+    /* Destructor.
+     */
+    HASH_CONTAINERS_INLINE
+    ~string_arena_hash_table() {
+        this->destroy_values();
+        if (this->memory) {
+            internal::deallocate_block(this->get_char_allocator(), this->memory, get_memory_size(this->capacity_minus_1 + 1));
+        }
+        if (this->arena) {
+            internal::deallocate_block(this->get_char_allocator(), this->arena, this->arena_capacity);
+        }
+    }
+
+
+
+    /* Inserts an element in the container, copying the key into the arena.
+     * If the specified key is already present, then 'false' is returned and
+     * the container is not modified.
+     *
+     * Iterators, and the keys they refer to, should be assumed to be invalid
+     * after insert(), if it returns 'true'.
+     */
+    HASH_CONTAINERS_INLINE
+    bool insert(const string_ref &key, const V &value) {
+
+        const uint32_t hash = get_hash(key);
+
+        bool found;
+        this->find_pos(found, key, hash);
+        if (found) {
+            return false;
+        }
+        this->add_new(key, value, hash);
+        return true;
+    }
+
+
+
+    /* Erases an element from the container, if present.
+     *
+     * Iterators should be assumed to be invalid after erase().
+     */
+    HASH_CONTAINERS_INLINE
+    void erase(const string_ref &key) {
+
+        bool found;
+        const size_t pos = this->find_pos(found, key, get_hash(key));
+        if (found) {
+            this->do_erase(pos);
+        }
+    }
+
+
+
+    /* Returns the number of valid elements in the container. */
+    HASH_CONTAINERS_INLINE
+    size_t size() const {
+        return this->num_elements;
+    }
+
+
+
+    /* Returns the number of slots of the table. */
+    HASH_CONTAINERS_INLINE
+    size_t capacity() const {
+        return this->memory ? this->capacity_minus_1 + 1 : 0;
+    }
+
+
+
+    /* Returns the number of bytes of the arena, including the bytes of
+     * erased keys that haven't been compacted yet.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t arena_bytes() const {
+        return this->arena_size;
+    }
+
+
+
+    /* Returns a copy of the allocator of the container. */
+    HASH_CONTAINERS_INLINE
+    allocator_type get_allocator() const {
+        return allocator_type(this->get_char_allocator());
+    }
+
+
+
+    /* Makes room for <num_elements> elements, whose keys total
+     * <num_key_bytes> bytes, so that inserting them doesn't cause any
+     * reallocation.
+     */
+    void reserve(size_t num_elements, size_t num_key_bytes = 0) {
+        if (num_elements * 2 > this->capacity()) {
+            const size_t new_size = internal::round_up_to_next_power_of_2(num_elements * 2);
+            this->resize_table(new_size > MIN_CAPACITY ? new_size : MIN_CAPACITY);
+        }
+        if (this->arena_size + num_key_bytes > this->arena_capacity) {
+            this->grow_arena(num_key_bytes);
+        }
+    }
+
+
+
+    /*******************************************************************
+     * Iterator interface
+     *******************************************************************/
+
+    class const_iterator;
+
+    /* Iterator for the container. Keys are returned as string_refs into the
+     * arena.
+     */
+    class iterator : public std::iterator<std::forward_iterator_tag,
+                                          std::pair<string_ref, reference_wrapper<V> > > {
+
+        friend class string_arena_hash_table;
+        friend class const_iterator;
+
+    protected:
+
+        size_t                   pos;
+        string_arena_hash_table* table;
+
+        iterator(size_t pos, string_arena_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        iterator(const iterator& other) : pos(other.pos), table(other.table) { }
+
+
+        operator const_iterator() const {
+            return const_iterator(this->pos, this->table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        iterator& operator=(const iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<string_ref, reference_wrapper<V> > operator*() {
+            return std::pair<string_ref, reference_wrapper<V> >(this->table->get_key(this->pos), this->table->value_table[this->pos]);
+        }
+
+
+
+        iterator &operator++() {
+            this->pos = this->table->get_next_from(this->pos + 1);
+            return *this;
+        }
+
+
+
+        iterator operator++(int) {
+            const iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Constant Iterator for the container */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<string_ref, reference_wrapper<const V> > > {
+
+        friend class string_arena_hash_table;
+        friend class iterator;
+
+    protected:
+
+        size_t                         pos;
+        const string_arena_hash_table* table;
+
+        const_iterator(size_t pos, const string_arena_hash_table* table) : pos(pos), table(table) { }
+
+    public:
+        const_iterator(const const_iterator& other) : pos(other.pos), table(other.table) { }
+        const_iterator(const       iterator& other) : pos(other.pos), table(other.table) { }
+
+
+
+        bool operator==(const const_iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator==(const iterator& other) const {
+            return (this->pos   == other.pos)
+                && (this->table == other.table);
+        }
+
+
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+
+
+        const_iterator& operator=(const const_iterator &other) {
+            this->pos   = other.pos;
+            this->table = other.table;
+            return *this;
+        }
+
+
+
+        std::pair<string_ref, reference_wrapper<const V> > operator*() {
+            return std::pair<string_ref, reference_wrapper<const V> >(this->table->get_key(this->pos), this->table->value_table[this->pos]);
+        }
+
+
+
+        const_iterator &operator++() {
+            this->pos = this->table->get_next_from(this->pos + 1);
+            return *this;
+        }
+
+
+
+        const_iterator operator++(int) {
+            const const_iterator old(*this);
+            ++(*this);
+            return old;
+        }
+    };
+
+
+
+    /* Returns an iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator begin() {
+        return iterator(this->get_next_from(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to the first element in the container. */
+    HASH_CONTAINERS_INLINE
+    const_iterator cbegin() const {
+        return const_iterator(this->get_next_from(0), this);
+    }
+
+
+
+    /* Returns an iterator to one past the last element in the container. */
+    HASH_CONTAINERS_INLINE
+    iterator end() {
+        return iterator(~size_t(0), this);
+    }
+
+
+
+    /* Returns a constant iterator to one past the last element in the
+     * container.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator cend() const {
+        return const_iterator(~size_t(0), this);
+    }
+
+
+
+    /* Looks up the specified key and returns a reference to the corresponding
+     * value. If the key is not present in the container, then a value object
+     * is default-constructed and inserted in the container, and then a
+     * reference to that object is returned.
+     *
+     * Because the operator can insert new elements, iterators are to be
+     * considered invalidated after use.
+     */
+    HASH_CONTAINERS_INLINE
+    V& operator[](const string_ref &key) {
+
+        const uint32_t hash = get_hash(key);
+
+        bool found;
+        size_t pos = this->find_pos(found, key, hash);
+
+        if (!found) {
+            pos = this->add_new(key, V(), hash);
+        }
+        return this->value_table[pos];
+    }
+
+
+
+    /* Counts the number of elements in the container matching the specified
+     * key: 0 or 1.
+     */
+    HASH_CONTAINERS_INLINE
+    size_t count(const string_ref &key) const {
+        return this->get_index(key) != ~size_t(0) ? 1 : 0;
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     A constant iterator to the element in the container. cend() is
+     *     returned if no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    const_iterator find(const string_ref &key) const {
+        return const_iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Finds an element in the container using the specified key.
+     *
+     * Returns:
+     *     An iterator to the element in the container. end() is returned if
+     *     no element matches the specified key.
+     */
+    HASH_CONTAINERS_INLINE
+    iterator find(const string_ref &key) {
+        return iterator(this->get_index(key), this);
+    }
+
+
+
+    /* Clears the content of the container. The capacity of the table and of
+     * the arena are unchanged.
+     *
+     * Iterators are invalidated by clear().
+     */
+    HASH_CONTAINERS_INLINE
+    void clear() {
+        if (!this->memory) {
+            return;
+        }
+
+        this->destroy_values();
+        for (size_t i = 0; i <= this->capacity_minus_1; i++) {
+            this->slots[i].length = EMPTY;
+        }
+        this->num_elements  = 0;
+        this->arena_size    = 0;
+        this->arena_garbage = 0;
+    }
+
+}; // class string_arena_hash_table
+
+}; // namespace hash_containers
+
+
+#endif /* INCLUDE_HASH_CONTAINERS_STRING_ARENA_HASH_TABLE_H_GUARD */
+
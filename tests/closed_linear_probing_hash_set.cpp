@@ -0,0 +1,220 @@
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+#define _CRTDBG_MAP_ALLOC
+#include <stdlib.h>
+#include <crtdbg.h>
+
+#ifndef DBG_NEW
+   #define DBG_NEW new ( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+   #define new DBG_NEW
+#endif
+
+#endif
+
+
+#include "closed_linear_probing_hash_set.h"
+#include "counting_allocator.h"
+
+#include <random>
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdio.h>
+#include <unordered_set>
+#include <algorithm>
+#include <vector>
+#include <string>
+
+
+
+/* Test basic methods, against std::unordered_set<> */
+template <typename set_t>
+int run_set_test(unsigned test_num, uint64_t random_number, bool debug) {
+
+    std::unordered_set<uint32_t> gold;
+    set_t comp;
+
+    const unsigned num_operations = ((random_number >> 48) & 2047) + 1; // 1-2048
+    const uint32_t key_mask = (1u << ((random_number >> 32) & 11)) - 1;  // 1-1024 keys
+
+    std::mt19937 rng(test_num);
+
+    if (debug) {
+        printf("test_num: %u,  random_number: 0x%016llx\n", test_num, random_number);
+    }
+
+    for (unsigned i = 0; i < num_operations; i++) {
+        const uint8_t  mode = (random_number >> ((i % 13) * 2)) & 3;
+        const uint32_t key  = static_cast<uint32_t>(rng()) & key_mask;
+
+        switch (mode) {
+        case 0:
+        case 2:
+            if (debug) {
+                printf("/*%4u*/ gold.insert(0x%08x);     comp.insert(0x%08x);\n", i, key, key);
+            }
+            if (gold.insert(key).second != comp.insert(key)) {
+                if (debug) {
+                    printf("insert(0x%08x) mismatch\n", key);
+                }
+                return 1;
+            }
+            break;
+        case 1:
+            if (debug) {
+                printf("/*%4u*/ gold.erase(0x%08x);     comp.erase(0x%08x);\n", i, key, key);
+            }
+            gold.erase(key);
+            comp.erase(key);
+            break;
+        case 3:
+            if (gold.count(key) != comp.count(key) || comp.contains(key) != (gold.count(key) != 0)
+             || (gold.count(key) && *comp.find(key) != key)
+             || (!gold.count(key) && comp.find(key) != comp.cend())) {
+                if (debug) {
+                    printf("/*%4u*/ lookup mismatch for key 0x%08x\n", i, key);
+                }
+                return 1;
+            }
+            if (((random_number >> 40) & 0xff) == 0) {
+                if (debug) {
+                    printf("gold.clear();  comp.clear();\n");
+                }
+                gold.clear();
+                comp.clear();
+            }
+            break;
+        }
+    }
+
+    std::vector<uint32_t> gold_v(gold.cbegin(), gold.cend());
+    std::vector<uint32_t> comp_v(comp.cbegin(), comp.cend());
+
+    std::sort(gold_v.begin(), gold_v.end());
+    std::sort(comp_v.begin(), comp_v.end());
+
+    if (gold_v != comp_v || gold.size() != comp.size()) {
+        if (debug) {
+            printf("data mismatch: gold: %u keys vs comp: %u keys\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int run_test(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    const uint32_t variant = static_cast<uint32_t>((random_number >> 62) & 3);
+
+    switch (variant) {
+    case  0: return run_set_test<hash_containers::closed_linear_probing_hash_set<uint32_t> >(test_num, random_number, debug);
+    case  1: return run_set_test<hash_containers::closed_linear_probing_hash_set<uint32_t, std::hash<uint32_t>, hash_containers::erase_policy_use_marker> >(test_num, random_number, debug);
+    case  2: return run_set_test<hash_containers::closed_linear_probing_hash_set<uint32_t, std::hash<uint32_t>, hash_containers::erase_policy_rehash, 0> >(test_num, random_number, debug);
+    case  3: return run_set_test<hash_containers::closed_linear_probing_hash_set<uint32_t, std::hash<uint32_t>, hash_containers::erase_policy_use_marker, 8,
+                                                                                 hash_containers::table_allocator<char>, hash_containers::shrink_policy_hysteresis<> > >(test_num, random_number, debug);
+    default: assert(0);
+    }
+
+    return 1;
+}
+
+
+
+/* Test that sets don't allocate memory for values */
+int run_directed_test_0(bool debug = false) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        typedef hash_containers::closed_linear_probing_hash_set<std::string, std::hash<std::string>, hash_containers::erase_policy_rehash, 32,
+                                                                counting_allocator<char> > set_t;
+
+        set_t comp((set_t::allocator_type(&bytes_in_use)));
+
+        for (uint32_t i = 0; i < 10000; i++) {
+            comp.insert(std::to_string(i));
+        }
+        for (uint32_t i = 0; i < 10000; i += 2) {
+            comp.erase(std::to_string(i));
+        }
+
+        // Meta-data and keys only, plus alignment padding
+        const size_t expected_size = comp.capacity() / 8 + comp.capacity() * sizeof(std::string) + 2 * HASH_CONTAINERS_CACHE_LINE_SIZE;
+        if (comp.size() != 5000 || bytes_in_use > expected_size) {
+            if (debug) {
+                printf("In directed test 0:\n%u keys, %u bytes in use, expected at most %u\n", unsigned(comp.size()), unsigned(bytes_in_use), unsigned(expected_size));
+            }
+            return 1;
+        }
+
+        for (uint32_t i = 0; i < 10000; i++) {
+            if (comp.contains(std::to_string(i)) != ((i & 1) == 1)) {
+                if (debug) {
+                    printf("In directed test 0:\nkey %u mismatch\n", i);
+                }
+                return 1;
+            }
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("In directed test 0:\n%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int main() {
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
+    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
+#endif
+
+    /* Directed tests */
+
+    int ret;
+    ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+
+
+    /* Randoms tests */
+
+    std::mt19937_64 rng(static_cast<uint32_t>(time(NULL)));
+
+#ifdef _DEBUG
+    unsigned max_test =  0x1000;
+#else
+    unsigned max_test = 0x10000;
+#endif
+
+    printf("      ");
+    for (unsigned test_num = 0; test_num < max_test; test_num++) {
+
+        uint64_t rnd = rng();
+
+        int ret = run_test(test_num, rnd);
+        if (ret) {
+            run_test(test_num, rnd, /*debug*/true);
+            return ret;
+        }
+
+        if (!(test_num & 0xff)) {
+            printf("\b\b\b\b\b\b%5.1f%%", test_num / double(max_test) * 100);
+            fflush(stdout);
+        }
+    }
+    printf("\b\b\b\b\b\b100.0%%\n");
+    return 0;
+}
@@ -12,6 +12,8 @@
 
 
 #include "closed_linear_probing_hash_table.h"
+#include "monotonic_arena.h"
+#include "counting_allocator.h"
 
 #include <random>
 #include <assert.h>
@@ -188,6 +190,9 @@ int run_test_02(unsigned test_num, uint64_t random_number, bool debug=false) {
     hash_containers::closed_linear_probing_hash_table<uint8_t, uint32_t,
                                                       std::hash<uint8_t>,
                                                       hash_containers::erase_policy_rehash, 128> comp2;
+    hash_containers::closed_linear_probing_hash_table<uint8_t, uint32_t,
+                                                      std::hash<uint8_t>,
+                                                      hash_containers::erase_policy_rehash, 0> comp3;
 
     const unsigned primes[] = { 3, 5, 7, 11 };
     const unsigned num_operations = ((random_number >> 48) & 1023) + 1; // 1-1024
@@ -211,12 +216,14 @@ int run_test_02(unsigned test_num, uint64_t random_number, bool debug=false) {
             comp0[key] = value;
             comp1[key] = value;
             comp2[key] = value;
+            comp3[key] = value;
         }
         else {
             gold.erase(key);
             comp0.erase(key);
             comp1.erase(key);
             comp2.erase(key);
+            comp3.erase(key);
         }
 
         if (debug) {
@@ -233,20 +240,23 @@ int run_test_02(unsigned test_num, uint64_t random_number, bool debug=false) {
     std::vector<std::pair<uint32_t, uint32_t> > comp0_v(comp0.cbegin(), comp0.cend());
     std::vector<std::pair<uint32_t, uint32_t> > comp1_v(comp1.cbegin(), comp1.cend());
     std::vector<std::pair<uint32_t, uint32_t> > comp2_v(comp2.cbegin(), comp2.cend());
+    std::vector<std::pair<uint32_t, uint32_t> > comp3_v(comp3.cbegin(), comp3.cend());
 
     std::sort( gold_v.begin(),  gold_v.end());
     std::sort(comp0_v.begin(), comp0_v.end());
     std::sort(comp1_v.begin(), comp1_v.end());
     std::sort(comp2_v.begin(), comp2_v.end());
+    std::sort(comp3_v.begin(), comp3_v.end());
 
     if (debug) {
-        const size_t size_min = std::min(gold_v.size(), std::min(comp0_v.size(), std::min(comp1_v.size(), comp2_v.size())));
+        const size_t size_min = std::min(gold_v.size(), std::min(comp0_v.size(), std::min(comp1_v.size(), std::min(comp2_v.size(), comp3_v.size()))));
 
         for (size_t i = 0; i < size_min; i++) {
             if (gold_v[i] != comp0_v[i]
              || gold_v[i] != comp1_v[i]
-             || gold_v[i] != comp2_v[i]) {
-                printf("gold[0x%02x] = 0x%08x; comp0[0x%02x] = 0x%08x; comp1[0x%02x] = 0x%08x; comp2[0x%02x] = 0x%08x; /* at idx=%u */\n", gold_v[i].first, gold_v[i].second, comp0_v[i].first, comp0_v[i].second, comp1_v[i].first, comp1_v[i].second, comp2_v[i].first, comp2_v[i].second, i);
+             || gold_v[i] != comp2_v[i]
+             || gold_v[i] != comp3_v[i]) {
+                printf("gold[0x%02x] = 0x%08x; comp0[0x%02x] = 0x%08x; comp1[0x%02x] = 0x%08x; comp2[0x%02x] = 0x%08x; comp3[0x%02x] = 0x%08x; /* at idx=%u */\n", gold_v[i].first, gold_v[i].second, comp0_v[i].first, comp0_v[i].second, comp1_v[i].first, comp1_v[i].second, comp2_v[i].first, comp2_v[i].second, comp3_v[i].first, comp3_v[i].second, i);
             }
         }
         for (size_t i = size_min; i < gold_v.size(); i++) {
@@ -261,6 +271,9 @@ int run_test_02(unsigned test_num, uint64_t random_number, bool debug=false) {
         for (size_t i = size_min; i < comp2_v.size(); i++) {
             printf("comp2[0x%02x] = 0x%08x; /* at idx=%u */\n", comp2_v[i].first, comp2_v[i].second, i);
         }
+        for (size_t i = size_min; i < comp3_v.size(); i++) {
+            printf("comp3[0x%02x] = 0x%08x; /* at idx=%u */\n", comp3_v[i].first, comp3_v[i].second, i);
+        }
         printf("");
         return 1;
     }
@@ -280,6 +293,11 @@ int run_test_02(unsigned test_num, uint64_t random_number, bool debug=false) {
         return 1;
     }
 
+    if (gold_v.size() != comp3_v.size()) {
+        printf("size mismatch: gold: %u vs comp3: %u\n", gold_v.size(), comp3_v.size());
+        return 1;
+    }
+
     auto u0 = std::mismatch(gold_v.begin(), gold_v.end(), comp0_v.begin());
     if (u0.first != gold_v.end()) {
         printf("data mismatch: gold (%u, %u) vs comp0: (%u, %u)\n", u0.first->first, u0.first->second, u0.second->first, u0.second->second);
@@ -298,6 +316,12 @@ int run_test_02(unsigned test_num, uint64_t random_number, bool debug=false) {
         return 1;
     }
 
+    auto u3 = std::mismatch(gold_v.begin(), gold_v.end(), comp3_v.begin());
+    if (u3.first != gold_v.end()) {
+        printf("data mismatch: gold (%u, %u) vs comp3: (%u, %u)\n", u3.first->first, u3.first->second, u3.second->first, u3.second->second);
+        return 1;
+    }
+
     return 0;
 }
 
@@ -887,6 +911,15 @@ int run_directed_test_0(bool debug = false) {
     gold[99] = 2;
     gold[ 0] = 8;
     gold[ 1] = 6;
+
+    // Slot 0 is the first slot of the key and value arrays, which must be cache line aligned
+    if ((reinterpret_cast<uintptr_t>(&(*comp.find(0)).first.get()) & 63)
+     || (reinterpret_cast<uintptr_t>(&(*comp.find(0)).second.get()) & 63)) {
+        if (debug) {
+            printf("In directed test 0:\narrays are not cache line aligned\n");
+        }
+        return 1;
+    }
     
     std::vector<std::pair<uint32_t, uint32_t> > gold_v(gold.cbegin(), gold.cend());
     std::vector<std::pair<uint32_t, uint32_t> > comp_v(comp.cbegin(), comp.cend());
@@ -927,19 +960,2317 @@ int run_directed_test_0(bool debug = false) {
 
 
 
-int main() {
-    
-#if (defined _DEBUG) && (defined _MSC_VER)
-    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
-    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
-#endif
+/* Test tables large enough to be backed by huge pages */
+int run_directed_test_1(bool debug = false) {
 
-    /* Directed tests */
+    std::unordered_map<uint32_t, uint32_t> gold;
+    hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t> comp;
 
-    int ret;
-    ret = run_directed_test_0();
-    if (ret) {
-        run_directed_test_0(/*debug*/true);
+    std::mt19937 rng(1);
+
+    // Grow through the huge page threshold
+    for (unsigned i = 0; i < (1u << 20); i++) {
+        const uint32_t key   = rng();
+        const uint32_t value = rng();
+        gold[key] = value;
+        comp[key] = value;
+
+        if (i & 1) {
+            const uint32_t erase_key = rng() & 0xffff;
+            gold.erase(erase_key);
+            comp.erase(erase_key);
+        }
+    }
+
+    if (gold.size() != comp.size()) {
+        if (debug) {
+            printf("In directed test 1:\nsize mismatch: gold: %u vs comp: %u\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+
+    for (std::unordered_map<uint32_t, uint32_t>::const_iterator it = gold.cbegin(); it != gold.cend(); ++it) {
+        if (!comp.count(it->first) || comp[it->first] != it->second) {
+            if (debug) {
+                printf("In directed test 1:\ngold[0x%08x] = 0x%08x; comp is missing or different\n", it->first, it->second);
+            }
+            return 1;
+        }
+    }
+
+    // Clearing drops the pages of the table, which must read back as empty
+    const size_t capacity = comp.capacity();
+    comp.clear();
+
+    if (comp.size() || comp.capacity() != capacity || comp.cbegin() != comp.cend() || comp.count(gold.cbegin()->first)) {
+        if (debug) {
+            printf("In directed test 1:\ntable not empty after clear()\n");
+        }
+        return 1;
+    }
+
+    comp[1] = 2;
+    comp[3] = 4;
+    if (comp.size() != 2 || comp[1] != 2 || comp[3] != 4) {
+        if (debug) {
+            printf("In directed test 1:\ntable broken after clear()\n");
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Test user-supplied allocators */
+int run_directed_test_2(bool debug = false) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                                  hash_containers::erase_policy_rehash, 32,
+                                                                  counting_allocator<std::pair<const uint32_t, std::string> > > table_t;
+
+        std::unordered_map<uint32_t, std::string> gold;
+        table_t comp((table_t::allocator_type(&bytes_in_use)));
+
+        for (uint32_t i = 0; i < 1000; i++) {
+            gold[i * 7] = std::to_string(i);
+            comp[i * 7] = std::to_string(i);
+        }
+        for (uint32_t i = 0; i < 1000; i += 3) {
+            gold.erase(i * 7);
+            comp.erase(i * 7);
+        }
+
+        if (!bytes_in_use || comp.get_allocator().bytes_in_use != &bytes_in_use) {
+            if (debug) {
+                printf("In directed test 2:\nallocator was not used\n");
+            }
+            return 1;
+        }
+
+        std::vector<std::pair<uint32_t, std::string> > gold_v(gold.cbegin(), gold.cend());
+        std::vector<std::pair<uint32_t, std::string> > comp_v;
+        for (table_t::const_iterator it = comp.cbegin(); it != comp.cend(); ++it) {
+            comp_v.push_back(std::make_pair((*it).first.get(), (*it).second.get()));
+        }
+
+        std::sort(gold_v.begin(), gold_v.end());
+        std::sort(comp_v.begin(), comp_v.end());
+
+        if (gold_v != comp_v) {
+            if (debug) {
+                printf("In directed test 2:\ndata mismatch\n");
+            }
+            return 1;
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("In directed test 2:\n%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Test many short-lived tables on a monotonic arena */
+int run_directed_test_3(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_use_marker, 8,
+                                                              hash_containers::arena_allocator<char> > table_t;
+
+    char buffer[1024];
+    hash_containers::monotonic_arena arena(buffer, sizeof(buffer));
+
+    for (unsigned round = 0; round < 4; round++) {
+        {
+            std::vector<std::unordered_map<uint32_t, std::string> > gold(16);
+            std::vector<table_t *>                                  comp(16);
+
+            for (size_t t = 0; t < comp.size(); t++) {
+                comp[t] = new table_t(hash_containers::arena_allocator<char>(&arena));
+            }
+
+            for (uint32_t i = 0; i < 300; i++) {
+                for (size_t t = 0; t < comp.size(); t++) {
+                    const uint32_t key = (i * 13 + uint32_t(t)) % 200;
+                    gold[t][key]     = std::to_string(i + round);
+                    (*comp[t])[key]  = std::to_string(i + round);
+                    if (i % 5 == 0) {
+                        gold[t].erase(key / 2);
+                        comp[t]->erase(key / 2);
+                    }
+                }
+            }
+
+            for (size_t t = 0; t < comp.size(); t++) {
+                if (gold[t].size() != comp[t]->size()) {
+                    if (debug) {
+                        printf("In directed test 3:\nsize mismatch in table %u: gold: %u vs comp: %u\n", unsigned(t), unsigned(gold[t].size()), unsigned(comp[t]->size()));
+                    }
+                    return 1;
+                }
+                for (std::unordered_map<uint32_t, std::string>::const_iterator it = gold[t].cbegin(); it != gold[t].cend(); ++it) {
+                    if ((*comp[t])[it->first] != it->second) {
+                        if (debug) {
+                            printf("In directed test 3:\ndata mismatch in table %u for key %u\n", unsigned(t), it->first);
+                        }
+                        return 1;
+                    }
+                }
+                delete comp[t];
+            }
+        }
+
+        // Release every table's memory in one shot
+        arena.release();
+    }
+
+    return 0;
+}
+
+
+
+/* Test containers without inline storage */
+int run_directed_test_4(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 0> table_t;
+
+    table_t comp;
+
+    // Empty containers share a read-only empty table
+    if (sizeof(comp) >= sizeof(hash_containers::closed_linear_probing_hash_table<uint32_t, std::string>) / 8
+     || comp.capacity() || comp.size() || comp.count(1) || comp.find(1) != comp.end() || comp.cbegin() != comp.cend()) {
+        if (debug) {
+            printf("In directed test 4:\nempty container is not empty\n");
+        }
+        return 1;
+    }
+    comp.erase(1);
+    comp.clear();
+
+    std::unordered_map<uint32_t, std::string> gold;
+    for (uint32_t i = 0; i < 500; i++) {
+        gold[i * 3] = std::to_string(i);
+        comp[i * 3] = std::to_string(i);
+    }
+    for (uint32_t i = 0; i < 500; i += 2) {
+        gold.erase(i * 3);
+        comp.erase(i * 3);
+    }
+
+    if (!comp.capacity() || gold.size() != comp.size()) {
+        if (debug) {
+            printf("In directed test 4:\nsize mismatch: gold: %u vs comp: %u\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+    for (std::unordered_map<uint32_t, std::string>::const_iterator it = gold.cbegin(); it != gold.cend(); ++it) {
+        if (!comp.count(it->first) || comp[it->first] != it->second) {
+            if (debug) {
+                printf("In directed test 4:\ndata mismatch for key %u\n", it->first);
+            }
+            return 1;
+        }
+    }
+
+    comp.clear();
+    if (comp.size() || comp.cbegin() != comp.cend()) {
+        if (debug) {
+            printf("In directed test 4:\ncontainer not empty after clear()\n");
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int run_directed_test_5(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 32, hash_containers::table_allocator<char>,
+                                                              hash_containers::shrink_policy_hysteresis<> > table_t;
+
+    table_t comp;
+    std::unordered_map<uint32_t, std::string> gold;
+
+    for (uint32_t i = 0; i < 4000; i++) {
+        gold[i * 7] = std::to_string(i);
+        comp[i * 7] = std::to_string(i);
+    }
+    const size_t max_capacity = comp.capacity();
+
+    // Mass erase shrinks the table
+    for (uint32_t i = 0; i < 4000; i++) {
+        if (i % 64) {
+            gold.erase(i * 7);
+            comp.erase(i * 7);
+        }
+    }
+
+    if (comp.capacity() >= max_capacity / 8 || gold.size() != comp.size()) {
+        if (debug) {
+            printf("In directed test 5:\ntable not shrunk: capacity %u -> %u, size: gold: %u vs comp: %u\n",
+                   unsigned(max_capacity), unsigned(comp.capacity()), unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+    for (std::unordered_map<uint32_t, std::string>::const_iterator it = gold.cbegin(); it != gold.cend(); ++it) {
+        if (!comp.count(it->first) || comp[it->first] != it->second) {
+            if (debug) {
+                printf("In directed test 5:\ndata mismatch for key %u\n", it->first);
+            }
+            return 1;
+        }
+    }
+
+    // Growing back, then shrinking into the inline storage
+    comp.rehash(1000);
+    if (comp.capacity() != 1024 || gold.size() != comp.size()) {
+        if (debug) {
+            printf("In directed test 5:\nrehash(1000) gave capacity %u\n", unsigned(comp.capacity()));
+        }
+        return 1;
+    }
+    for (uint32_t i = 0; i < 4000; i++) {
+        if (i % 512) {
+            gold.erase(i * 7);
+            comp.erase(i * 7);
+        }
+    }
+    comp.shrink_to_fit();
+    if (comp.capacity() != 32 || gold.size() != comp.size()) {
+        if (debug) {
+            printf("In directed test 5:\nshrink_to_fit() gave capacity %u\n", unsigned(comp.capacity()));
+        }
+        return 1;
+    }
+    for (std::unordered_map<uint32_t, std::string>::const_iterator it = gold.cbegin(); it != gold.cend(); ++it) {
+        if (!comp.count(it->first) || comp[it->first] != it->second) {
+            if (debug) {
+                printf("In directed test 5:\ndata mismatch for key %u after shrink_to_fit()\n", it->first);
+            }
+            return 1;
+        }
+    }
+
+    // Tables without inline storage go back to the empty table
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_rehash, 0> comp2;
+    for (uint32_t i = 0; i < 100; i++) {
+        comp2[i] = std::to_string(i);
+    }
+    for (uint32_t i = 0; i < 100; i++) {
+        comp2.erase(i);
+    }
+    comp2.shrink_to_fit();
+    if (comp2.capacity() || comp2.size() || comp2.cbegin() != comp2.cend()) {
+        if (debug) {
+            printf("In directed test 5:\nempty table kept capacity %u\n", unsigned(comp2.capacity()));
+        }
+        return 1;
+    }
+    comp2[5] = "5";
+    if (comp2.size() != 1 || comp2[5] != "5") {
+        return 1;
+    }
+
+    // Never-used tables without inline storage stay without memory
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_rehash, 0> comp3;
+    for (unsigned i = 0; i < 3; i++) {
+        comp3.shrink_to_fit();
+        if (comp3.capacity() || comp3.size()) {
+            if (debug) {
+                printf("In directed test 5:\nshrink_to_fit() gave an empty table capacity %u\n", unsigned(comp3.capacity()));
+            }
+            return 1;
+        }
+    }
+    comp3.rehash(0);
+    if (comp3.capacity()) {
+        return 1;
+    }
+
+    // Overfull tables don't grow
+    hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_rehash, 8> comp4;
+    for (uint32_t i = 0; i < 8; i++) {
+        comp4[i] = i;
+    }
+    const size_t capacity4 = comp4.capacity();
+    comp4.shrink_to_fit();
+    if (comp4.capacity() != capacity4 || comp4.size() != 8) {
+        if (debug) {
+            printf("In directed test 5:\nshrink_to_fit() grew the table to %u\n", unsigned(comp4.capacity()));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Check a table using erase_policy_empty_key<> against std::unordered_map<>,
+ * with keys that are never the reserved ones.
+ */
+template <typename table_t>
+int run_empty_key_test(table_t &comp, uint32_t seed, bool debug) {
+
+    std::unordered_map<uint64_t, uint32_t> gold;
+    std::mt19937 rng(seed);
+
+    for (unsigned i = 0; i < 20000; i++) {
+        const uint64_t key = (rng() & 1023) + 2;
+
+        if (rng() & 1) {
+            gold[key] = i;
+            comp[key] = i;
+        }
+        else {
+            gold.erase(key);
+            comp.erase(key);
+        }
+    }
+
+    size_t num_iterated = 0;
+    for (typename table_t::const_iterator it = comp.cbegin(); it != comp.cend(); ++it, num_iterated++) {
+        const uint64_t key = (*it).first.get();
+        if (!gold.count(key) || gold[key] != (*it).second.get()) {
+            if (debug) {
+                printf("In directed test 6:\ndata mismatch for key %u\n", unsigned(key));
+            }
+            return 1;
+        }
+    }
+    if (num_iterated != gold.size() || comp.size() != gold.size() || comp.count(3) != gold.count(3)) {
+        if (debug) {
+            printf("In directed test 6:\nsize: gold: %u vs comp: %u (%u iterated)\n", unsigned(gold.size()), unsigned(comp.size()), unsigned(num_iterated));
+        }
+        return 1;
+    }
+
+    comp.clear();
+    if (comp.size() || comp.cbegin() != comp.cend() || comp.count(3)) {
+        if (debug) {
+            printf("In directed test 6:\ncontainer not empty after clear()\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test the erase policy using reserved keys instead of meta-data */
+int run_directed_test_6(bool debug = false) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        // Empty key only: erase() rehashes
+        typedef hash_containers::closed_linear_probing_hash_table<uint64_t, uint32_t, std::hash<uint64_t>,
+                                                                  hash_containers::erase_policy_empty_key<uint64_t>, 32,
+                                                                  counting_allocator<char> > table0_t;
+        // Empty and deleted keys, without inline storage
+        typedef hash_containers::closed_linear_probing_hash_table<uint64_t, uint32_t, std::hash<uint64_t>,
+                                                                  hash_containers::erase_policy_empty_key<uint64_t, 0, 1>, 0,
+                                                                  counting_allocator<char> > table1_t;
+        // Shrinking back into the inline storage
+        typedef hash_containers::closed_linear_probing_hash_table<uint64_t, uint32_t, std::hash<uint64_t>,
+                                                                  hash_containers::erase_policy_empty_key<uint64_t>, 8,
+                                                                  counting_allocator<char>, hash_containers::shrink_policy_hysteresis<> > table2_t;
+
+        table0_t comp0((table0_t::allocator_type(&bytes_in_use)));
+        table1_t comp1((table1_t::allocator_type(&bytes_in_use)));
+        table2_t comp2((table2_t::allocator_type(&bytes_in_use)));
+
+        if (run_empty_key_test(comp0, 0, debug)
+         || run_empty_key_test(comp1, 1, debug)
+         || run_empty_key_test(comp2, 2, debug)) {
+            return 1;
+        }
+
+        // The heap block only holds keys and values
+        const size_t bytes_before = bytes_in_use;
+        table1_t comp3((table1_t::allocator_type(&bytes_in_use)));
+        comp3.reserve(1024);
+        const size_t expected_size = 1024 * (sizeof(uint64_t) + sizeof(uint32_t)) + 2 * HASH_CONTAINERS_CACHE_LINE_SIZE;
+        if (bytes_in_use - bytes_before > expected_size) {
+            if (debug) {
+                printf("In directed test 6:\n%u bytes in use, expected at most %u\n", unsigned(bytes_in_use - bytes_before), unsigned(expected_size));
+            }
+            return 1;
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("In directed test 6:\n%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Value type counting its constructions */
+struct counted_value {
+    static unsigned num_constructed;
+    int value;
+
+    counted_value(int value = 0) : value(value) { num_constructed++; }
+    counted_value(const counted_value &other) : value(other.value) { num_constructed++; }
+    counted_value &operator=(const counted_value &other) { value = other.value; return *this; }
+};
+
+unsigned counted_value::num_constructed = 0;
+
+
+
+/* Test move-only values, in-place construction and rvalue insertion */
+template <typename table_t>
+int run_move_only_test(table_t &comp, bool debug) {
+
+    // Enough elements to resize, and erase() to move elements around
+    for (uint32_t i = 0; i < 1000; i++) {
+        std::pair<typename table_t::iterator, bool> ret = comp.try_emplace(i, new uint32_t(i));
+        if (!ret.second || *(*ret.first).second.get() != i) {
+            if (debug) {
+                printf("try_emplace(%u) failed\n", i);
+            }
+            return 1;
+        }
+    }
+    for (uint32_t i = 0; i < 1000; i += 3) {
+        comp.erase(i);
+    }
+
+    std::unique_ptr<uint32_t> p(new uint32_t(2000));
+    if (!comp.insert(2000, std::move(p)) || p
+     || comp.try_emplace(1).second
+     || comp.emplace(2001u, new uint32_t(2001)).second == false
+     || comp.insert_or_assign(1, std::unique_ptr<uint32_t>(new uint32_t(5))).second
+     || !comp.insert_or_assign(0, std::unique_ptr<uint32_t>(new uint32_t(6))).second) {
+        if (debug) {
+            printf("insert failed\n");
+        }
+        return 1;
+    }
+
+    p.reset(new uint32_t(7));
+    if (comp.insert(2000, std::move(p)) || !p || *p != 7) {
+        if (debug) {
+            printf("insert of an existing key moved the value\n");
+        }
+        return 1;
+    }
+
+    for (uint32_t i = 1; i < 1000; i++) {
+        const uint32_t expected = (i == 1) ? 5 : i;
+        if (!comp.count(i) != !(i % 3) || ((i % 3) && *comp[i] != expected)) {
+            if (debug) {
+                printf("value of key %u is wrong\n", i);
+            }
+            return 1;
+        }
+    }
+    if (comp.size() != 1000 - 334 + 3 || *comp[0] != 6 || *comp[2000] != 2000 || *comp[2001] != 2001) {
+        if (debug) {
+            printf("size is wrong: %u\n", unsigned(comp.size()));
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test move semantics and in-place construction */
+int run_directed_test_7(bool debug = false) {
+
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::unique_ptr<uint32_t>, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_rehash> comp0;
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::unique_ptr<uint32_t>, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_use_marker, 16> comp1;
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::unique_ptr<uint32_t>, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_empty_key<uint32_t> > comp2;
+
+    if (run_move_only_test(comp0, debug) || run_move_only_test(comp1, debug) || run_move_only_test(comp2, debug)) {
+        if (debug) {
+            printf("In directed test 7:\nmove-only test failed\n");
+        }
+        return 1;
+    }
+
+    // Keys are moved in only when inserted
+    hash_containers::closed_linear_probing_hash_table<std::string, counted_value> comp3;
+    std::string key(100, 'x');
+    comp3[std::move(key)] = 1;
+    key = std::string(100, 'x');
+    comp3.try_emplace(std::move(key), 2);
+
+    // Values are constructed in place, and only for new keys: the only
+    // other construction is the assigned temporary
+    counted_value::num_constructed = 0;
+    comp3.try_emplace(std::string(100, 'x'), 3);
+    comp3.try_emplace("y", 4);
+    comp3["z"];
+    comp3.insert_or_assign("z", counted_value(5));
+    if (key.size() != 100 || comp3.size() != 3 || counted_value::num_constructed != 3
+     || comp3[key].value != 1 || comp3["y"].value != 4 || comp3["z"].value != 5) {
+        if (debug) {
+            printf("In directed test 7:\n%u values constructed\n", counted_value::num_constructed);
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Value type that is relocated with memcpy(), and counts the times it is
+ * copied or moved instead.
+ */
+struct relocatable_value {
+    static unsigned num_copies;
+    uint32_t value;
+
+    relocatable_value(uint32_t value = 0) : value(value) { }
+    relocatable_value(const relocatable_value &other) : value(other.value) { num_copies++; }
+};
+
+unsigned relocatable_value::num_copies = 0;
+
+namespace hash_containers {
+    template <>
+    struct is_trivially_relocatable<relocatable_value> {
+        static const bool value = true;
+    };
+}
+
+
+
+/* Test that growing and erasing relocate elements with memcpy() when
+ * possible
+ */
+int run_directed_test_8(bool debug = false) {
+
+    hash_containers::closed_linear_probing_hash_table<uint32_t, relocatable_value, std::hash<uint32_t>,
+                                                      hash_containers::erase_policy_rehash, 16> comp;
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        comp.try_emplace(i, i);
+    }
+    for (uint32_t i = 0; i < 1000; i += 3) {
+        comp.erase(i);
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        if (!comp.count(i) != !(i % 3) || ((i % 3) && comp[i].value != i)) {
+            if (debug) {
+                printf("In directed test 8:\nvalue of key %u is wrong\n", i);
+            }
+            return 1;
+        }
+    }
+
+    if (relocatable_value::num_copies) {
+        if (debug) {
+            printf("In directed test 8:\n%u values copied\n", relocatable_value::num_copies);
+        }
+        return 1;
+    }
+
+    // Strings are moved, not copied
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::string> comp1;
+    std::vector<const char *> data;
+    for (uint32_t i = 0; i < 1000; i++) {
+        comp1[i] = std::string(100, char('a' + i % 26));
+        data.push_back(comp1[i].data());
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        if (comp1[i].data() != data[i]) {
+            if (debug) {
+                printf("In directed test 8:\nstring %u was copied\n", i);
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+
+/* Value type counting the live objects */
+struct live_value {
+    static int num_live;
+
+    live_value() { num_live++; }
+    live_value(const live_value &) { num_live++; }
+    ~live_value() { num_live--; }
+};
+
+int live_value::num_live = 0;
+
+
+
+/* Test that clear() and the destructor destroy each element once, and only
+ * the elements, including with deleted markers around
+ */
+template <typename table_t>
+int run_destroy_test(unsigned seed, bool debug) {
+
+    {
+        table_t comp;
+        std::mt19937 rng(seed);
+
+        for (unsigned i = 0; i < 2000; i++) {
+            const uint32_t key = rng() & 1023;
+            if (rng() & 1) {
+                comp[key];
+            }
+            else {
+                comp.erase(key);
+            }
+        }
+        if (live_value::num_live != int(comp.size())) {
+            if (debug) {
+                printf("%d live values for %u elements\n", live_value::num_live, unsigned(comp.size()));
+            }
+            return 1;
+        }
+
+        comp.clear();
+        if (live_value::num_live) {
+            if (debug) {
+                printf("%d live values after clear()\n", live_value::num_live);
+            }
+            return 1;
+        }
+
+        for (uint32_t i = 0; i < 100; i++) {
+            comp[i];
+        }
+    }
+
+    if (live_value::num_live) {
+        if (debug) {
+            printf("%d live values after destruction\n", live_value::num_live);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test destruction of elements */
+int run_directed_test_9(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, live_value, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, live_value, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_use_marker, 64> table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, live_value, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u, ~0u - 1> > table2_t;
+
+    for (unsigned seed = 0; seed < 16; seed++) {
+        if (run_destroy_test<table0_t>(seed, debug)
+         || run_destroy_test<table1_t>(seed, debug)
+         || run_destroy_test<table2_t>(seed, debug)) {
+            if (debug) {
+                printf("In directed test 9:\nseed %u failed\n", seed);
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
+/* counting_allocator<>, assigned along with the containers using it */
+template <typename T>
+struct propagating_allocator : counting_allocator<T> {
+    typedef std::true_type propagate_on_container_copy_assignment;
+
+    propagating_allocator(size_t *bytes_in_use) : counting_allocator<T>(bytes_in_use) {}
+
+    template <typename U>
+    propagating_allocator(const propagating_allocator<U> &other) : counting_allocator<T>(other) {}
+};
+
+
+
+/* counting_allocator<>, exchanged along with the containers using it */
+template <typename T>
+struct swapping_allocator : counting_allocator<T> {
+    typedef std::true_type propagate_on_container_swap;
+
+    swapping_allocator(size_t *bytes_in_use) : counting_allocator<T>(bytes_in_use) {}
+
+    template <typename U>
+    swapping_allocator(const swapping_allocator<U> &other) : counting_allocator<T>(other) {}
+};
+
+
+
+/* counting_allocator<>, taken over by containers on move assignment. Like
+ * an allocator holding a std::shared_ptr to its resource, a moved-from
+ * instance can't allocate, and compares unequal to the others.
+ */
+template <typename T>
+struct moving_allocator : counting_allocator<T> {
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    moving_allocator(size_t *bytes_in_use) : counting_allocator<T>(bytes_in_use) {}
+
+    template <typename U>
+    moving_allocator(const moving_allocator<U> &other) : counting_allocator<T>(other) {}
+
+    moving_allocator(const moving_allocator &other) : counting_allocator<T>(other) {}
+
+    moving_allocator(moving_allocator &&other) : counting_allocator<T>(other) {
+        other.bytes_in_use = NULL;
+    }
+
+    moving_allocator &operator=(const moving_allocator &other) {
+        this->bytes_in_use = other.bytes_in_use;
+        return *this;
+    }
+
+    moving_allocator &operator=(moving_allocator &&other) {
+        this->bytes_in_use = other.bytes_in_use;
+        other.bytes_in_use = NULL;
+        return *this;
+    }
+};
+
+
+
+/* Checks that <copy> holds the same elements as <table>, in the same slots */
+template <typename table_t>
+bool is_same_table(const table_t &table, const table_t &copy) {
+    if (table.size() != copy.size() || table.capacity() != copy.capacity()) {
+        return false;
+    }
+    typename table_t::const_iterator it0 = table.cbegin(), it1 = copy.cbegin();
+    for (; it0 != table.cend() && it1 != copy.cend(); ++it0, ++it1) {
+        if ((*it0).first.get() != (*it1).first.get() || (*it0).second.get() != (*it1).second.get()) {
+            return false;
+        }
+    }
+    return it0 == table.cend() && it1 == copy.cend();
+}
+
+
+
+/* Returns a value of type <T> made from <i> */
+template <typename T>
+T make_value(uint32_t i) {
+    return T(i);
+}
+
+template <>
+std::string make_value<std::string>(uint32_t i) {
+    return std::to_string(i);
+}
+
+
+
+/* Test copies of tables of <num_elements> elements, with some erased */
+template <typename table_t, typename value_t>
+int run_copy_test(unsigned num_elements, bool debug) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        table_t table((typename table_t::allocator_type(&bytes_in_use)));
+        for (uint32_t i = 0; i < num_elements; i++) {
+            table[i] = make_value<value_t>(i);
+        }
+        for (uint32_t i = 0; i < num_elements; i += 4) {
+            table.erase(i);
+        }
+
+        table_t copy(table);
+        if (!is_same_table(table, copy)) {
+            if (debug) {
+                printf("copy of %u elements differs\n", num_elements);
+            }
+            return 1;
+        }
+
+        // The copy is independent
+        copy[num_elements] = make_value<value_t>(1);
+        copy.erase(1);
+        if (table.count(num_elements) || (num_elements > 1 && (!table.count(1) || table[1] != make_value<value_t>(1)))) {
+            if (debug) {
+                printf("copy of %u elements isn't independent\n", num_elements);
+            }
+            return 1;
+        }
+
+        // Assignment, to tables of smaller, equal and larger capacities
+        table_t small((typename table_t::allocator_type(&bytes_in_use)));
+        table_t large((typename table_t::allocator_type(&bytes_in_use)));
+        small[1000] = make_value<value_t>(1000);
+        for (uint32_t i = 0; i < num_elements * 4 + 100; i++) {
+            large[i] = make_value<value_t>(i);
+        }
+        small = table;
+        large = table;
+        copy  = table;
+        copy  = *&copy;
+        if (!is_same_table(table, small) || !is_same_table(table, copy) || large.size() != table.size()) {
+            if (debug) {
+                printf("assignment of %u elements differs\n", num_elements);
+            }
+            return 1;
+        }
+        for (typename table_t::const_iterator it = table.cbegin(); it != table.cend(); ++it) {
+            if (!large.count((*it).first.get()) || large[(*it).first.get()] != (*it).second.get()) {
+                if (debug) {
+                    printf("assignment of %u elements to a larger table differs\n", num_elements);
+                }
+                return 1;
+            }
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test copy construction and assignment */
+int run_directed_test_10(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 0,
+                                                              counting_allocator<char> > table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_use_marker, 16,
+                                                              counting_allocator<char> > table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint64_t, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u, ~0u - 1>, 8,
+                                                              counting_allocator<char> > table2_t;
+    typedef hash_containers::closed_linear_probing_hash_table<std::string, std::string, std::hash<std::string>,
+                                                              hash_containers::erase_policy_rehash, 32,
+                                                              counting_allocator<char> > table3_t;
+
+    const unsigned sizes[] = { 0, 1, 7, 100, 5000 };
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        if (run_copy_test<table0_t, uint32_t>(sizes[i], debug)
+         || run_copy_test<table1_t, std::string>(sizes[i], debug)
+         || run_copy_test<table2_t, uint64_t>(sizes[i], debug)) {
+            if (debug) {
+                printf("In directed test 10:\ncopy test failed\n");
+            }
+            return 1;
+        }
+    }
+
+    // String keys, which run_copy_test() can't build from integers
+    size_t bytes_in_use = 0;
+    {
+        table3_t table((table3_t::allocator_type(&bytes_in_use)));
+        for (unsigned i = 0; i < 100; i++) {
+            table[std::string(40, char('a' + i % 26)) + std::to_string(i)] = std::to_string(i);
+        }
+        table3_t copy(table);
+        table3_t copy2((table3_t::allocator_type(&bytes_in_use)));
+        copy2 = copy;
+        if (!is_same_table(table, copy) || !is_same_table(table, copy2)) {
+            if (debug) {
+                printf("In directed test 10:\nstring copy differs\n");
+            }
+            return 1;
+        }
+    }
+
+    // Allocators that propagate on assignment
+    size_t bytes_in_use2 = 0;
+    {
+        typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, std::hash<uint32_t>,
+                                                                  hash_containers::erase_policy_rehash, 0,
+                                                                  propagating_allocator<char> > table4_t;
+        table4_t table((table4_t::allocator_type(&bytes_in_use)));
+        table4_t other((table4_t::allocator_type(&bytes_in_use2)));
+        for (uint32_t i = 0; i < 100; i++) {
+            table[i]  = i;
+            other[i] = i + 1;
+        }
+        const size_t bytes_before = bytes_in_use;
+        other = table;
+        if (other.get_allocator() != table.get_allocator() || bytes_in_use2 || bytes_in_use != bytes_before * 2 || other[5] != 5) {
+            if (debug) {
+                printf("In directed test 10:\nallocator didn't propagate\n");
+            }
+            return 1;
+        }
+    }
+
+    if (bytes_in_use || bytes_in_use2) {
+        if (debug) {
+            printf("In directed test 10:\n%u bytes leaked\n", unsigned(bytes_in_use + bytes_in_use2));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Returns a table of <n> elements, built by run_move_test() */
+template <typename table_t>
+table_t make_table(uint32_t n, size_t *bytes_in_use) {
+    table_t table((typename table_t::allocator_type(bytes_in_use)));
+    for (uint32_t i = 0; i < n; i++) {
+        table[i] = std::to_string(i);
+    }
+    return table;
+}
+
+
+
+/* Checks that <table> holds the elements made by make_table(<n>) */
+template <typename table_t>
+bool has_elements(table_t &table, uint32_t n) {
+    if (table.size() != n) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (!table.count(i) || table[i] != std::to_string(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+/* Test moves and swaps of tables in the inline storage, and on the heap */
+template <typename table_t>
+int run_move_test(bool debug) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        const uint32_t sizes[] = { 0, 3, 100, 1000 };
+        const unsigned num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+        // Tables in a vector are moved when it grows
+        std::vector<table_t> tables;
+        for (unsigned i = 0; i < 4 * num_sizes; i++) {
+            tables.push_back(make_table<table_t>(sizes[i % num_sizes], &bytes_in_use));
+        }
+        for (unsigned i = 0; i < tables.size(); i++) {
+            if (!has_elements(tables[i], sizes[i % num_sizes])) {
+                if (debug) {
+                    printf("table %u was moved wrong\n", i);
+                }
+                return 1;
+            }
+        }
+
+        // Move assignment between all sizes, and swaps
+        for (unsigned i = 0; i < num_sizes; i++) {
+            for (unsigned j = 0; j < num_sizes; j++) {
+                table_t a(make_table<table_t>(sizes[i], &bytes_in_use));
+                table_t b(make_table<table_t>(sizes[j], &bytes_in_use));
+
+                swap(a, b);
+                if (!has_elements(a, sizes[j]) || !has_elements(b, sizes[i])) {
+                    if (debug) {
+                        printf("swap of %u and %u elements failed\n", sizes[i], sizes[j]);
+                    }
+                    return 1;
+                }
+
+                a = std::move(b);
+                if (!has_elements(a, sizes[i]) || b.size() || b.begin() != b.end()) {
+                    if (debug) {
+                        printf("move of %u elements over %u failed\n", sizes[i], sizes[j]);
+                    }
+                    return 1;
+                }
+
+                // Moved-from tables can be reused
+                b[5] = "5";
+                a = std::move(a);
+                if (b.size() != 1 || !has_elements(a, sizes[i])) {
+                    if (debug) {
+                        printf("reuse after move failed\n");
+                    }
+                    return 1;
+                }
+            }
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Hash functor without a default constructor */
+struct salted_hash {
+    uint32_t salt;
+
+    explicit salted_hash(uint32_t salt) : salt(salt) { }
+
+    size_t operator()(uint32_t key) const {
+        return key ^ this->salt;
+    }
+};
+
+
+
+/* Test swaps and move assignments of tables whose functors can't be
+ * default constructed
+ */
+template <typename table_t>
+int run_salted_swap_test(bool debug) {
+
+    const uint32_t sizes[] = { 0, 3, 100 };
+    const unsigned num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    for (unsigned i = 0; i < num_sizes; i++) {
+        for (unsigned j = 0; j < num_sizes; j++) {
+            table_t a((salted_hash(1)));
+            table_t b((salted_hash(2)));
+            for (uint32_t n = 0; n < sizes[i]; n++) {
+                a[n] = std::to_string(n);
+            }
+            for (uint32_t n = 0; n < sizes[j]; n++) {
+                b[n] = std::to_string(n);
+            }
+
+            a.swap(b);
+            if (!has_elements(a, sizes[j]) || !has_elements(b, sizes[i])
+             || a.hash_function().salt != 2 || b.hash_function().salt != 1) {
+                if (debug) {
+                    printf("swap of %u and %u elements failed\n", sizes[i], sizes[j]);
+                }
+                return 1;
+            }
+
+            a = std::move(b);
+            if (!has_elements(a, sizes[i]) || b.size() || a.hash_function().salt != 1) {
+                if (debug) {
+                    printf("move of %u elements over %u failed\n", sizes[i], sizes[j]);
+                }
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+
+/* Test move construction, move assignment and swap */
+int run_directed_test_11(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 0,
+                                                              counting_allocator<char> > table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_use_marker, 16,
+                                                              counting_allocator<char> > table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_empty_key<uint32_t>, 8,
+                                                              propagating_allocator<char> > table2_t;
+
+    if (run_move_test<table0_t>(debug) || run_move_test<table1_t>(debug) || run_move_test<table2_t>(debug)) {
+        if (debug) {
+            printf("In directed test 11:\nmove test failed\n");
+        }
+        return 1;
+    }
+
+    // Heap tables are taken over, not copied
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::string> table;
+    for (uint32_t i = 0; i < 100; i++) {
+        table[i] = std::string(100, 'x');
+    }
+    const std::string *value = &table[7];
+    hash_containers::closed_linear_probing_hash_table<uint32_t, std::string> moved(std::move(table));
+    if (&moved[7] != value || table.size()
+     || table.capacity() != hash_containers::closed_linear_probing_hash_table<uint32_t, std::string>().capacity()) {
+        if (debug) {
+            printf("In directed test 11:\nheap table wasn't taken over\n");
+        }
+        return 1;
+    }
+
+    // Allocators that differ, and don't propagate: elements are moved to
+    // memory from the target's allocator
+    size_t bytes0 = 0;
+    size_t bytes1 = 0;
+    {
+        table0_t a((table0_t::allocator_type(&bytes0)));
+        table0_t b(make_table<table0_t>(100, &bytes1));
+        a = std::move(b);
+        if (!has_elements(a, 100) || bytes1 || !bytes0) {
+            if (debug) {
+                printf("In directed test 11:\nelements weren't moved between allocators\n");
+            }
+            return 1;
+        }
+    }
+    if (bytes0 || bytes1) {
+        if (debug) {
+            printf("In directed test 11:\nmemory leaked\n");
+        }
+        return 1;
+    }
+
+    // Allocators that propagate on swap are exchanged with the tables
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 16,
+                                                              swapping_allocator<char> > table3_t;
+    {
+        table3_t a(make_table<table3_t>(3, &bytes0));
+        table3_t b(make_table<table3_t>(100, &bytes1));
+        swap(a, b);
+        if (!has_elements(a, 100) || !has_elements(b, 3) || !bytes1 || bytes0
+         || a.get_allocator() != table3_t::allocator_type(&bytes1)) {
+            if (debug) {
+                printf("In directed test 11:\nallocators weren't swapped\n");
+            }
+            return 1;
+        }
+    }
+    if (bytes0 || bytes1) {
+        if (debug) {
+            printf("In directed test 11:\nmemory leaked after swap\n");
+        }
+        return 1;
+    }
+
+    // Allocators that propagate on move assignment hand over the heap
+    // table with them, even when the moved-from allocator compares unequal
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 16,
+                                                              moving_allocator<char> > table8_t;
+    {
+        table8_t a(make_table<table8_t>(3, &bytes0));
+        table8_t b(make_table<table8_t>(100, &bytes1));
+        const size_t bytes_in_b = bytes1;
+        a = std::move(b);
+        if (!has_elements(a, 100) || b.size() || bytes1 != bytes_in_b || bytes0
+         || a.get_allocator() != table8_t::allocator_type(&bytes1)) {
+            if (debug) {
+                printf("In directed test 11:\nheap table wasn't taken over with the allocator\n");
+            }
+            return 1;
+        }
+    }
+    if (bytes0 || bytes1) {
+        if (debug) {
+            printf("In directed test 11:\nmemory leaked after move assignment\n");
+        }
+        return 1;
+    }
+
+    // Functors that can't be default constructed
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, salted_hash> table4_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, salted_hash,
+                                                              hash_containers::erase_policy_use_marker, 0> table5_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, salted_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u, ~0u - 1>, 8> table6_t;
+    if (run_salted_swap_test<table4_t>(debug) || run_salted_swap_test<table5_t>(debug) || run_salted_swap_test<table6_t>(debug)) {
+        if (debug) {
+            printf("In directed test 11:\nswap test failed\n");
+        }
+        return 1;
+    }
+
+    // Move assignment can throw when the heap table may have to be copied
+    // to another allocator's memory, or inline elements may throw on move
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t> table7_t;
+    if (!std::is_nothrow_move_assignable<table7_t>::value || !std::is_nothrow_move_assignable<table4_t>::value
+     || std::is_nothrow_move_assignable<table0_t>::value) {
+        if (debug) {
+            printf("In directed test 11:\nmove assignment has the wrong noexcept\n");
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Hash functor returning the key, to control collisions */
+struct identity_hash {
+    size_t operator()(uint32_t key) const {
+        return key;
+    }
+};
+
+
+
+/* Checks the keys of <table>, in slot order */
+template <typename table_t>
+bool has_keys_in_order(table_t &table, const uint32_t *keys, unsigned num_keys) {
+    unsigned i = 0;
+    for (typename table_t::const_iterator it = table.cbegin(); it != table.cend(); ++it, ++i) {
+        if (i >= num_keys || (*it).first.get() != keys[i]) {
+            return false;
+        }
+    }
+    return i == num_keys;
+}
+
+
+
+/* Test that upserts find keys past deleted slots, and reuse the first
+ * deleted slot of the probe sequence for new keys
+ */
+template <typename table_t>
+int run_upsert_test(bool debug) {
+
+    table_t table;
+    table[0]  = 0;
+    table[16] = 16;
+    table[32] = 32;
+    table.erase(16);
+
+    // Key past the deleted slot: found, not added again
+    table[32] = 33;
+    table.insert(32, 34);
+    const uint32_t keys0[] = { 0, 32 };
+    if (table.size() != 2 || table[32] != 33 || !has_keys_in_order(table, keys0, 2)) {
+        if (debug) {
+            printf("key past a deleted slot wasn't found\n");
+        }
+        return 1;
+    }
+
+    // New key: goes into the deleted slot
+    table[48] = 48;
+    const uint32_t keys1[] = { 0, 48, 32 };
+    if (table.size() != 3 || !has_keys_in_order(table, keys1, 3)) {
+        if (debug) {
+            printf("deleted slot wasn't reused\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test single probe insertion */
+int run_directed_test_12(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_use_marker, 16> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u, ~0u - 1>, 16> table1_t;
+
+    if (run_upsert_test<table0_t>(debug) || run_upsert_test<table1_t>(debug)) {
+        if (debug) {
+            printf("In directed test 12:\nupsert test failed\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Checks that <table> holds exactly the elements of <gold> */
+template <typename table_t>
+bool has_same_elements(table_t &table, const std::unordered_map<uint32_t, uint32_t> &gold) {
+    if (table.size() != gold.size()) {
+        return false;
+    }
+    for (std::unordered_map<uint32_t, uint32_t>::const_iterator it = gold.begin(); it != gold.end(); ++it) {
+        if (!table.count(it->first) || table[it->first] != it->second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+struct is_odd_value {
+    bool operator()(const std::pair<hash_containers::reference_wrapper<const uint32_t>, hash_containers::reference_wrapper<uint32_t> > &element) const {
+        return element.second.get() & 1;
+    }
+};
+
+
+
+/* Test erase(iterator) and erase_if(), with keys that collide and wrap
+ * around the end of the table
+ */
+template <typename table_t>
+int run_erase_if_test(bool debug) {
+
+    std::mt19937 rng(13);
+
+    for (unsigned round = 0; round < 64; round++) {
+        table_t table_it, table_if;
+        std::unordered_map<uint32_t, uint32_t> gold;
+
+        const unsigned num_elements = round * 2;
+        for (unsigned i = 0; i < num_elements; i++) {
+            // Keys cluster around a multiple of the capacity: at the end of
+            // the table, wrapping to its start
+            const uint32_t key   = 0x3e0 + static_cast<uint32_t>(rng()) % 64;
+            const uint32_t value = static_cast<uint32_t>(rng());
+            gold[key]     = value;
+            table_it[key] = value;
+            table_if[key] = value;
+        }
+
+        size_t num_erased = 0;
+        for (std::unordered_map<uint32_t, uint32_t>::iterator it = gold.begin(); it != gold.end(); ) {
+            if (it->second & 1) {
+                it = gold.erase(it);
+                num_erased++;
+            }
+            else {
+                ++it;
+            }
+        }
+
+        for (typename table_t::iterator it = table_it.begin(); it != table_it.end(); ) {
+            if (is_odd_value()(*it)) {
+                it = table_it.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        if (!has_same_elements(table_it, gold)) {
+            if (debug) {
+                printf("erase(iterator) mismatch in round %u\n", round);
+            }
+            return 1;
+        }
+
+        if (erase_if(table_if, is_odd_value()) != num_erased || !has_same_elements(table_if, gold)) {
+            if (debug) {
+                printf("erase_if() mismatch in round %u\n", round);
+            }
+            return 1;
+        }
+
+        // Nothing left to erase
+        if (table_if.erase_if(is_odd_value()) != 0 || !has_same_elements(table_if, gold)) {
+            if (debug) {
+                printf("second erase_if() erased elements in round %u\n", round);
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
+/* Erases the keys selected by <erased>, and counts the calls per key */
+struct erase_selected_keys {
+    const std::unordered_map<uint32_t, uint32_t> *erased;
+    std::unordered_map<uint32_t, unsigned> *num_calls;
+
+    bool operator()(const std::pair<hash_containers::reference_wrapper<const uint32_t>, hash_containers::reference_wrapper<uint32_t> > &element) const {
+        const uint32_t key = element.first.get();
+        (*this->num_calls)[key]++;
+        return this->erased->count(key) != 0;
+    }
+};
+
+
+
+/* Test erase_if() on a table filled with <keys>, in that order, up to its
+ * capacity: the probe sequences wrap around every slot. Every subset of the
+ * first <num_erasable> keys is erased in turn, and the predicate must be
+ * called once per element.
+ */
+template <typename table_t>
+int run_full_erase_if_test(const uint32_t *keys, unsigned num_keys, unsigned num_erasable, bool debug) {
+
+    for (unsigned mask = 0; mask < (1u << num_erasable); mask++) {
+        table_t table;
+        std::unordered_map<uint32_t, uint32_t> gold, erased;
+        std::unordered_map<uint32_t, unsigned> num_calls;
+
+        for (unsigned i = 0; i < num_keys; i++) {
+            table[keys[i]] = keys[i] * 10;
+            if ((mask >> i) & 1) {
+                erased[keys[i]] = 0;
+            }
+            else {
+                gold[keys[i]] = keys[i] * 10;
+            }
+        }
+        if (table.capacity() != num_keys) {
+            if (debug) {
+                printf("The table is not full, capacity %u\n", unsigned(table.capacity()));
+            }
+            return 1;
+        }
+
+        erase_selected_keys pred = { &erased, &num_calls };
+        if (table.erase_if(pred) != erased.size() || !has_same_elements(table, gold)) {
+            if (debug) {
+                printf("erase_if() mismatch with mask 0x%x\n", mask);
+            }
+            return 1;
+        }
+        for (unsigned i = 0; i < num_keys; i++) {
+            if (num_calls[keys[i]] != 1) {
+                if (debug) {
+                    printf("The predicate was called %u times on %u with mask 0x%x\n",
+                           num_calls[keys[i]], keys[i], mask);
+                }
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+
+/* Test erase(iterator) and erase_if() */
+int run_directed_test_13(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_use_marker> table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u>, 16> table2_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u, ~0u - 1>, 0> table3_t;
+
+    if (run_erase_if_test<table0_t>(debug) || run_erase_if_test<table1_t>(debug)
+     || run_erase_if_test<table2_t>(debug) || run_erase_if_test<table3_t>(debug)) {
+        if (debug) {
+            printf("In directed test 13:\nerase test failed\n");
+        }
+        return 1;
+    }
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_rehash, 8> table4_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_use_marker, 8> table5_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u>, 8> table6_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_rehash, 16> table7_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u>, 16> table8_t;
+
+    // 15 and 7 share their home slot, 7 wraps around to slot 0
+    static const uint32_t keys8[8] = { 15, 7, 1, 2, 3, 4, 5, 6 };
+
+    // Erasing 13 and 46 moves 62 from slot 2 to slot 1, then 29 from slot 14
+    // to slot 13, which leaves a hole in the probe sequence of 62
+    static const uint32_t keys16[16] = { 13, 29, 15, 31, 46, 62, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+
+    if (run_full_erase_if_test<table4_t>(keys8, 8, 8, debug) || run_full_erase_if_test<table5_t>(keys8, 8, 8, debug)
+     || run_full_erase_if_test<table6_t>(keys8, 8, 8, debug)
+     || run_full_erase_if_test<table7_t>(keys16, 16, 6, debug) || run_full_erase_if_test<table8_t>(keys16, 16, 6, debug)) {
+        if (debug) {
+            printf("In directed test 13:\nerase_if() on a full table failed\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* String key counting its constructions, compared to C strings as is */
+struct tracked_key {
+    static unsigned num_constructed;
+    std::string str;
+
+    explicit tracked_key(const char *str) : str(str)                  { num_constructed++; }
+    tracked_key(const tracked_key &other) : str(other.str)            { num_constructed++; }
+    tracked_key(tracked_key &&other)      : str(std::move(other.str)) { num_constructed++; }
+
+    bool operator==(const tracked_key &other) const { return this->str == other.str; }
+    bool operator!=(const tracked_key &other) const { return this->str != other.str; }
+    bool operator==(const char *other)        const { return this->str == other; }
+    bool operator!=(const char *other)        const { return this->str != other; }
+};
+
+unsigned tracked_key::num_constructed = 0;
+
+
+
+struct tracked_key_hash {
+    typedef void is_transparent;
+
+    size_t operator()(const tracked_key &key) const {
+        return size_t(hash_containers::internal::hash_bytes(key.str.data(), key.str.size()));
+    }
+    size_t operator()(const char *key) const {
+        return size_t(hash_containers::internal::hash_bytes(key, strlen(key)));
+    }
+};
+
+
+
+/* Test that transparent lookups don't construct keys, and that insertions
+ * construct them once
+ */
+template <typename table_t>
+int run_transparent_test(bool debug) {
+
+    static const char *const names[] = { "zero", "one", "two", "three", "four", "five", "six", "seven" };
+
+    table_t table;
+    table.reserve(64);
+
+    tracked_key::num_constructed = 0;
+    for (unsigned i = 0; i < 8; i++) {
+        table[names[i]] = i;
+    }
+    if (tracked_key::num_constructed != 8 || table.size() != 8) {
+        if (debug) {
+            printf("insertions constructed %u keys\n", tracked_key::num_constructed);
+        }
+        return 1;
+    }
+
+    tracked_key::num_constructed = 0;
+    const table_t &const_table = table;
+    for (unsigned i = 0; i < 8; i++) {
+        if (table.count(names[i]) != 1 || (*table.find(names[i])).second.get() != i
+         || (*const_table.find(names[i])).second.get() != i || table[names[i]] != i
+         || table.try_emplace(names[i], 100u).second || table.insert(names[i], 100u)) {
+            if (debug) {
+                printf("lookup of \"%s\" failed\n", names[i]);
+            }
+            return 1;
+        }
+    }
+    if (table.count("eight") || table.find("eight") != table.end()) {
+        if (debug) {
+            printf("missing key was found\n");
+        }
+        return 1;
+    }
+
+    table.erase("three");
+    table.erase("eight");
+    if (tracked_key::num_constructed || table.size() != 7 || table.count("three")) {
+        if (debug) {
+            printf("lookups constructed %u keys\n", tracked_key::num_constructed);
+        }
+        return 1;
+    }
+
+    if (!table.try_emplace("eight", 8u).second || !table.insert("nine", 9u)
+     || tracked_key::num_constructed != 2 || table["eight"] != 8 || table["nine"] != 9) {
+        if (debug) {
+            printf("transparent insertions failed\n");
+        }
+        return 1;
+    }
+
+    // K keys still go through the non-transparent overloads
+    const tracked_key five("five");
+    if (table.count(five) != 1 || table[five] != 5) {
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test transparent lookups */
+int run_directed_test_14(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<tracked_key, uint32_t, tracked_key_hash> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<tracked_key, uint32_t, tracked_key_hash,
+                                                              hash_containers::erase_policy_use_marker, 0> table1_t;
+
+    if (run_transparent_test<table0_t>(debug) || run_transparent_test<table1_t>(debug)) {
+        if (debug) {
+            printf("In directed test 14:\ntransparent lookup test failed\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Comparison of shared_ptr<std::string> keys by pointee, to go with
+ * shared_ptr_string_hash
+ */
+struct shared_ptr_string_equal {
+    bool operator()(const std::shared_ptr<std::string> &a, const std::shared_ptr<std::string> &b) const {
+        return *a == *b;
+    }
+};
+
+
+
+/* Test the key comparison functor */
+template <typename table_t>
+int run_key_equal_test(bool debug) {
+
+    table_t table;
+    for (unsigned i = 0; i < 100; i++) {
+        table[std::make_shared<std::string>(std::to_string(i))] = i;
+    }
+
+    // Other pointers to equal strings find the same elements
+    for (unsigned i = 0; i < 100; i++) {
+        const std::shared_ptr<std::string> key = std::make_shared<std::string>(std::to_string(i));
+        if (!table.count(key) || table[key] != i || table.size() != 100) {
+            if (debug) {
+                printf("key \"%u\" wasn't found by pointee\n", i);
+            }
+            return 1;
+        }
+    }
+
+    for (unsigned i = 0; i < 100; i += 2) {
+        table.erase(std::make_shared<std::string>(std::to_string(i)));
+    }
+    if (table.size() != 50 || table.count(std::make_shared<std::string>("0")) || !table.count(std::make_shared<std::string>("1"))) {
+        if (debug) {
+            printf("erase() by pointee failed\n");
+        }
+        return 1;
+    }
+
+    table_t copy(table);
+    table_t moved(std::move(copy));
+    if (!moved.count(std::make_shared<std::string>("99")) || moved.size() != 50) {
+        if (debug) {
+            printf("copies don't compare by pointee\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test key_equal, and that empty comparison functors take no space */
+int run_directed_test_15(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<std::shared_ptr<std::string>, uint32_t, shared_ptr_string_hash,
+                                                              hash_containers::erase_policy_rehash, 32, hash_containers::table_allocator<char>,
+                                                              hash_containers::shrink_policy_never, shared_ptr_string_equal> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<std::shared_ptr<std::string>, uint32_t, shared_ptr_string_hash,
+                                                              hash_containers::erase_policy_use_marker, 0, hash_containers::table_allocator<char>,
+                                                              hash_containers::shrink_policy_hysteresis<>, shared_ptr_string_equal> table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<std::shared_ptr<std::string>, uint32_t, shared_ptr_string_hash,
+                                                              hash_containers::erase_policy_use_marker, 0> table2_t;
+
+    if (run_key_equal_test<table0_t>(debug) || run_key_equal_test<table1_t>(debug)) {
+        if (debug) {
+            printf("In directed test 15:\nkey_equal test failed\n");
+        }
+        return 1;
+    }
+
+    if (sizeof(table1_t) != sizeof(table2_t)) {
+        if (debug) {
+            printf("In directed test 15:\nempty key_equal takes %u bytes\n", unsigned(sizeof(table1_t) - sizeof(table2_t)));
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Hash functor with state: default-constructed instances hash differently
+ * from the ones the tables are constructed with
+ */
+struct offset_hash {
+    static unsigned num_copies;
+    uint32_t offset;
+
+    offset_hash() : offset(0) { }
+    explicit offset_hash(uint32_t offset) : offset(offset) { }
+    offset_hash(const offset_hash &other) : offset(other.offset) { num_copies++; }
+    offset_hash &operator=(const offset_hash &other) { this->offset = other.offset; return *this; }
+
+    size_t operator()(uint32_t key) const {
+        return key + this->offset;
+    }
+};
+
+unsigned offset_hash::num_copies = 0;
+
+
+
+/* Stateful hash functor whose operator() isn't const */
+struct mutable_offset_hash {
+    uint32_t offset;
+
+    mutable_offset_hash() : offset(0) { }
+    explicit mutable_offset_hash(uint32_t offset) : offset(offset) { }
+
+    size_t operator()(uint32_t key) {
+        return key + this->offset;
+    }
+};
+
+
+
+/* Test that tables hash with their own functor instance, including on
+ * erase(), and hand it over on copy, move and swap
+ */
+template <typename table_t>
+int run_stateful_hash_test(bool debug) {
+
+    std::mt19937 rng(16);
+    std::unordered_map<uint32_t, uint32_t> gold;
+    table_t table((offset_hash(61)));
+
+    for (unsigned i = 0; i < 4096; i++) {
+        // Keys cluster, so that erase() shifts elements
+        const uint32_t key = static_cast<uint32_t>(rng()) % 256;
+        if (rng() & 1) {
+            gold[key]  = i;
+            table[key] = i;
+        }
+        else {
+            gold.erase(key);
+            table.erase(key);
+        }
+    }
+    if (!has_same_elements(table, gold) || table.hash_function().offset != 61) {
+        if (debug) {
+            printf("lookups failed with a stateful hash functor\n");
+        }
+        return 1;
+    }
+
+    // Const lookups use the table's functor, without copying it
+    const table_t &const_table = table;
+    const unsigned num_copies = offset_hash::num_copies;
+    for (unsigned key = 0; key < 256; key++) {
+        if (const_table.count(key) != gold.count(key)
+         || (gold.count(key) && (*const_table.find(key)).second.get() != gold[key])) {
+            if (debug) {
+                printf("const lookups failed with a stateful hash functor\n");
+            }
+            return 1;
+        }
+    }
+    if (offset_hash::num_copies != num_copies) {
+        if (debug) {
+            printf("const lookups copied the hash functor %u times\n", offset_hash::num_copies - num_copies);
+        }
+        return 1;
+    }
+
+    table_t copy(table);
+    table_t other((offset_hash(7)));
+    other[1] = 1;
+    other.swap(copy);
+    if (!has_same_elements(other, gold) || other.hash_function().offset != 61
+     || copy.size() != 1 || !copy.count(1) || copy.hash_function().offset != 7) {
+        if (debug) {
+            printf("copy or swap didn't keep the hash functor\n");
+        }
+        return 1;
+    }
+
+    table_t moved(std::move(other));
+    copy = std::move(moved);
+    if (!has_same_elements(copy, gold) || copy.hash_function().offset != 61) {
+        if (debug) {
+            printf("move didn't keep the hash functor\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test stateful hash functors, and seeded_hash */
+int run_directed_test_16(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, offset_hash> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, offset_hash,
+                                                              hash_containers::erase_policy_use_marker, 0> table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, offset_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u>, 16> table2_t;
+
+    if (run_stateful_hash_test<table0_t>(debug) || run_stateful_hash_test<table1_t>(debug)
+     || run_stateful_hash_test<table2_t>(debug)) {
+        if (debug) {
+            printf("In directed test 16:\nstateful hash test failed\n");
+        }
+        return 1;
+    }
+
+    // Tables get their own seeds, and copies keep them
+    typedef hash_containers::seeded_hash<uint32_t, identity_hash> seeded_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, seeded_t> table3_t;
+
+    table3_t table0, table1;
+    table3_t table2((seeded_t(12345)));
+    for (uint32_t i = 0; i < 1000; i++) {
+        table0[i << 16] = i;
+        table2[i << 16] = i;
+    }
+    table3_t copy(table0);
+    if (table0.hash_function().get_seed() == table1.hash_function().get_seed()
+     || copy.hash_function().get_seed() != table0.hash_function().get_seed()
+     || table2.hash_function().get_seed() != 12345
+     || seeded_t(1)(5) == seeded_t(2)(5) || seeded_t(1)(5) != seeded_t(1)(5)) {
+        if (debug) {
+            printf("In directed test 16:\nseeds weren't set or copied\n");
+        }
+        return 1;
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        if (copy[i << 16] != i || table2[i << 16] != i) {
+            if (debug) {
+                printf("In directed test 16:\nlookup failed with seeded_hash\n");
+            }
+            return 1;
+        }
+    }
+
+    // Const lookups also work with functors whose operator() isn't const
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, mutable_offset_hash> table5_t;
+    typedef hash_containers::seeded_hash<uint32_t, mutable_offset_hash> seeded_mutable_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, seeded_mutable_t> table6_t;
+
+    table5_t table5((mutable_offset_hash(61)));
+    table6_t table6((seeded_mutable_t(1, mutable_offset_hash(61))));
+    for (uint32_t i = 0; i < 1000; i++) {
+        table5[i << 16] = i;
+        table6[i << 16] = i;
+    }
+    const table5_t &const_table5 = table5;
+    const table6_t &const_table6 = table6;
+    for (uint32_t i = 0; i < 1000; i++) {
+        if (const_table5.count(i << 16) != 1 || (*const_table5.find(i << 16)).second.get() != i
+         || const_table6.count(i << 16) != 1 || (*const_table6.find(i << 16)).second.get() != i) {
+            if (debug) {
+                printf("In directed test 16:\nconst lookup failed with a non-const hash functor\n");
+            }
+            return 1;
+        }
+    }
+
+    // Strings hash their bytes with the seed, rather than mixing the seed
+    // into std::hash<>, whose collisions would survive every seed
+    typedef hash_containers::seeded_hash<std::string> seeded_string_t;
+    typedef hash_containers::closed_linear_probing_hash_table<std::string, uint32_t, seeded_string_t> table4_t;
+
+    const std::string str("seeded");
+    if (seeded_string_t(1)(str) != size_t(hash_containers::internal::hash_bytes(str.data(), str.size(), 1))
+     || seeded_string_t(1)(str) == seeded_string_t(2)(str)) {
+        if (debug) {
+            printf("In directed test 16:\nseeded_hash<std::string> doesn't seed the string hash\n");
+        }
+        return 1;
+    }
+
+    table4_t table4;
+    for (uint32_t i = 0; i < 1000; i++) {
+        table4[std::to_string(i)] = i;
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        if (table4.size() != 1000 || table4[std::to_string(i)] != i) {
+            if (debug) {
+                printf("In directed test 16:\nlookup failed with seeded_hash<std::string>\n");
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
+/* Value whose constructors throw on request, counting live instances */
+struct throwing_value {
+    static int  num_live;
+    static bool throw_on_default;
+    static bool throw_on_copy;
+    static int  num_copies_left;  // Copies before one throws, if >= 0
+    int value;
+
+    throwing_value() : value(0) {
+        if (throw_on_default) {
+            throw 0;
+        }
+        num_live++;
+    }
+    throwing_value(int value) : value(value) {
+        if (value == -1) {
+            throw 1;
+        }
+        num_live++;
+    }
+    throwing_value(const throwing_value &other) : value(other.value) {
+        if (throw_on_copy || num_copies_left == 0) {
+            throw 2;
+        }
+        if (num_copies_left > 0) {
+            num_copies_left--;
+        }
+        num_live++;
+    }
+    ~throwing_value() {
+        num_live--;
+    }
+};
+
+int  throwing_value::num_live         = 0;
+bool throwing_value::throw_on_default = false;
+bool throwing_value::throw_on_copy    = false;
+int  throwing_value::num_copies_left  = -1;
+
+
+
+/* Checks that a throwing insertion left the table as it was */
+template <typename table_t>
+bool has_values_up_to(table_t &table, uint32_t num_elements) {
+    if (table.size() != num_elements || throwing_value::num_live != int(num_elements)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < num_elements; i++) {
+        if (!table.count(i * 16) || table.find(i * 16) == table.end() || (*table.find(i * 16)).second.get().value != int(i)) {
+            return false;
+        }
+    }
+    return !table.count(1000 * 16);
+}
+
+
+
+/* Test that insertions whose value constructor throws leave no element */
+template <typename table_t>
+int run_throwing_test(bool debug) {
+
+    throwing_value::num_live = 0;
+    {
+        table_t table;
+        for (uint32_t n = 0; n < 40; n++) {
+            // Keys all collide, in a single cluster
+            const uint32_t key = 1000 * 16;
+
+            bool thrown = false;
+            try { table.try_emplace(key, -1); } catch (int) { thrown = true; }
+            if (!thrown || !has_values_up_to(table, n)) {
+                if (debug) {
+                    printf("try_emplace() left an element after %u elements\n", n);
+                }
+                return 1;
+            }
+            thrown = false;
+            {
+                const throwing_value value(static_cast<int>(n));
+                throwing_value::throw_on_copy = true;
+                try { table.insert(key, value); } catch (int) { thrown = true; }
+                throwing_value::throw_on_copy = false;
+            }
+            if (!thrown || !has_values_up_to(table, n)) {
+                if (debug) {
+                    printf("insert() left an element after %u elements\n", n);
+                }
+                return 1;
+            }
+            thrown = false;
+            throwing_value::throw_on_default = true;
+            try { table[key]; } catch (int) { thrown = true; }
+            throwing_value::throw_on_default = false;
+            if (!thrown || !has_values_up_to(table, n)) {
+                if (debug) {
+                    printf("operator[] left an element after %u elements\n", n);
+                }
+                return 1;
+            }
+
+            table.try_emplace(n * 16, int(n));
+        }
+        table.erase(0);
+        table.erase(16);
+        if (table.size() != 38 || throwing_value::num_live != 38) {
+            return 1;
+        }
+    }
+    if (throwing_value::num_live) {
+        if (debug) {
+            printf("%d values weren't destroyed\n", throwing_value::num_live);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test that copies throwing half-way destroy the elements copied so far,
+ * and leave the target of an assignment empty and usable
+ */
+template <typename table_t>
+int run_throwing_copy_test(bool debug) {
+
+    throwing_value::num_live = 0;
+    {
+        const uint32_t sizes[] = { 4, 100 };
+        for (unsigned n = 0; n < sizeof(sizes) / sizeof(sizes[0]); n++) {
+            const uint32_t num_elements = sizes[n];
+            table_t table;
+            for (uint32_t i = 0; i < num_elements; i++) {
+                table.try_emplace(i, int(i));
+            }
+
+            bool thrown = false;
+            throwing_value::num_copies_left = int(num_elements / 2);
+            try { table_t copy(table); } catch (int) { thrown = true; }
+            throwing_value::num_copies_left = -1;
+            if (!thrown || throwing_value::num_live != int(num_elements)) {
+                if (debug) {
+                    printf("copy constructor left %d values, for %u elements\n", throwing_value::num_live, num_elements);
+                }
+                return 1;
+            }
+
+            table_t target;
+            target.try_emplace(1000, 1000);
+            thrown = false;
+            throwing_value::num_copies_left = int(num_elements / 2);
+            try { target = table; } catch (int) { thrown = true; }
+            throwing_value::num_copies_left = -1;
+            if (!thrown || target.size() || target.begin() != target.end() || throwing_value::num_live != int(num_elements)) {
+                if (debug) {
+                    printf("copy assignment left %d values, for %u elements\n", throwing_value::num_live, num_elements);
+                }
+                return 1;
+            }
+
+            target = table;
+            bool ok = target.size() == num_elements && throwing_value::num_live == int(2 * num_elements);
+            for (uint32_t i = 0; i < num_elements && ok; i++) {
+                ok = target.find(i) != target.end() && (*target.find(i)).second.get().value == int(i);
+            }
+            if (!ok) {
+                if (debug) {
+                    printf("copy assignment failed after a throwing one\n");
+                }
+                return 1;
+            }
+        }
+    }
+    if (throwing_value::num_live) {
+        if (debug) {
+            printf("%d values weren't destroyed\n", throwing_value::num_live);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test insertions and copies with throwing constructors */
+int run_directed_test_17(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, throwing_value, identity_hash> table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, throwing_value, identity_hash,
+                                                              hash_containers::erase_policy_use_marker, 0> table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, throwing_value, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u>, 16> table2_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, throwing_value, identity_hash,
+                                                              hash_containers::erase_policy_empty_key<uint32_t, ~0u, ~0u - 1>, 16> table3_t;
+
+    if (run_throwing_test<table0_t>(debug) || run_throwing_test<table1_t>(debug)
+     || run_throwing_test<table2_t>(debug) || run_throwing_test<table3_t>(debug)) {
+        if (debug) {
+            printf("In directed test 17:\nthrowing constructor test failed\n");
+        }
+        return 1;
+    }
+
+    if (run_throwing_copy_test<table0_t>(debug) || run_throwing_copy_test<table1_t>(debug)
+     || run_throwing_copy_test<table2_t>(debug) || run_throwing_copy_test<table3_t>(debug)) {
+        if (debug) {
+            printf("In directed test 17:\nthrowing copy test failed\n");
+        }
+        return 1;
+    }
+
+    // Moving relocates the inline elements, which may throw, unless there
+    // is no inline storage
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, uint32_t, identity_hash> table4_t;
+    if (std::is_nothrow_move_constructible<table0_t>::value || !std::is_nothrow_move_constructible<table1_t>::value
+     || std::is_nothrow_move_constructible<table2_t>::value || !std::is_nothrow_move_constructible<table4_t>::value) {
+        if (debug) {
+            printf("In directed test 17:\nthe move constructor has the wrong noexcept\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+int main() {
+    
+#if (defined _DEBUG) && (defined _MSC_VER)
+    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
+    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
+#endif
+
+    /* Directed tests */
+
+    int ret;
+    ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_1();
+    if (ret) {
+        run_directed_test_1(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_2();
+    if (ret) {
+        run_directed_test_2(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_3();
+    if (ret) {
+        run_directed_test_3(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_4();
+    if (ret) {
+        run_directed_test_4(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_5();
+    if (ret) {
+        run_directed_test_5(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_6();
+    if (ret) {
+        run_directed_test_6(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_7();
+    if (ret) {
+        run_directed_test_7(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_8();
+    if (ret) {
+        run_directed_test_8(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_9();
+    if (ret) {
+        run_directed_test_9(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_10();
+    if (ret) {
+        run_directed_test_10(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_11();
+    if (ret) {
+        run_directed_test_11(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_12();
+    if (ret) {
+        run_directed_test_12(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_13();
+    if (ret) {
+        run_directed_test_13(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_14();
+    if (ret) {
+        run_directed_test_14(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_15();
+    if (ret) {
+        run_directed_test_15(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_16();
+    if (ret) {
+        run_directed_test_16(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_17();
+    if (ret) {
+        run_directed_test_17(/*debug*/true);
         return ret;
     }
   
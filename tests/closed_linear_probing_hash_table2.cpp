@@ -25,13 +25,27 @@
 #include <sstream>
 #include <string>
 
+
+/* The reuse_inline_storage target runs the same tests with the meta-data of
+ * heap tables kept in the inline storage.
+ */
+#ifdef TEST_REUSE_INLINE_STORAGE
+typedef hash_containers::inline_storage_policy_reuse_for_meta inline_storage_policy_t;
+#else
+typedef hash_containers::inline_storage_policy_unused         inline_storage_policy_t;
+#endif
+
                 
 template <typename K, typename V, size_t default_size = 32, 
           typename hash_func = std::hash<K>>
 using hash_table_t = hash_containers::closed_linear_probing_hash_table<
                              K, V, hash_func,
                              hash_containers::erase_policy_use_marker,
-                             default_size >;
+                             default_size,
+                             hash_containers::table_allocator<char>,
+                             hash_containers::shrink_policy_never,
+                             hash_containers::equal_to,
+                             inline_storage_policy_t >;
 
 
 /* Test basic methods */
@@ -189,6 +203,7 @@ int run_test_03(unsigned test_num, uint64_t random_number, bool debug=false) {
     hash_table_t<uint8_t, uint32_t,   1> comp0;
     hash_table_t<uint8_t, uint32_t,   8> comp1;
     hash_table_t<uint8_t, uint32_t, 128> comp2;
+    hash_table_t<uint8_t, uint32_t,   0> comp3;
 
     const unsigned primes[] = { 3, 5, 7, 11 };
     const unsigned num_operations = ((random_number >> 48) & 1023) + 1; // 1-1024
@@ -212,12 +227,14 @@ int run_test_03(unsigned test_num, uint64_t random_number, bool debug=false) {
             comp0[key] = value;
             comp1[key] = value;
             comp2[key] = value;
+            comp3[key] = value;
         }
         else {
             gold.erase(key);
             comp0.erase(key);
             comp1.erase(key);
             comp2.erase(key);
+            comp3.erase(key);
         }
 
         if (debug) {
@@ -234,20 +251,23 @@ int run_test_03(unsigned test_num, uint64_t random_number, bool debug=false) {
     std::vector<std::pair<uint32_t, uint32_t> > comp0_v(comp0.cbegin(), comp0.cend());
     std::vector<std::pair<uint32_t, uint32_t> > comp1_v(comp1.cbegin(), comp1.cend());
     std::vector<std::pair<uint32_t, uint32_t> > comp2_v(comp2.cbegin(), comp2.cend());
+    std::vector<std::pair<uint32_t, uint32_t> > comp3_v(comp3.cbegin(), comp3.cend());
 
     std::sort( gold_v.begin(),  gold_v.end());
     std::sort(comp0_v.begin(), comp0_v.end());
     std::sort(comp1_v.begin(), comp1_v.end());
     std::sort(comp2_v.begin(), comp2_v.end());
+    std::sort(comp3_v.begin(), comp3_v.end());
 
     if (debug) {
-        const size_t size_min = std::min(gold_v.size(), std::min(comp0_v.size(), std::min(comp1_v.size(), comp2_v.size())));
+        const size_t size_min = std::min(gold_v.size(), std::min(comp0_v.size(), std::min(comp1_v.size(), std::min(comp2_v.size(), comp3_v.size()))));
 
         for (size_t i = 0; i < size_min; i++) {
             if (gold_v[i] != comp0_v[i]
              || gold_v[i] != comp1_v[i]
-             || gold_v[i] != comp2_v[i]) {
-                printf("gold[0x%02x] = 0x%08x; comp0[0x%02x] = 0x%08x; comp1[0x%02x] = 0x%08x; comp2[0x%02x] = 0x%08x; /* at idx=%u */\n", gold_v[i].first, gold_v[i].second, comp0_v[i].first, comp0_v[i].second, comp1_v[i].first, comp1_v[i].second, comp2_v[i].first, comp2_v[i].second, i);
+             || gold_v[i] != comp2_v[i]
+             || gold_v[i] != comp3_v[i]) {
+                printf("gold[0x%02x] = 0x%08x; comp0[0x%02x] = 0x%08x; comp1[0x%02x] = 0x%08x; comp2[0x%02x] = 0x%08x; comp3[0x%02x] = 0x%08x; /* at idx=%u */\n", gold_v[i].first, gold_v[i].second, comp0_v[i].first, comp0_v[i].second, comp1_v[i].first, comp1_v[i].second, comp2_v[i].first, comp2_v[i].second, comp3_v[i].first, comp3_v[i].second, i);
             }
         }
         for (size_t i = size_min; i < gold_v.size(); i++) {
@@ -262,6 +282,9 @@ int run_test_03(unsigned test_num, uint64_t random_number, bool debug=false) {
         for (size_t i = size_min; i < comp2_v.size(); i++) {
             printf("comp2[0x%02x] = 0x%08x; /* at idx=%u */\n", comp2_v[i].first, comp2_v[i].second, i);
         }
+        for (size_t i = size_min; i < comp3_v.size(); i++) {
+            printf("comp3[0x%02x] = 0x%08x; /* at idx=%u */\n", comp3_v[i].first, comp3_v[i].second, i);
+        }
         printf("");
         return 1;
     }
@@ -281,6 +304,11 @@ int run_test_03(unsigned test_num, uint64_t random_number, bool debug=false) {
         return 1;
     }
 
+    if (gold_v.size() != comp3_v.size()) {
+        printf("size mismatch: gold: %u vs comp3: %u\n", gold_v.size(), comp3_v.size());
+        return 1;
+    }
+
     auto u0 = std::mismatch(gold_v.begin(), gold_v.end(), comp0_v.begin());
     if (u0.first != gold_v.end()) {
         printf("data mismatch: gold (%u, %u) vs comp0: (%u, %u)\n", u0.first->first, u0.first->second, u0.second->first, u0.second->second);
@@ -299,6 +327,12 @@ int run_test_03(unsigned test_num, uint64_t random_number, bool debug=false) {
         return 1;
     }
 
+    auto u3 = std::mismatch(gold_v.begin(), gold_v.end(), comp3_v.begin());
+    if (u3.first != gold_v.end()) {
+        printf("data mismatch: gold (%u, %u) vs comp3: (%u, %u)\n", u3.first->first, u3.first->second, u3.second->first, u3.second->second);
+        return 1;
+    }
+
     return 0;
 }
 
@@ -0,0 +1,39 @@
+/* Allocator shared by the tests, keeping track of the number of bytes it
+ * handed out.
+ */
+#ifndef HASH_CONTAINERS_TESTS_COUNTING_ALLOCATOR_H_GUARD
+#define HASH_CONTAINERS_TESTS_COUNTING_ALLOCATOR_H_GUARD 1
+
+#include <stddef.h>
+#include <new>
+
+/* Allocator that keeps track of the number of bytes it handed out */
+template <typename T>
+struct counting_allocator {
+    typedef T value_type;
+
+    size_t *bytes_in_use;
+
+    counting_allocator(size_t *bytes_in_use) : bytes_in_use(bytes_in_use) {}
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &other) : bytes_in_use(other.bytes_in_use) {}
+
+    T *allocate(size_t n) {
+        *bytes_in_use += n * sizeof(T);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) {
+        *bytes_in_use -= n * sizeof(T);
+        ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const counting_allocator<T> &a, const counting_allocator<U> &b) { return a.bytes_in_use == b.bytes_in_use; }
+
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T> &a, const counting_allocator<U> &b) { return a.bytes_in_use != b.bytes_in_use; }
+
+#endif /* HASH_CONTAINERS_TESTS_COUNTING_ALLOCATOR_H_GUARD */
@@ -0,0 +1,177 @@
+/* Tests the containers with C++17 std::pmr allocators.
+ */
+#include <memory_resource>
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+#include "closed_linear_probing_hash_table.h"
+#include "closed_linear_probing_hash_set.h"
+
+
+
+/* Memory resource that keeps track of the number of bytes it handed out */
+class counting_resource : public std::pmr::memory_resource {
+public:
+    size_t bytes_in_use = 0;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        this->bytes_in_use += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        this->bytes_in_use -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+
+
+/* Checks that <table> maps the keys 0 to <n> - 1 to their string */
+template <typename table_t>
+bool has_elements(const table_t &table, uint32_t n) {
+    if (table.size() != n) {
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (!table.count(i) || (*table.find(i)).second.get() != std::to_string(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+/* Test copies, moves and swaps of tables using a monotonic buffer resource */
+template <typename table_t>
+int run_pmr_test(bool debug) {
+
+    counting_resource upstream;
+    {
+        std::pmr::monotonic_buffer_resource arena(&upstream);
+        const typename table_t::allocator_type alloc(&arena);
+
+        const uint32_t sizes[] = { 0, 3, 100 };
+        for (uint32_t i : sizes) {
+            for (uint32_t j : sizes) {
+                table_t a(alloc);
+                table_t b(alloc);
+                for (uint32_t n = 0; n < i; n++) {
+                    a[n] = std::to_string(n);
+                }
+                for (uint32_t n = 0; n < j; n++) {
+                    b[n] = std::to_string(n);
+                }
+
+                // Copies use the default resource, as the standard containers'
+                table_t copy(a);
+                if (!has_elements(copy, i) || copy.get_allocator().resource() != std::pmr::get_default_resource()) {
+                    if (debug) {
+                        printf("copy of %u elements failed\n", i);
+                    }
+                    return 1;
+                }
+
+                // Assignments and swaps keep each table's resource
+                copy = b;
+                swap(a, b);
+                if (!has_elements(copy, j) || !has_elements(a, j) || !has_elements(b, i)
+                 || copy.get_allocator().resource() != std::pmr::get_default_resource()
+                 || a.get_allocator().resource() != &arena) {
+                    if (debug) {
+                        printf("assignment or swap of %u and %u elements failed\n", i, j);
+                    }
+                    return 1;
+                }
+
+                table_t moved(std::move(a));
+                b = std::move(moved);
+                if (!has_elements(b, j) || moved.size() || b.get_allocator().resource() != &arena) {
+                    if (debug) {
+                        printf("move of %u elements over %u failed\n", j, i);
+                    }
+                    return 1;
+                }
+            }
+        }
+
+        if (!upstream.bytes_in_use) {
+            if (debug) {
+                printf("tables didn't allocate from the resource\n");
+            }
+            return 1;
+        }
+    }
+
+    if (upstream.bytes_in_use) {
+        if (debug) {
+            printf("%u bytes weren't given back\n", unsigned(upstream.bytes_in_use));
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+/* Test tables and sets with std::pmr::polymorphic_allocator<> */
+int run_directed_test_0(bool debug = false) {
+
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_rehash, 32,
+                                                              std::pmr::polymorphic_allocator<char> > table0_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_use_marker, 0,
+                                                              std::pmr::polymorphic_allocator<char> > table1_t;
+    typedef hash_containers::closed_linear_probing_hash_table<uint32_t, std::string, std::hash<uint32_t>,
+                                                              hash_containers::erase_policy_empty_key<uint32_t>, 8,
+                                                              std::pmr::polymorphic_allocator<char> > table2_t;
+
+    if (run_pmr_test<table0_t>(debug) || run_pmr_test<table1_t>(debug) || run_pmr_test<table2_t>(debug)) {
+        if (debug) {
+            printf("In directed test 0:\npmr table test failed\n");
+        }
+        return 1;
+    }
+
+    typedef hash_containers::closed_linear_probing_hash_set<uint32_t, std::hash<uint32_t>,
+                                                            hash_containers::erase_policy_rehash, 32,
+                                                            std::pmr::polymorphic_allocator<char> > set_t;
+
+    std::pmr::monotonic_buffer_resource arena;
+    set_t a((set_t::allocator_type(&arena)));
+    set_t b((set_t::allocator_type(&arena)));
+    for (uint32_t i = 0; i < 100; i++) {
+        a.insert(i);
+    }
+    b = a;
+    set_t c(std::move(a));
+    std::swap(b, c);
+    b = std::move(c);
+    if (b.size() != 100 || !b.count(99) || c.size()) {
+        if (debug) {
+            printf("In directed test 0:\npmr set test failed\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+int main() {
+
+    int ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+
+    return 0;
+}
@@ -4,6 +4,14 @@
 #include <string>
 #include <stdint.h>
 #include "closed_linear_probing_hash_table.h"
+#include "monotonic_arena.h"
+#include "sparse_hash_table.h"
+#include "closed_linear_probing_hash_set.h"
+#include "dense_hash_table.h"
+#include "node_hash_table.h"
+#include "direct_index_table.h"
+#include "small_string.h"
+#include "string_arena_hash_table.h"
 
 struct hash_function_u8 {
     size_t operator()(uint8_t u8) {
@@ -13,6 +21,14 @@ struct hash_function_u8 {
 
 
 
+struct is_foo {
+    bool operator()(const std::pair<hash_containers::reference_wrapper<const uint8_t>, hash_containers::reference_wrapper<std::string> > &element) const {
+        return element.second.get() == "foo";
+    }
+};
+
+
+
 int main() {
 
     hash_containers::closed_linear_probing_hash_table< uint8_t, uint32_t, hash_function_u8 > test0;
@@ -60,12 +76,108 @@ int main() {
     
     test2[0] = "foo";
     test3[0] = "bar";
+
+    hash_containers::closed_linear_probing_hash_table< uint8_t, std::string, hash_function_u8 > test2_copy(test2);
+    test2_copy = test2;
+    test2_copy.swap(test2);
+    swap(test2_copy, test2);
+    test2_copy.erase(test2_copy.begin());
+    test2_copy[0] = "foo";
+    erase_if(test2_copy, is_foo());
+    test3.erase_if(is_foo());
     if ((*test2.begin()).second.get() != std::string("foo")) {}
     if ((*test3.begin()).second.get() != std::string("bar")) {}
 
     (*test2.begin()).second.get() = "f00";
     (*test3.begin()).second.get() = "b4r";
 
+    hash_containers::closed_linear_probing_hash_table< uint8_t, uint32_t, hash_function_u8, hash_containers::erase_policy_rehash, 32, std::allocator<char> > test4((std::allocator<char>()));
+    test4.reserve(64);
+    test4[0] = 1;
+    test4.clear();
+    std::allocator<char> a4 = test4.get_allocator();
+
+    hash_containers::monotonic_arena arena;
+    {
+        hash_containers::closed_linear_probing_hash_table< uint8_t, std::string, hash_function_u8, hash_containers::erase_policy_rehash, 8, hash_containers::arena_allocator<char> > test5((hash_containers::arena_allocator<char>(&arena)));
+        test5.reserve(64);
+        test5[0] = "foo";
+    }
+    arena.release();
+
+    hash_containers::closed_linear_probing_hash_table< uint8_t, uint32_t, hash_function_u8, hash_containers::erase_policy_use_marker, 32, hash_containers::table_allocator<char>, hash_containers::shrink_policy_hysteresis<> > test6;
+    test6.rehash(128);
+    test6[0] = 1;
+    test6.erase(0);
+    test6.shrink_to_fit();
+
+    hash_containers::closed_linear_probing_hash_table< uint8_t, uint32_t, hash_function_u8, hash_containers::erase_policy_use_marker, 8, hash_containers::table_allocator<char>, hash_containers::shrink_policy_never, hash_containers::equal_to, hash_containers::inline_storage_policy_reuse_for_meta > test16;
+    test16.reserve(64);
+    test16[0] = 1;
+    test16.erase(0);
+
+    hash_containers::closed_linear_probing_hash_table< uint8_t, uint32_t, hash_containers::seeded_hash<uint8_t, hash_function_u8> > test15((hash_containers::seeded_hash<uint8_t, hash_function_u8>(1)));
+    test15[0] = 1;
+    test15.erase(0);
+    if (test15.hash_function().get_seed() != 1) {}
+
+    hash_containers::sparse_hash_table< uint8_t, std::string, hash_function_u8 > test7;
+    test7[0] = "foo";
+    test7.insert(1, "bar");
+    test7.erase(0);
+    if (test7.count(1) && (*test7.find(1)).second.get() != std::string("bar")) {}
+    std::vector<std::pair<const uint8_t, const std::string> > v7(test7.cbegin(), test7.cend());
+    test7.clear();
+
+    hash_containers::closed_linear_probing_hash_set< uint8_t, hash_function_u8 > test8;
+    test8.insert(0);
+    if (test8.contains(0) && *test8.find(0) == 0) {}
+    test8.erase(0);
+    std::vector<uint8_t> v8(test8.cbegin(), test8.cend());
+
+    hash_containers::closed_linear_probing_hash_table< uint8_t, std::string, hash_function_u8, hash_containers::erase_policy_empty_key<uint8_t, 0xff, 0xfe>, 0 > test11;
+    test11[0] = "foo";
+    test11.erase(0);
+    test11.clear();
+
+    hash_containers::dense_hash_table< uint8_t, std::string, hash_function_u8 > test9;
+    test9[0] = "foo";
+    test9.insert(1, "bar");
+    test9.reserve(16);
+    test9.erase(0);
+    if (test9.count(1) && (*test9.find(1)).second.get() != std::string("bar")) {}
+    std::vector<std::pair<const uint8_t, const std::string> > v9(test9.cbegin(), test9.cend());
+    test9.clear();
+
+    hash_containers::node_hash_table< uint8_t, std::string, hash_function_u8 > test10;
+    test10[0] = "foo";
+    test10.insert(1, "bar");
+    test10.reserve(16);
+    test10.erase(0);
+    if (test10.count(1) && (*test10.find(1)).second.get() != std::string("bar")) {}
+    std::vector<std::pair<const uint8_t, const std::string> > v10(test10.cbegin(), test10.cend());
+    test10.clear();
+
+    hash_containers::direct_index_table< uint16_t, std::string > test12;
+    test12[0] = "foo";
+    test12.insert(1, "bar");
+    test12.erase(0);
+    if (test12.count(1) && (*test12.find(1)).second.get() != std::string("bar")) {}
+    std::vector<std::pair<const uint16_t, const std::string> > v12(test12.cbegin(), test12.cend());
+    test12.clear();
+
+    hash_containers::closed_linear_probing_hash_table< hash_containers::small_string, uint32_t, hash_containers::small_string_hash > test13;
+    test13[hash_containers::small_string("foo")] = 1;
+    test13.erase(hash_containers::small_string(std::string(40, 'x')));
+    if (test13.count("foo") && (*test13.find("foo")).first.get().str() != "foo") {}
+
+    hash_containers::string_arena_hash_table< std::string > test14;
+    test14["foo"] = "foo";
+    test14.insert(std::string("bar"), "bar");
+    test14.erase(hash_containers::string_ref("foo", 3));
+    if (test14.count("bar") && (*test14.find("bar")).second.get() != std::string("bar")) {}
+    test14.clear();
+
     return 0;
 }
 
@@ -0,0 +1,342 @@
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+#define _CRTDBG_MAP_ALLOC
+#include <stdlib.h>
+#include <crtdbg.h>
+
+#ifndef DBG_NEW
+   #define DBG_NEW new ( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+   #define new DBG_NEW
+#endif
+
+#endif
+
+
+#include "direct_index_table.h"
+#include "counting_allocator.h"
+
+#include <random>
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <string>
+
+
+
+/* Test basic methods */
+int run_test_00(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    std::unordered_map<uint8_t, uint32_t> gold;
+    hash_containers::direct_index_table<uint8_t, uint32_t> comp;
+
+    const unsigned primes[] = { 3, 5, 7, 11 };
+    const unsigned num_operations = ((random_number >> 48) & 1023) + 1; // 1-1024
+    const unsigned seq_size = primes[(random_number >> 58) & 3];
+
+    std::mt19937 rng(test_num);
+
+    if (debug) {
+        printf("test_num: %u,  random_number: 0x%016llx\n", test_num, random_number);
+    }
+
+    for (unsigned i = 0; i < num_operations; i++) {
+        const uint8_t mode = (random_number >> ((i % seq_size) * 2)) & 3;
+
+        const uint8_t key = static_cast<uint8_t>(rng() & 0xff);
+        uint32_t value = 0;
+
+        switch (mode) {
+        case 0:
+            value     = rng();
+            gold[key] = value;
+            comp[key] = value;
+
+            if (debug) {
+                printf("/*%4u*/ gold[0x%02x] = 0x%08x;  comp[0x%02x] = 0x%08x;\n", i, key, value, key, value);
+            }
+
+            if (gold[key] != comp[key]) {
+                if (debug) {
+                    printf("gold[0x%02x] != comp[0x%02x]. Was expecting 0x%08x, but got 0x%08x.\n", key, key, gold[key], comp[key]);
+                }
+                return 1;
+            }
+            break;
+        case 1:
+            gold.erase(key);
+            comp.erase(key);
+
+            if (debug) {
+                printf("/*%4u*/ gold.erase(0x%02x);     comp.erase(0x%02x);\n", i, key, key);
+            }
+            break;
+        case 2:
+            value = rng();
+
+            if (debug) {
+                printf("/*%4u*/ gold.insert(0x%02x, 0x%08x);     comp.insert(0x%02x, 0x%08x);\n", i, key, value, key, value);
+            }
+
+            gold.insert(std::make_pair(key, value));
+            comp.insert(key, value);
+            break;
+        case 3:
+
+            if (debug) {
+                printf("/*%4u*/ gold.find(0x%02x);     comp.find(0x%02x);\n", i, key, key);
+            }
+
+            {
+                std::unordered_map<uint8_t, uint32_t>::const_iterator                 gold_f = gold.find(key);
+                hash_containers::direct_index_table<uint8_t, uint32_t>::const_iterator comp_f = comp.find(key);
+                bool gold_b = (gold_f != gold.end());
+                bool comp_b = (comp_f != comp.cend());
+                if (gold_b != comp_b || gold.count(key) != comp.count(key)) {
+                    if (debug) {
+                        printf("gold.find(0x%02x) != comp.find(0x%02x).\n", key, key);
+                    }
+                    return 1;
+                }
+                if (gold_f != gold.end() && (gold_f->first != (*comp_f).first.get() || gold_f->second != (*comp_f).second.get())) {
+                    if (debug) {
+                        printf("*gold.find(0x%02x) != *comp.find(0x%02x)\n", key, key);
+                    }
+                    return 1;
+                }
+            }
+
+            if (((random_number >> 40) & 0xff) == 0) {
+                if (debug) {
+                    printf("gold.clear();  comp.clear();\n");
+                }
+                gold.clear();
+                comp.clear();
+            }
+            break;
+        default:
+            assert(0);
+            break;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t> > gold_v(gold.cbegin(), gold.cend());
+    std::vector<std::pair<uint32_t, uint32_t> > comp_v(comp.cbegin(), comp.cend());
+
+    std::sort(gold_v.begin(), gold_v.end());
+    std::sort(comp_v.begin(), comp_v.end());
+
+    if (gold_v != comp_v || gold.size() != comp.size()) {
+        if (debug) {
+            printf("size: gold: %u vs comp: %u\n", unsigned(gold.size()), unsigned(comp.size()));
+            for (size_t i = 0; i < std::min(gold_v.size(), comp_v.size()); i++) {
+                if (gold_v[i] != comp_v[i]) {
+                    printf("gold[0x%02x] = 0x%08x;  comp[0x%02x] = 0x%08x; /* at idx=%u */\n", gold_v[i].first, gold_v[i].second, comp_v[i].first, comp_v[i].second, unsigned(i));
+                }
+            }
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Test non-POD values, over 16-bit keys */
+int run_test_01(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    std::unordered_map<uint16_t, std::string> gold;
+    hash_containers::direct_index_table<uint16_t, std::string> comp;
+
+    const unsigned num_operations = ((random_number >> 48) & 4095) + 1; // 1-4096
+    const uint32_t key_mask = (1u << ((random_number >> 32) & 15)) - 1;  // 1-32768 keys
+    const uint16_t key_base = static_cast<uint16_t>(random_number >> 16);
+
+    std::mt19937 rng(test_num);
+
+    if (debug) {
+        printf("test_num: %u,  random_number: 0x%016llx\n", test_num, random_number);
+    }
+
+    for (unsigned i = 0; i < num_operations; i++) {
+        const uint8_t  mode = (random_number >> ((i % 13) * 2)) & 3;
+        const uint16_t key  = static_cast<uint16_t>((rng() & key_mask) + key_base);
+
+        switch (mode) {
+        case 0:
+        case 2:
+            gold[key] = std::to_string(i);
+            comp[key] = std::to_string(i);
+            break;
+        case 1:
+            gold.erase(key);
+            comp.erase(key);
+            break;
+        case 3:
+            if (gold.count(key) != comp.count(key) || (gold.count(key) && gold[key] != (*comp.find(key)).second.get())) {
+                if (debug) {
+                    printf("/*%4u*/ lookup mismatch for key 0x%08x\n", i, key);
+                }
+                return 1;
+            }
+            break;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, std::string> > gold_v(gold.cbegin(), gold.cend());
+    std::vector<std::pair<uint32_t, std::string> > comp_v;
+    for (hash_containers::direct_index_table<uint16_t, std::string>::const_iterator it = comp.cbegin(); it != comp.cend(); ++it) {
+        comp_v.push_back(std::make_pair((*it).first.get(), (*it).second.get()));
+    }
+
+    std::sort(gold_v.begin(), gold_v.end());
+    std::sort(comp_v.begin(), comp_v.end());
+
+    if (gold_v != comp_v || gold.size() != comp.size()) {
+        if (debug) {
+            printf("data mismatch: gold: %u elements vs comp: %u elements\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int run_test(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    const uint32_t variant = static_cast<uint32_t>((random_number >> 63) & 1);
+
+    switch (variant) {
+    case  0: return run_test_00(test_num, random_number, debug);
+    case  1: return run_test_01(test_num, random_number, debug);
+    default: assert(0);
+    }
+
+    return 1;
+}
+
+
+
+/* Test memory use and signed keys */
+int run_directed_test_0(bool debug = false) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        typedef hash_containers::direct_index_table<int8_t, uint32_t, counting_allocator<char> > table_t;
+
+        table_t comp((table_t::allocator_type(&bytes_in_use)));
+
+        if (comp.capacity() || comp.size() || comp.count(1) || comp.cbegin() != comp.cend() || bytes_in_use) {
+            if (debug) {
+                printf("In directed test 0:\nempty container is not empty\n");
+            }
+            return 1;
+        }
+
+        // One block for all the slots: bitmap, keys and values
+        for (int i = -128; i < 128; i++) {
+            comp[int8_t(i)] = uint32_t(i + 1000);
+        }
+        const size_t expected_size = 256 / 8 + 256 * (sizeof(int8_t) + sizeof(uint32_t)) + 3 * HASH_CONTAINERS_CACHE_LINE_SIZE;
+        if (comp.size() != 256 || comp.capacity() != 256 || bytes_in_use > expected_size) {
+            if (debug) {
+                printf("In directed test 0:\n%u elements, %u bytes in use, expected at most %u\n", unsigned(comp.size()), unsigned(bytes_in_use), unsigned(expected_size));
+            }
+            return 1;
+        }
+
+        for (int i = -128; i < 128; i += 2) {
+            comp.erase(int8_t(i));
+        }
+        int num_iterated = 0;
+        for (table_t::const_iterator it = comp.cbegin(); it != comp.cend(); ++it, num_iterated++) {
+            const int key = (*it).first.get();
+            if ((key & 1) == 0 || (*it).second.get() != uint32_t(key + 1000)) {
+                if (debug) {
+                    printf("In directed test 0:\ndata mismatch for key %d\n", key);
+                }
+                return 1;
+            }
+        }
+        if (num_iterated != 128 || comp.size() != 128 || comp.count(-2) || !comp.count(-1)) {
+            if (debug) {
+                printf("In directed test 0:\n%d elements iterated, size %u\n", num_iterated, unsigned(comp.size()));
+            }
+            return 1;
+        }
+
+        comp.clear();
+        if (comp.size() || comp.cbegin() != comp.cend() || comp.count(-1)) {
+            if (debug) {
+                printf("In directed test 0:\ncontainer not empty after clear()\n");
+            }
+            return 1;
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("In directed test 0:\n%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int main() {
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
+    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
+#endif
+
+    /* Directed tests */
+
+    int ret;
+    ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+
+
+    /* Randoms tests */
+
+    std::mt19937_64 rng(static_cast<uint32_t>(time(NULL)));
+
+#ifdef _DEBUG
+    unsigned max_test =  0x1000;
+#else
+    unsigned max_test = 0x10000;
+#endif
+
+    printf("      ");
+    for (unsigned test_num = 0; test_num < max_test; test_num++) {
+
+        uint64_t rnd = rng();
+
+        int ret = run_test(test_num, rnd);
+        if (ret) {
+            run_test(test_num, rnd, /*debug*/true);
+            return ret;
+        }
+
+        if (!(test_num & 0xff)) {
+            printf("\b\b\b\b\b\b%5.1f%%", test_num / double(max_test) * 100);
+            fflush(stdout);
+        }
+    }
+    printf("\b\b\b\b\b\b100.0%%\n");
+    return 0;
+}
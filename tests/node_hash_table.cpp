@@ -0,0 +1,393 @@
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+#define _CRTDBG_MAP_ALLOC
+#include <stdlib.h>
+#include <crtdbg.h>
+
+#ifndef DBG_NEW
+   #define DBG_NEW new ( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+   #define new DBG_NEW
+#endif
+
+#endif
+
+
+#include "node_hash_table.h"
+#include "counting_allocator.h"
+
+#include <random>
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <string>
+
+
+
+/* Test basic methods, with non-POD values */
+int run_test_00(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    std::unordered_map<uint32_t, std::string> gold;
+    hash_containers::node_hash_table<uint32_t, std::string> comp;
+
+    const unsigned num_operations = ((random_number >> 48) & 4095) + 1; // 1-4096
+    const uint32_t key_mask = (1u << ((random_number >> 32) & 15)) - 1;  // 1-32768 keys
+
+    std::mt19937 rng(test_num);
+
+    if (debug) {
+        printf("test_num: %u,  random_number: 0x%016llx\n", test_num, random_number);
+    }
+
+    for (unsigned i = 0; i < num_operations; i++) {
+        const uint8_t  mode = (random_number >> ((i % 13) * 2)) & 3;
+        const uint32_t key  = static_cast<uint32_t>(rng()) & key_mask;
+
+        switch (mode) {
+        case 0:
+        case 2:
+            gold[key] = std::to_string(i);
+            comp[key] = std::to_string(i);
+            break;
+        case 1:
+            gold.erase(key);
+            comp.erase(key);
+            break;
+        case 3:
+            if (gold.count(key) != comp.count(key) || (gold.count(key) && gold[key] != (*comp.find(key)).second.get())) {
+                if (debug) {
+                    printf("/*%4u*/ lookup mismatch for key 0x%08x\n", i, key);
+                }
+                return 1;
+            }
+            break;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, std::string> > gold_v(gold.cbegin(), gold.cend());
+    std::vector<std::pair<uint32_t, std::string> > comp_v;
+    for (hash_containers::node_hash_table<uint32_t, std::string>::const_iterator it = comp.cbegin(); it != comp.cend(); ++it) {
+        comp_v.push_back(std::make_pair((*it).first.get(), (*it).second.get()));
+    }
+
+    std::sort(gold_v.begin(), gold_v.end());
+    std::sort(comp_v.begin(), comp_v.end());
+
+    if (gold_v != comp_v || gold.size() != comp.size()) {
+        if (debug) {
+            printf("data mismatch: gold: %u elements vs comp: %u elements\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int run_test(unsigned test_num, uint64_t random_number, bool debug = false) {
+    return run_test_00(test_num, random_number, debug);
+}
+
+
+
+/* Test pointer stability and node reuse */
+int run_directed_test_0(bool debug = false) {
+
+    size_t bytes_in_use = 0;
+
+    {
+        typedef hash_containers::node_hash_table<uint32_t, std::string, std::hash<uint32_t>, counting_allocator<char> > table_t;
+
+        table_t comp((table_t::allocator_type(&bytes_in_use)));
+
+        if (comp.capacity() || comp.size() || comp.count(1) || comp.cbegin() != comp.cend() || bytes_in_use) {
+            if (debug) {
+                printf("In directed test 0:\nempty container is not empty\n");
+            }
+            return 1;
+        }
+
+        const uint32_t num_elements = 10000;
+        std::vector<std::string*> pointers;
+        for (uint32_t i = 0; i < num_elements; i++) {
+            std::string &value = comp[i * 2654435761u];
+            value = std::to_string(i);
+            pointers.push_back(&value);
+        }
+
+        // Values didn't move as the table grew
+        for (uint32_t i = 0; i < num_elements; i++) {
+            table_t::iterator it = comp.find(i * 2654435761u);
+            if (it == comp.end() || &(*it).second.get() != pointers[i] || *pointers[i] != std::to_string(i)) {
+                if (debug) {
+                    printf("In directed test 0:\nelement %u moved\n", i);
+                }
+                return 1;
+            }
+        }
+
+        // Erased nodes are reused
+        const size_t bytes_before = bytes_in_use;
+        for (uint32_t i = 0; i < num_elements; i += 2) {
+            comp.erase(i * 2654435761u);
+        }
+        for (uint32_t i = 0; i < num_elements; i += 2) {
+            comp.insert(i * 2654435761u + 1, std::to_string(i));
+        }
+        if (comp.size() != num_elements || bytes_in_use != bytes_before) {
+            if (debug) {
+                printf("In directed test 0:\n%u bytes in use, was %u before erasing\n", unsigned(bytes_in_use), unsigned(bytes_before));
+            }
+            return 1;
+        }
+
+        for (uint32_t i = 1; i < num_elements; i += 2) {
+            if (*pointers[i] != std::to_string(i) || comp.count(i * 2654435761u) != 1) {
+                if (debug) {
+                    printf("In directed test 0:\ndata mismatch for element %u\n", i);
+                }
+                return 1;
+            }
+        }
+
+        comp.clear();
+        comp.reserve(num_elements * 2);
+        const size_t bytes_reserved = bytes_in_use;
+        for (uint32_t i = 0; i < num_elements * 2; i++) {
+            comp.insert(i, std::string());
+        }
+        if (comp.size() != num_elements * 2 || bytes_in_use != bytes_reserved) {
+            if (debug) {
+                printf("In directed test 0:\nreserve() didn't make room for all elements\n");
+            }
+            return 1;
+        }
+    }
+
+    if (bytes_in_use) {
+        if (debug) {
+            printf("In directed test 0:\n%u bytes leaked\n", unsigned(bytes_in_use));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Test that tables hash with their own seeded_hash instance, including on
+ * erase() and const lookups
+ */
+int run_directed_test_1(bool debug = false) {
+
+    typedef hash_containers::seeded_hash<uint32_t> seeded_t;
+    typedef hash_containers::node_hash_table<uint32_t, uint32_t, seeded_t> table_t;
+
+    table_t table0, table1;
+    table_t table2((seeded_t(12345)));
+    if (table0.hash_function().get_seed() == table1.hash_function().get_seed()
+     || table2.hash_function().get_seed() != 12345) {
+        if (debug) {
+            printf("In directed test 1:\nseeds weren't set\n");
+        }
+        return 1;
+    }
+
+    const uint32_t num_elements = 1000;
+    for (uint32_t i = 0; i < num_elements; i++) {
+        table0[i << 16] = i;
+        table2.insert(i << 16, i);
+    }
+    for (uint32_t i = 0; i < num_elements; i += 2) {
+        table0.erase(i << 16);
+        table2.erase(i << 16);
+    }
+
+    const table_t &const_table0 = table0;
+    const table_t &const_table2 = table2;
+    for (uint32_t i = 0; i < num_elements; i++) {
+        const size_t expected = i & 1;
+        if (const_table0.count(i << 16) != expected || const_table2.count(i << 16) != expected
+         || (expected && ((*const_table0.find(i << 16)).second.get() != i || (*const_table2.find(i << 16)).second.get() != i))) {
+            if (debug) {
+                printf("In directed test 1:\nlookup failed with seeded_hash for element %u\n", i);
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+
+/* Key and value whose copies throw on request, counting live instances */
+struct throwing_value {
+    static int num_live;
+    static int num_copies_left;  // Copies before one throws, if >= 0
+    uint32_t value;
+
+    throwing_value() : value(0) {
+        num_live++;
+    }
+    throwing_value(uint32_t value) : value(value) {
+        num_live++;
+    }
+    throwing_value(const throwing_value &other) : value(other.value) {
+        if (num_copies_left == 0) {
+            throw 0;
+        }
+        if (num_copies_left > 0) {
+            num_copies_left--;
+        }
+        num_live++;
+    }
+    ~throwing_value() {
+        num_live--;
+    }
+
+    bool operator==(const throwing_value &other) const {
+        return this->value == other.value;
+    }
+    bool operator!=(const throwing_value &other) const {
+        return this->value != other.value;
+    }
+};
+
+int throwing_value::num_live        = 0;
+int throwing_value::num_copies_left = -1;
+
+/* Relocating elements doesn't copy them: only the insertions' copies throw */
+namespace hash_containers {
+    template <>
+    struct is_trivially_relocatable<throwing_value> {
+        static const bool value = true;
+    };
+}
+
+struct throwing_value_hash {
+    size_t operator()(const throwing_value &v) const {
+        return v.value;
+    }
+};
+
+
+
+/* Test that insertions whose key or value copy throws leave the table as
+ * it was
+ */
+int run_directed_test_2(bool debug = false) {
+
+    typedef hash_containers::node_hash_table<throwing_value, throwing_value, throwing_value_hash> table_t;
+
+    {
+        table_t table;
+        for (uint32_t i = 0; i < 100; i++) {
+            table.insert(throwing_value(i), throwing_value(i));
+        }
+
+        for (uint32_t i = 100; i < 200; i++) {
+            const throwing_value key(i), value(i);
+
+            // Even keys throw on the key copy, odd ones on the value copy
+            throwing_value::num_copies_left = i & 1;
+            try {
+                table.insert(key, value);
+            }
+            catch (int) {
+            }
+            throwing_value::num_copies_left = -1;
+
+            if (table.size() != 100 || table.count(key) || throwing_value::num_live != 202) {
+                if (debug) {
+                    printf("In directed test 2:\nthrowing insertion of %u changed the table\n", i);
+                }
+                return 1;
+            }
+        }
+
+        for (uint32_t i = 0; i < 100; i++) {
+            table_t::const_iterator it = table.find(throwing_value(i));
+            if (it == table.cend() || (*it).second.get().value != i) {
+                if (debug) {
+                    printf("In directed test 2:\ndata mismatch for element %u\n", i);
+                }
+                return 1;
+            }
+        }
+    }
+
+    if (throwing_value::num_live) {
+        if (debug) {
+            printf("In directed test 2:\n%d keys or values leaked\n", throwing_value::num_live);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+int main() {
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
+    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
+#endif
+
+    /* Directed tests */
+
+    int ret;
+    ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_1();
+    if (ret) {
+        run_directed_test_1(/*debug*/true);
+        return ret;
+    }
+
+    ret = run_directed_test_2();
+    if (ret) {
+        run_directed_test_2(/*debug*/true);
+        return ret;
+    }
+
+
+    /* Randoms tests */
+
+    std::mt19937_64 rng(static_cast<uint32_t>(time(NULL)));
+
+#ifdef _DEBUG
+    unsigned max_test =  0x1000;
+#else
+    unsigned max_test = 0x10000;
+#endif
+
+    printf("      ");
+    for (unsigned test_num = 0; test_num < max_test; test_num++) {
+
+        uint64_t rnd = rng();
+
+        int ret = run_test(test_num, rnd);
+        if (ret) {
+            run_test(test_num, rnd, /*debug*/true);
+            return ret;
+        }
+
+        if (!(test_num & 0xff)) {
+            printf("\b\b\b\b\b\b%5.1f%%", test_num / double(max_test) * 100);
+            fflush(stdout);
+        }
+    }
+    printf("\b\b\b\b\b\b100.0%%\n");
+    return 0;
+}
@@ -0,0 +1,220 @@
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+#define _CRTDBG_MAP_ALLOC
+#include <stdlib.h>
+#include <crtdbg.h>
+
+#ifndef DBG_NEW
+   #define DBG_NEW new ( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+   #define new DBG_NEW
+#endif
+
+#endif
+
+
+#include "small_string.h"
+#include "closed_linear_probing_hash_table.h"
+
+#include <random>
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <string>
+
+
+
+/* Returns a random key: strings of 0 to 40 characters, so both inline and
+ * heap storage are used, out of a small set of values.
+ */
+static std::string get_key(std::mt19937 &rng, uint32_t key_mask) {
+    const uint32_t id = static_cast<uint32_t>(rng()) & key_mask;
+    return std::string(id % 41, 'a' + (id % 26)) + std::to_string(id);
+}
+
+
+
+/* Test basic methods, against std::unordered_map<> with std::string keys */
+template <typename table_t>
+int run_table_test(unsigned test_num, uint64_t random_number, bool debug) {
+
+    std::unordered_map<std::string, uint32_t> gold;
+    table_t comp;
+
+    const unsigned num_operations = ((random_number >> 48) & 2047) + 1; // 1-2048
+    const uint32_t key_mask = (1u << ((random_number >> 32) & 11)) - 1;  // 1-1024 keys
+
+    std::mt19937 rng(test_num);
+
+    if (debug) {
+        printf("test_num: %u,  random_number: 0x%016llx\n", test_num, random_number);
+    }
+
+    for (unsigned i = 0; i < num_operations; i++) {
+        const uint8_t     mode = (random_number >> ((i % 13) * 2)) & 3;
+        const std::string key  = get_key(rng, key_mask);
+
+        switch (mode) {
+        case 0:
+        case 2:
+            if (debug) {
+                printf("/*%4u*/ gold[\"%s\"] = %u;  comp[\"%s\"] = %u;\n", i, key.c_str(), i, key.c_str(), i);
+            }
+            gold[key] = i;
+            comp[hash_containers::small_string(key)] = i;
+            break;
+        case 1:
+            if (debug) {
+                printf("/*%4u*/ gold.erase(\"%s\");  comp.erase(\"%s\");\n", i, key.c_str(), key.c_str());
+            }
+            gold.erase(key);
+            comp.erase(hash_containers::small_string(key));
+            break;
+        case 3:
+            if (gold.count(key) != comp.count(hash_containers::small_string(key))
+             || (gold.count(key) && gold[key] != comp[hash_containers::small_string(key)])) {
+                if (debug) {
+                    printf("/*%4u*/ lookup mismatch for key \"%s\"\n", i, key.c_str());
+                }
+                return 1;
+            }
+            break;
+        }
+    }
+
+    std::vector<std::pair<std::string, uint32_t> > gold_v(gold.cbegin(), gold.cend());
+    std::vector<std::pair<std::string, uint32_t> > comp_v;
+    for (typename table_t::const_iterator it = comp.cbegin(); it != comp.cend(); ++it) {
+        comp_v.push_back(std::make_pair((*it).first.get().str(), (*it).second.get()));
+    }
+
+    std::sort(gold_v.begin(), gold_v.end());
+    std::sort(comp_v.begin(), comp_v.end());
+
+    if (gold_v != comp_v || gold.size() != comp.size()) {
+        if (debug) {
+            printf("data mismatch: gold: %u elements vs comp: %u elements\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int run_test(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    const uint32_t variant = static_cast<uint32_t>((random_number >> 63) & 1);
+
+    switch (variant) {
+    case  0: return run_table_test<hash_containers::closed_linear_probing_hash_table<hash_containers::small_string, uint32_t, hash_containers::small_string_hash> >(test_num, random_number, debug);
+    case  1: return run_table_test<hash_containers::closed_linear_probing_hash_table<hash_containers::small_string, uint32_t, std::hash<hash_containers::small_string>,
+                                                                                     hash_containers::erase_policy_use_marker> >(test_num, random_number, debug);
+    default: assert(0);
+    }
+
+    return 1;
+}
+
+
+
+/* Test the string type itself */
+int run_directed_test_0(bool debug = false) {
+
+    const std::string long_str(100, 'x');
+
+    hash_containers::small_string empty;
+    hash_containers::small_string short0("abc");
+    hash_containers::small_string short1(std::string("abc"));
+    hash_containers::small_string full("0123456789012345678901");   // INLINE_CAPACITY bytes
+    hash_containers::small_string long0(long_str);
+    hash_containers::small_string long1(long_str.c_str(), long_str.size());
+
+    if (empty.size() || strcmp(empty.c_str(), "")
+     || short0 != short1 || short0.get_hash() != short1.get_hash() || short0.str() != "abc"
+     || full.size() != hash_containers::small_string::INLINE_CAPACITY || full.str() != "0123456789012345678901"
+     || long0 != long1 || long0.str() != long_str
+     || short0 == full || long0 == short0 || empty == short0) {
+        if (debug) {
+            printf("In directed test 0:\nconstruction or comparison failed\n");
+        }
+        return 1;
+    }
+
+    // Copies keep the hash, and own their storage
+    hash_containers::small_string copy(long0);
+    copy = short0;
+    copy = long1;
+    hash_containers::small_string copy2(copy);
+    if (copy != long0 || copy2 != long0 || copy.get_hash() != long0.get_hash() || copy.c_str() == long0.c_str()) {
+        if (debug) {
+            printf("In directed test 0:\ncopy failed\n");
+        }
+        return 1;
+    }
+
+    // Moves take over the heap storage
+    const char *long_data = copy.c_str();
+    hash_containers::small_string moved(std::move(copy));
+    if (moved != long0 || moved.c_str() != long_data || copy.size() || copy != empty) {
+        if (debug) {
+            printf("In directed test 0:\nmove failed\n");
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+int main() {
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
+    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
+#endif
+
+    /* Directed tests */
+
+    int ret;
+    ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+
+
+    /* Randoms tests */
+
+    std::mt19937_64 rng(static_cast<uint32_t>(time(NULL)));
+
+#ifdef _DEBUG
+    unsigned max_test =  0x1000;
+#else
+    unsigned max_test = 0x10000;
+#endif
+
+    printf("      ");
+    for (unsigned test_num = 0; test_num < max_test; test_num++) {
+
+        uint64_t rnd = rng();
+
+        int ret = run_test(test_num, rnd);
+        if (ret) {
+            run_test(test_num, rnd, /*debug*/true);
+            return ret;
+        }
+
+        if (!(test_num & 0xff)) {
+            printf("\b\b\b\b\b\b%5.1f%%", test_num / double(max_test) * 100);
+            fflush(stdout);
+        }
+    }
+    printf("\b\b\b\b\b\b100.0%%\n");
+    return 0;
+}
@@ -0,0 +1,277 @@
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+#define _CRTDBG_MAP_ALLOC
+#include <stdlib.h>
+#include <crtdbg.h>
+
+#ifndef DBG_NEW
+   #define DBG_NEW new ( _NORMAL_BLOCK , __FILE__ , __LINE__ )
+   #define new DBG_NEW
+#endif
+
+#endif
+
+
+#include "string_arena_hash_table.h"
+
+#include <random>
+#include <assert.h>
+#include <stdint.h>
+#include <time.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+#include <string>
+
+
+
+/* Returns a random key: strings of 0 to 40 characters, out of a small set of
+ * values.
+ */
+static std::string get_key(std::mt19937 &rng, uint32_t key_mask) {
+    const uint32_t id = static_cast<uint32_t>(rng()) & key_mask;
+    return std::string(id % 41, 'a' + (id % 26)) + std::to_string(id);
+}
+
+
+
+/* Test basic methods, against std::unordered_map<> with std::string keys */
+int run_test(unsigned test_num, uint64_t random_number, bool debug = false) {
+
+    typedef hash_containers::string_arena_hash_table<uint32_t> table_t;
+
+    std::unordered_map<std::string, uint32_t> gold;
+    table_t comp;
+
+    const unsigned num_operations = ((random_number >> 48) & 2047) + 1; // 1-2048
+    const uint32_t key_mask = (1u << ((random_number >> 32) & 11)) - 1;  // 1-1024 keys
+
+    std::mt19937 rng(test_num);
+
+    if (debug) {
+        printf("test_num: %u,  random_number: 0x%016llx\n", test_num, random_number);
+    }
+
+    for (unsigned i = 0; i < num_operations; i++) {
+        const uint8_t     mode = (random_number >> ((i % 13) * 2)) & 3;
+        const std::string key  = get_key(rng, key_mask);
+
+        switch (mode) {
+        case 0:
+            if (debug) {
+                printf("/*%4u*/ gold[\"%s\"] = %u;  comp[\"%s\"] = %u;\n", i, key.c_str(), i, key.c_str(), i);
+            }
+            gold[key] = i;
+            comp[key] = i;
+            break;
+        case 1:
+            if (debug) {
+                printf("/*%4u*/ gold.erase(\"%s\");  comp.erase(\"%s\");\n", i, key.c_str(), key.c_str());
+            }
+            gold.erase(key);
+            comp.erase(key.c_str());
+            break;
+        case 2:
+            if (debug) {
+                printf("/*%4u*/ gold.insert(\"%s\", %u);  comp.insert(\"%s\", %u);\n", i, key.c_str(), i, key.c_str(), i);
+            }
+            if (gold.insert(std::make_pair(key, i)).second != comp.insert(hash_containers::string_ref(key.data(), key.size()), i)) {
+                return 1;
+            }
+            break;
+        case 3:
+            if (gold.count(key) != comp.count(key)
+             || (gold.count(key) && gold[key] != (*comp.find(key.c_str())).second.get())) {
+                if (debug) {
+                    printf("/*%4u*/ lookup mismatch for key \"%s\"\n", i, key.c_str());
+                }
+                return 1;
+            }
+            break;
+        }
+    }
+
+    std::vector<std::pair<std::string, uint32_t> > gold_v(gold.cbegin(), gold.cend());
+    std::vector<std::pair<std::string, uint32_t> > comp_v;
+    for (table_t::const_iterator it = comp.cbegin(); it != comp.cend(); ++it) {
+        comp_v.push_back(std::make_pair((*it).first.str(), (*it).second.get()));
+    }
+
+    std::sort(gold_v.begin(), gold_v.end());
+    std::sort(comp_v.begin(), comp_v.end());
+
+    if (gold_v != comp_v || gold.size() != comp.size()) {
+        if (debug) {
+            printf("data mismatch: gold: %u elements vs comp: %u elements\n", unsigned(gold.size()), unsigned(comp.size()));
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+
+
+/* Test the arena: compaction of erased keys, keys that aren't NUL
+ * terminated, and values with destructors.
+ */
+int run_directed_test_0(bool debug = false) {
+
+    hash_containers::string_arena_hash_table<std::string> table;
+
+    if (table.size() || table.capacity() || table.arena_bytes() || table.count("") || table.find("a") != table.end()) {
+        if (debug) {
+            printf("In directed test 0:\nempty table isn't empty\n");
+        }
+        return 1;
+    }
+
+    // Keys are compared by length too, and don't need to be NUL terminated
+    const char buffer[] = "abcabc";
+    table.insert(hash_containers::string_ref(buffer, 3), "abc");
+    table.insert(hash_containers::string_ref(buffer, 6), "abcabc");
+    table[""] = "empty";
+    if (table.size() != 3 || table.arena_bytes() != 9
+     || table["abc"] != "abc" || table[std::string("abcabc")] != "abcabc" || table[""] != "empty"
+     || table.count("ab") || table.insert("abc", "other")) {
+        if (debug) {
+            printf("In directed test 0:\nlookup failed\n");
+        }
+        return 1;
+    }
+
+    // Erased keys stay in the arena until it grows
+    table.erase("abcabc");
+    if (table.size() != 2 || table.arena_bytes() != 9 || table.count("abcabc")) {
+        if (debug) {
+            printf("In directed test 0:\nerase failed\n");
+        }
+        return 1;
+    }
+
+    for (unsigned i = 0; i < 1000; i++) {
+        table[std::to_string(i)] = std::to_string(i);
+        table.erase(std::to_string(i));
+    }
+    if (table.size() != 2 || table.arena_bytes() > 256 || table["abc"] != "abc" || table[""] != "empty") {
+        if (debug) {
+            printf("In directed test 0:\narena wasn't compacted: %u bytes\n", unsigned(table.arena_bytes()));
+        }
+        return 1;
+    }
+
+    // Reserving avoids reallocations
+    table.reserve(1000, 4000);
+    const size_t capacity = table.capacity();
+    for (unsigned i = 0; i < 1000; i++) {
+        table[std::to_string(i)] = std::to_string(i);
+    }
+    if (table.capacity() != capacity || table.size() != 1002) {
+        if (debug) {
+            printf("In directed test 0:\nreserve failed\n");
+        }
+        return 1;
+    }
+
+    table.clear();
+    if (table.size() || table.arena_bytes() || table.begin() != table.end() || table.count("abc")) {
+        if (debug) {
+            printf("In directed test 0:\nclear failed\n");
+        }
+        return 1;
+    }
+    table["abc"] = "abc";
+
+    return 0;
+}
+
+
+
+/* Test empty keys in a table without an arena, and with a NULL pointer */
+int run_directed_test_1(bool debug = false) {
+
+    hash_containers::string_arena_hash_table<std::string> table;
+    const hash_containers::string_ref null_key(NULL, 0);
+
+    table[null_key] = "empty";
+    if (table.size() != 1 || table.arena_bytes() || !table.count("") || table[""] != "empty"
+     || table.find(null_key) == table.end() || (*table.begin()).first.size()) {
+        if (debug) {
+            printf("In directed test 1:\nempty key lookup failed\n");
+        }
+        return 1;
+    }
+
+    // The arena is created with an empty key in the table
+    table["abc"] = "abc";
+    if (table.size() != 2 || table.arena_bytes() != 3 || table[null_key] != "empty" || table["abc"] != "abc") {
+        if (debug) {
+            printf("In directed test 1:\narena creation failed\n");
+        }
+        return 1;
+    }
+
+    table.erase(null_key);
+    if (table.count("") || table.size() != 1) {
+        if (debug) {
+            printf("In directed test 1:\nempty key erase failed\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+
+int main() {
+
+#if (defined _DEBUG) && (defined _MSC_VER)
+    _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF /* | _CRTDBG_CHECK_ALWAYS_DF */ );
+    _CrtSetReportMode ( _CRT_ERROR, _CRTDBG_MODE_DEBUG );
+#endif
+
+    /* Directed tests */
+
+    int ret;
+    ret = run_directed_test_0();
+    if (ret) {
+        run_directed_test_0(/*debug*/true);
+        return ret;
+    }
+    ret = run_directed_test_1();
+    if (ret) {
+        run_directed_test_1(/*debug*/true);
+        return ret;
+    }
+
+
+    /* Randoms tests */
+
+    std::mt19937_64 rng(static_cast<uint32_t>(time(NULL)));
+
+#ifdef _DEBUG
+    unsigned max_test =  0x1000;
+#else
+    unsigned max_test = 0x10000;
+#endif
+
+    printf("      ");
+    for (unsigned test_num = 0; test_num < max_test; test_num++) {
+
+        uint64_t rnd = rng();
+
+        int ret = run_test(test_num, rnd);
+        if (ret) {
+            run_test(test_num, rnd, /*debug*/true);
+            return ret;
+        }
+
+        if (!(test_num & 0xff)) {
+            printf("\b\b\b\b\b\b%5.1f%%", test_num / double(max_test) * 100);
+            fflush(stdout);
+        }
+    }
+    printf("\b\b\b\b\b\b100.0%%\n");
+    return 0;
+}